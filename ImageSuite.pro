@@ -2,6 +2,9 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     SuiteCore \
-    SuiteUI
+    SuiteImage \
+    SuiteUI \
+    bench
 
-SuiteUI.depends = SuiteCore
+SuiteUI.depends = SuiteCore SuiteImage
+bench.depends = SuiteCore
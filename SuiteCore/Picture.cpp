@@ -26,11 +26,6 @@ QString Picture::descripcion() const
     return m_descripcion;
 }
 
-QPixmap Picture::imagen() const
-{
-    return m_imagen;
-}
-
 bool Picture::favorito() const
 {
     return m_favorito;
@@ -62,11 +57,6 @@ void Picture::setDescripcion(const QString& descripcion)
     m_descripcion = descripcion;
 }
 
-void Picture::setImagen(const QPixmap& imagen)
-{
-    m_imagen = imagen;
-}
-
 void Picture::setFavorito(bool fav)
 {
     m_favorito = fav;
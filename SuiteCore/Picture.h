@@ -1,10 +1,17 @@
 #ifndef PICTURE_H
 #define PICTURE_H
 
-#include "QtGui/qpixmap.h"
 #include "SuiteCore_global.h"
 #include <QDate>
+#include <QString>
 
+// Identificador compacto de una imagen, asignado por PictureManager al cargarla.
+// Se mantiene estable mientras la URL siga en el catálogo (también entre recargas).
+typedef quint32 PictureId;
+constexpr PictureId InvalidPictureId = 0;
+
+// Metadatos de una imagen (valor barato de copiar entre hilos). Los píxeles no viven
+// aquí sino en ImageStore, indexados por id.
 class SUITECORE_EXPORT Picture
 {
 public:
@@ -12,22 +19,21 @@ public:
     Picture(const QString& nombre, const QString& url, const QString& descripcion);
 
     // Getters
+    PictureId id() const { return m_id; }
     QString nombre() const;
     QString url() const;
     QString descripcion() const;
     QString peso() const { return m_peso.isEmpty() ? "N/A" : m_peso; }
     QString metadatos() const { return m_metadatos.isEmpty() ? "Sin datos" : m_metadatos; }
 
-    QPixmap imagen() const;
-
     bool favorito() const;
     bool descargada() const;
 
     // Setters
+    void setId(PictureId id) { m_id = id; }
     void setNombre(const QString& nombre);
     void setUrl(const QString& url);
     void setDescripcion(const QString& descripcion);
-    void setImagen(const QPixmap& imagen);
     void setFavorito(bool fav);
     void setDescargada(bool descargada);
     void setFilePath(const QString& path) { m_filePath = path; }
@@ -36,13 +42,15 @@ public:
     QString filePath() const { return m_filePath; }
     QDate expirationDate() const;
 
-    bool isExpired() const { return m_expirationDate.isValid() && QDate::currentDate() > m_expirationDate; }
+    // Caducada respecto a 'today' (el llamador obtiene la fecha una vez, no por imagen).
+    // En PictureManager la caducidad ya está precalculada: ver PictureManager::isExpired().
+    bool isExpired(const QDate& today) const { return m_expirationDate.isValid() && today > m_expirationDate; }
 
 private:
+    PictureId m_id = InvalidPictureId;
     QString m_nombre;
     QString m_url;
     QString m_descripcion;
-    QPixmap m_imagen;
     QString m_filePath;
     QString m_peso;
     QString m_metadatos;
@@ -1,4 +1,7 @@
-QT += gui
+# Solo QtCore (y QtNetwork, sin GUI): la decodificación de imágenes está en el módulo
+# opcional SuiteImage
+QT -= gui
+QT += concurrent network sql
 
 TEMPLATE = lib
 DEFINES += SUITECORE_LIBRARY
@@ -11,14 +14,56 @@ CONFIG += c++17
 
 SOURCES += \
     Picture.cpp \
+    catalogparser.cpp \
+    catalogreader.cpp \
+    catalogsnapshot.cpp \
+    compresseddevice.cpp \
+    downloadengine.cpp \
+    downloadscheduler.cpp \
+    downloadstats.cpp \
+    expirationscheduler.cpp \
+    persistencewriter.cpp \
+    partialdownload.cpp \
     picturedao.cpp \
-    picturemanager.cpp
+    picturemanager.cpp \
+    pictureserializer.cpp \
+    picturestore.cpp \
+    sqlitepicturedao.cpp \
+    statejournal.cpp
 
 HEADERS += \
     SuiteCore_global.h \
     Picture.h \
+    catalogparser.h \
+    catalogreader.h \
+    catalogsnapshot.h \
+    chunkedcolumn.h \
+    compresseddevice.h \
+    concurrentidset.h \
+    downloadengine.h \
+    downloadscheduler.h \
+    downloadstats.h \
+    expirationscheduler.h \
+    persistencewriter.h \
+    partialdownload.h \
     picturedao.h \
-    picturemanager.h
+    picturemanager.h \
+    pictureschema.h \
+    pictureserializer.h \
+    picturestore.h \
+    rowindex.h \
+    sqlitepicturedao.h \
+    statejournal.h
+
+# Catálogos comprimidos (gzip/zlib) en streaming
+win32-msvc*: LIBS += zlib.lib
+else: LIBS += -lz
+
+# Índice estructural de CatalogParser con AVX2 (por defecto SSE2): qmake CONFIG+=avx2
+avx2 {
+    gcc|clang: QMAKE_CXXFLAGS += -mavx2
+    msvc: QMAKE_CXXFLAGS += /arch:AVX2
+}
 
 # Default rules for deployment.
 unix {
@@ -0,0 +1,578 @@
+/**
+ * @file catalogparser.cpp
+ * @brief Análisis paralelo de catálogos JSON con índice estructural vectorizado.
+ *
+ * El análisis se hace en dos fases:
+ *
+ * 1. Índice estructural: se recorre el buffer en bloques de 32 (AVX2) o 16 (SSE2) bytes
+ *    comparando a la vez contra comillas, barra invertida, llaves y corchetes. Los
+ *    bloques sin caracteres estructurales (la mayoría: texto de nombres y descripciones)
+ *    se descartan con una sola comparación; en el resto solo se visitan las posiciones
+ *    marcadas para seguir cadenas, escapes y profundidad. El resultado son los límites
+ *    de cada objeto del array de nivel superior. Sin SSE2 se usa la versión escalar.
+ *
+ * 2. Conversión: los objetos se reparten en trozos contiguos que se convierten en
+ *    Picture en el pool global de QtConcurrent, y los resultados se unen en el orden
+ *    del fichero. Cada objeto se lee con un lector de claves planas (sin QJsonObject);
+ *    si un objeto tiene una forma inesperada se recurre a QJsonDocument solo para él.
+ *
+ * Los ficheros comprimidos (gzip/zlib) no pueden proyectarse: se descomprimen en
+ * streaming con InflateDevice y parseStream() va entregando lotes de objetos al pool
+ * mientras sigue leyendo, sin tener nunca el JSON completo en memoria.
+ *
+ * Compilar con CONFIG+=avx2 (ver SuiteCore.pro) activa la variante AVX2.
+ */
+
+#include "catalogparser.h"
+#include "catalogreader.h"
+#include "compresseddevice.h"
+#include "pictureschema.h"
+#include <QByteArray>
+#include <QDebug>
+#include <QFile>
+#include <QFuture>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtAlgorithms>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CATALOGPARSER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CATALOGPARSER_SSE2
+#endif
+
+namespace {
+
+const int MinObjectsPerChunk = 1024;
+
+/**
+ * @brief Máquina de estados que se alimenta solo con posiciones estructurales.
+ *
+ * Los escapes se resuelven recordando la posición escapada por la última barra
+ * invertida: como las barras también son estructurales, las secuencias "\\\\" se
+ * visitan en orden y se emparejan correctamente.
+ */
+struct StructuralState
+{
+    QVector<CatalogParser::Span> spans;
+    int depth = 0;
+    bool inString = false;
+    bool ok = true;
+    qint64 escaped = -1;
+    qint64 start = -1;
+
+    inline void visit(qint64 i, char c)
+    {
+        if (inString) {
+            if (i == escaped) return;
+            if (c == '\\') escaped = i + 1;
+            else if (c == '"') inString = false;
+            return;
+        }
+
+        switch (c) {
+        case '"':
+            inString = true;
+            break;
+        case '{':
+        case '[':
+            if (depth == 0 && c != '[') ok = false;
+            if (depth == 1 && c == '{') start = i;
+            ++depth;
+            break;
+        case '}':
+        case ']':
+            if (--depth == 1 && c == '}' && start >= 0) {
+                spans.append({ start, i + 1 });
+                start = -1;
+            }
+            if (depth < 0) ok = false;
+            break;
+        default:
+            break;
+        }
+    }
+};
+
+inline bool isStructural(char c)
+{
+    return c == '"' || c == '\\' || c == '{' || c == '}' || c == '[' || c == ']';
+}
+
+void scanScalar(const char* data, qint64 from, qint64 size, StructuralState& state)
+{
+    for (qint64 i = from; i < size; ++i) {
+        if (isStructural(data[i])) state.visit(i, data[i]);
+    }
+}
+
+#if defined(CATALOGPARSER_AVX2)
+qint64 scanVector(const char* data, qint64 size, StructuralState& state)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i openBrace = _mm256_set1_epi8('{');
+    const __m256i closeBrace = _mm256_set1_epi8('}');
+    const __m256i openBracket = _mm256_set1_epi8('[');
+    const __m256i closeBracket = _mm256_set1_epi8(']');
+
+    qint64 i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash));
+        m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, openBrace), _mm256_cmpeq_epi8(v, closeBrace)));
+        m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, openBracket), _mm256_cmpeq_epi8(v, closeBracket)));
+
+        quint32 mask = static_cast<quint32>(_mm256_movemask_epi8(m));
+        while (mask) {
+            const int bit = qCountTrailingZeroBits(mask);
+            state.visit(i + bit, data[i + bit]);
+            mask &= mask - 1;
+        }
+    }
+    return i;
+}
+#elif defined(CATALOGPARSER_SSE2)
+qint64 scanVector(const char* data, qint64 size, StructuralState& state)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i openBracket = _mm_set1_epi8('[');
+    const __m128i closeBracket = _mm_set1_epi8(']');
+
+    qint64 i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+        m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, openBrace), _mm_cmpeq_epi8(v, closeBrace)));
+        m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, openBracket), _mm_cmpeq_epi8(v, closeBracket)));
+
+        quint32 mask = static_cast<quint32>(_mm_movemask_epi8(m));
+        while (mask) {
+            const int bit = qCountTrailingZeroBits(mask);
+            state.visit(i + bit, data[i + bit]);
+            mask &= mask - 1;
+        }
+    }
+    return i;
+}
+#else
+qint64 scanVector(const char*, qint64, StructuralState&)
+{
+    return 0;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Lector de objetos planos
+// ---------------------------------------------------------------------------
+
+inline void skipSpaces(const char*& p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p;
+}
+
+inline void appendUtf8(QByteArray& out, uint cp)
+{
+    if (cp < 0x80) {
+        out.append(char(cp));
+    } else if (cp < 0x800) {
+        out.append(char(0xC0 | (cp >> 6)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.append(char(0xE0 | (cp >> 12)));
+        out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    } else {
+        out.append(char(0xF0 | (cp >> 18)));
+        out.append(char(0x80 | ((cp >> 12) & 0x3F)));
+        out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    }
+}
+
+inline bool readHex4(const char* p, const char* end, uint& value)
+{
+    if (end - p < 4) return false;
+    value = 0;
+    for (int k = 0; k < 4; ++k) {
+        const char c = p[k];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= uint(c - '0');
+        else if (c >= 'a' && c <= 'f') value |= uint(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') value |= uint(c - 'A' + 10);
+        else return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Lee una cadena JSON (p apunta a la comilla inicial). Devuelve los bytes UTF-8.
+ *
+ * Si la cadena no tiene escapes se devuelve una vista sin copia ('raw'); si los tiene
+ * se decodifica en 'decoded'.
+ */
+bool readString(const char*& p, const char* end, const char*& raw, int& rawLength,
+                QByteArray& decoded, bool& hasEscapes)
+{
+    ++p; // comilla inicial
+    const char* begin = p;
+    hasEscapes = false;
+    while (p < end && *p != '"') {
+        if (*p == '\\') {
+            hasEscapes = true;
+            break;
+        }
+        ++p;
+    }
+    if (p >= end) return false;
+
+    if (!hasEscapes) {
+        raw = begin;
+        rawLength = static_cast<int>(p - begin);
+        ++p;
+        return true;
+    }
+
+    decoded = QByteArray(begin, static_cast<int>(p - begin));
+    while (p < end && *p != '"') {
+        if (*p != '\\') {
+            decoded.append(*p++);
+            continue;
+        }
+        if (++p >= end) return false;
+        switch (*p) {
+        case '"': decoded.append('"'); break;
+        case '\\': decoded.append('\\'); break;
+        case '/': decoded.append('/'); break;
+        case 'b': decoded.append('\b'); break;
+        case 'f': decoded.append('\f'); break;
+        case 'n': decoded.append('\n'); break;
+        case 'r': decoded.append('\r'); break;
+        case 't': decoded.append('\t'); break;
+        case 'u': {
+            uint cp = 0;
+            if (!readHex4(p + 1, end, cp)) return false;
+            p += 4;
+            // Pares suplentes (caracteres fuera del plano básico)
+            if (cp >= 0xD800 && cp <= 0xDBFF && end - p > 6 && p[1] == '\\' && p[2] == 'u') {
+                uint low = 0;
+                if (readHex4(p + 3, end, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+            }
+            appendUtf8(decoded, cp);
+            break;
+        }
+        default:
+            return false;
+        }
+        ++p;
+    }
+    if (p >= end) return false;
+    ++p;
+    return true;
+}
+
+/**
+ * @brief Salta un valor JSON que no interesa (números, null u objetos anidados).
+ */
+bool skipValue(const char*& p, const char* end)
+{
+    if (p >= end) return false;
+    if (*p == '"') {
+        const char* raw = nullptr;
+        int rawLength = 0;
+        QByteArray decoded;
+        bool hasEscapes = false;
+        return readString(p, end, raw, rawLength, decoded, hasEscapes);
+    }
+    if (*p == '{' || *p == '[') {
+        int depth = 0;
+        bool inString = false;
+        for (; p < end; ++p) {
+            if (inString) {
+                if (*p == '\\') ++p;
+                else if (*p == '"') inString = false;
+            } else if (*p == '"') {
+                inString = true;
+            } else if (*p == '{' || *p == '[') {
+                ++depth;
+            } else if ((*p == '}' || *p == ']') && --depth == 0) {
+                ++p;
+                return true;
+            }
+        }
+        return false;
+    }
+    while (p < end && *p != ',' && *p != '}') ++p;
+    return p < end;
+}
+
+inline unsigned schemaScope(CatalogParser::Fields fields)
+{
+    return fields == CatalogParser::AllFields ? PictureSchema::State : PictureSchema::Catalog;
+}
+
+/**
+ * @brief Convierte un objeto plano en Picture sin construir QJsonObject.
+ *
+ * Las claves se resuelven contra la tabla de PictureSchema (comparación de bytes,
+ * sin hash), por lo que los campos leídos son los mismos que escribe PictureDAO.
+ *
+ * @return false si el objeto tiene una forma que este lector no contempla.
+ */
+bool parseFlatObject(const char* p, const char* end, CatalogParser::Fields fields, Picture& pic)
+{
+    const unsigned scope = schemaScope(fields);
+    pic = Picture();
+
+    skipSpaces(p, end);
+    if (p >= end || *p != '{') return false;
+    ++p;
+
+    for (;;) {
+        skipSpaces(p, end);
+        if (p >= end) return false;
+        if (*p == '}') break;
+        if (*p == ',') { ++p; continue; }
+        if (*p != '"') return false;
+
+        const char* key = nullptr;
+        int keyLength = 0;
+        QByteArray decodedKey;
+        bool keyEscaped = false;
+        if (!readString(p, end, key, keyLength, decodedKey, keyEscaped) || keyEscaped)
+            return false;
+
+        skipSpaces(p, end);
+        if (p >= end || *p != ':') return false;
+        ++p;
+        skipSpaces(p, end);
+        if (p >= end) return false;
+
+        if (*p == '"') {
+            const char* raw = nullptr;
+            int rawLength = 0;
+            QByteArray decoded;
+            bool hasEscapes = false;
+            if (!readString(p, end, raw, rawLength, decoded, hasEscapes)) return false;
+            const QString value = hasEscapes ? QString::fromUtf8(decoded)
+                                             : QString::fromUtf8(raw, rawLength);
+            PictureSchema::setFromJson(pic, key, keyLength, value, scope);
+        } else if (end - p >= 4 && std::memcmp(p, "true", 4) == 0) {
+            p += 4;
+            PictureSchema::setFromJson(pic, key, keyLength, true, scope);
+        } else if (end - p >= 5 && std::memcmp(p, "false", 5) == 0) {
+            p += 5;
+            PictureSchema::setFromJson(pic, key, keyLength, false, scope);
+        } else if (!skipValue(p, end)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Vía lenta para objetos que el lector plano no acepta.
+ */
+bool parseWithQt(const char* p, const char* end, CatalogParser::Fields fields, Picture& pic)
+{
+    const QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromRawData(p, static_cast<int>(end - p)));
+    if (!doc.isObject()) return false;
+
+    pic = PictureSchema::fromJson(doc.object(), schemaScope(fields));
+    return true;
+}
+
+struct ChunkResult {
+    QList<Picture> pictures;
+    bool ok = true;
+};
+
+ChunkResult parseChunk(const char* data, const QVector<CatalogParser::Span>& spans,
+                       int first, int last, CatalogParser::Fields fields)
+{
+    ChunkResult result;
+    result.pictures.reserve(last - first);
+    Picture pic;
+    for (int i = first; i < last; ++i) {
+        const char* begin = data + spans.at(i).begin;
+        const char* end = data + spans.at(i).end;
+        if (!parseFlatObject(begin, end, fields, pic) && !parseWithQt(begin, end, fields, pic)) {
+            result.ok = false;
+            break;
+        }
+        result.pictures.append(pic);
+    }
+    return result;
+}
+
+} // namespace
+
+const char* CatalogParser::simdLevel()
+{
+#if defined(CATALOGPARSER_AVX2)
+    return "avx2";
+#elif defined(CATALOGPARSER_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+/**
+ * @brief Índice estructural: límites de cada objeto del array de nivel superior.
+ * @param data Buffer con el JSON completo.
+ * @param size Tamaño del buffer.
+ * @param ok false si el documento no es un array o está desequilibrado.
+ */
+QVector<CatalogParser::Span> CatalogParser::objectSpans(const char* data, qint64 size, bool* ok)
+{
+    StructuralState state;
+    const qint64 done = scanVector(data, size, state);
+    scanScalar(data, done, size, state);
+
+    const bool valid = state.ok && state.depth == 0 && !state.inString;
+    if (ok) *ok = valid;
+    if (!valid) state.spans.clear();
+    return state.spans;
+}
+
+/**
+ * @brief Analiza un array JSON de Picture repartiendo los objetos entre hilos.
+ *
+ * Con pocos objetos se analiza en el hilo actual; con muchos se crean varios trozos
+ * por hilo del pool para equilibrar la carga. El resultado respeta el orden del fichero.
+ *
+ * @param data Buffer (debe seguir válido hasta que la función retorne).
+ * @param size Tamaño del buffer.
+ * @param fields Campos a leer.
+ * @param ok false si el JSON es inválido (se devuelve una lista vacía).
+ */
+QList<Picture> CatalogParser::parse(const char* data, qint64 size, Fields fields, bool* ok)
+{
+    bool spansOk = false;
+    const QVector<Span> spans = objectSpans(data, size, &spansOk);
+    if (ok) *ok = spansOk;
+    if (!spansOk) return QList<Picture>();
+
+    const int count = spans.size();
+    const int threads = qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+    const int perChunk = qMax(MinObjectsPerChunk, (count + threads * 4 - 1) / (threads * 4));
+
+    QVector<QFuture<ChunkResult>> futures;
+    for (int first = 0; first < count; first += perChunk) {
+        const int last = qMin(count, first + perChunk);
+        futures.append(QtConcurrent::run([data, &spans, first, last, fields]() {
+            return parseChunk(data, spans, first, last, fields);
+        }));
+    }
+
+    QList<Picture> list;
+    list.reserve(count);
+    bool allOk = true;
+    for (QFuture<ChunkResult>& future : futures) {
+        const ChunkResult chunk = future.result();
+        allOk = allOk && chunk.ok;
+        if (allOk) list.append(chunk.pictures);
+    }
+
+    if (ok) *ok = allOk;
+    return allOk ? list : QList<Picture>();
+}
+
+/**
+ * @brief Analiza un fichero proyectándolo en memoria (o leyéndolo si no se puede proyectar).
+ *
+ * Si los bytes mágicos indican gzip o zlib, se lee a través de InflateDevice.
+ */
+QList<Picture> CatalogParser::parseFile(const QString& filepath, Fields fields, bool* ok)
+{
+    if (ok) *ok = false;
+
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "No se pudo abrir el JSON:" << filepath;
+        return QList<Picture>();
+    }
+
+    const qint64 size = file.size();
+    if (size == 0) return QList<Picture>();
+
+    QList<Picture> list;
+    bool parsed = false;
+    if (InflateDevice::isCompressed(&file)) {
+        InflateDevice inflater(&file);
+        if (inflater.open(QIODevice::ReadOnly))
+            list = parseStream(&inflater, fields, &parsed);
+    } else if (uchar* map = file.map(0, size)) {
+        list = parse(reinterpret_cast<const char*>(map), size, fields, &parsed);
+        file.unmap(map);
+    } else {
+        const QByteArray data = file.readAll();
+        list = parse(data.constData(), data.size(), fields, &parsed);
+    }
+
+    if (!parsed) qWarning() << "JSON invalido:" << filepath;
+    if (ok) *ok = parsed;
+    return list;
+}
+
+/**
+ * @brief Analiza un array JSON leído secuencialmente de un dispositivo.
+ *
+ * CatalogReader delimita los objetos bloque a bloque; cada lote de objetos se copia a
+ * un buffer propio y se analiza en el pool mientras se sigue leyendo el dispositivo.
+ * La memoria usada es la de los lotes en vuelo, no la del JSON completo.
+ *
+ * @param device Dispositivo abierto para lectura.
+ * @param fields Campos a leer.
+ * @param ok false si el JSON es inválido (se devuelve una lista vacía).
+ */
+QList<Picture> CatalogParser::parseStream(QIODevice* device, Fields fields, bool* ok)
+{
+    const int batchSize = MinObjectsPerChunk * 4;
+
+    QVector<QFuture<ChunkResult>> futures;
+    QByteArray batch;
+    QVector<Span> spans;
+    spans.reserve(batchSize);
+
+    auto dispatch = [&]() {
+        if (spans.isEmpty()) return;
+        futures.append(QtConcurrent::run([batch, spans, fields]() {
+            return parseChunk(batch.constData(), spans, 0, spans.size(), fields);
+        }));
+        batch.clear();
+        spans.clear();
+    };
+
+    CatalogReader reader(device);
+    QByteArray raw;
+    while (reader.readNextRaw(raw)) {
+        spans.append({batch.size(), batch.size() + raw.size()});
+        batch.append(raw);
+        if (spans.size() >= batchSize) dispatch();
+    }
+    dispatch();
+
+    QList<Picture> list;
+    bool allOk = !reader.hasError();
+    for (QFuture<ChunkResult>& future : futures) {
+        const ChunkResult chunk = future.result();
+        allOk = allOk && chunk.ok;
+        if (allOk) list.append(chunk.pictures);
+    }
+
+    if (ok) *ok = allOk;
+    return allOk ? list : QList<Picture>();
+}
@@ -0,0 +1,39 @@
+#ifndef CATALOGPARSER_H
+#define CATALOGPARSER_H
+
+#include "Picture.h"
+#include "SuiteCore_global.h"
+#include <QList>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+// Analizador paralelo de arrays JSON de Picture: una pasada vectorizada (SSE2/AVX2)
+// localiza los objetos del array y los trozos se convierten en un pool de hilos.
+class SUITECORE_EXPORT CatalogParser
+{
+public:
+    enum Fields {
+        CatalogFields,  // nombre, url y descripcion
+        AllFields       // además flags, filePath y expirationDate
+    };
+
+    struct Span {
+        qint64 begin;
+        qint64 end;
+    };
+
+    // Límites [begin, end) de cada objeto del array de nivel superior
+    static QVector<Span> objectSpans(const char* data, qint64 size, bool* ok = nullptr);
+
+    static QList<Picture> parse(const char* data, qint64 size, Fields fields, bool* ok = nullptr);
+    static QList<Picture> parseFile(const QString& filepath, Fields fields, bool* ok = nullptr);
+    // Lectura secuencial por bloques (p. ej. un InflateDevice) sin cargar todo el JSON
+    static QList<Picture> parseStream(QIODevice* device, Fields fields, bool* ok = nullptr);
+
+    // Nombre de la implementación del índice estructural ("avx2", "sse2" o "scalar")
+    static const char* simdLevel();
+};
+
+#endif // CATALOGPARSER_H
@@ -0,0 +1,202 @@
+/**
+ * @file catalogreader.cpp
+ * @brief Lectura incremental (streaming) de catálogos JSON.
+ *
+ * CatalogReader tokeniza el array de nivel superior de un fichero como download.json
+ * leyendo bloques de tamaño fijo del QIODevice. Solo se conserva en memoria el bloque
+ * actual y el objeto que se está delimitando, de modo que el consumo de memoria no
+ * depende del tamaño del catálogo sino del tamaño del objeto más grande.
+ *
+ * Cada objeto delimitado se convierte con QJsonDocument (documento pequeño) y se
+ * entrega al llamador, que puede ir creando los Picture a medida que se leen.
+ * readNextRaw() entrega los bytes sin convertir, para repartir el análisis entre hilos.
+ */
+
+#include "catalogreader.h"
+#include "pictureschema.h"
+#include <QIODevice>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <cctype>
+
+/**
+ * @brief Constructor.
+ * @param device Dispositivo ya abierto en modo lectura (no se toma la propiedad).
+ * @param chunkSize Tamaño de cada bloque leído del dispositivo.
+ */
+CatalogReader::CatalogReader(QIODevice* device, int chunkSize)
+    : m_device(device),
+    m_chunkSize(qMax(chunkSize, 4096))
+{
+    if (m_device && !m_device->isSequential())
+        m_totalBytes = m_device->size();
+}
+
+/**
+ * @brief Porcentaje de lectura (0-100). Si el tamaño total no se conoce devuelve 0.
+ */
+int CatalogReader::progress() const
+{
+    if (m_state == Finished) return 100;
+    if (m_totalBytes <= 0) return 0;
+    return static_cast<int>((m_bytesRead * 100) / m_totalBytes);
+}
+
+/**
+ * @brief Lee el siguiente objeto del array de nivel superior.
+ *
+ * @param object Objeto de salida.
+ * @return true si se ha leído un objeto; false al terminar el array o ante un error.
+ */
+bool CatalogReader::readNext(QJsonObject& object)
+{
+    QByteArray raw;
+    if (!readNextRaw(raw)) return false;
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(raw, &parseError);
+    if (!doc.isObject()) {
+        fail(parseError.errorString());
+        return false;
+    }
+    object = doc.object();
+    return true;
+}
+
+/**
+ * @brief Delimita el siguiente objeto del array de nivel superior y copia sus bytes.
+ *
+ * El escaneo respeta cadenas y secuencias de escape, por lo que llaves o corchetes
+ * dentro de textos no alteran la profundidad. El estado del escaneo se mantiene entre
+ * recargas del buffer, así que un objeto puede repartirse entre varios bloques.
+ *
+ * @param raw Texto JSON del objeto, desde '{' hasta '}'.
+ * @return true si se ha delimitado un objeto; false al terminar el array o ante un error.
+ */
+bool CatalogReader::readNextRaw(QByteArray& raw)
+{
+    if (!m_device || m_state == Finished || m_state == Failed) return false;
+
+    for (;;) {
+        if (m_pos >= m_buffer.size()) {
+            if (!fill()) {
+                fail(QStringLiteral("Fin inesperado del catálogo JSON"));
+                return false;
+            }
+            continue;
+        }
+
+        const char* data = m_buffer.constData();
+        const int size = m_buffer.size();
+        const char c = data[m_pos];
+
+        switch (m_state) {
+        case BeforeArray:
+            if (c == '[') {
+                m_state = InArray;
+            } else if (!isspace(static_cast<unsigned char>(c))) {
+                fail(QStringLiteral("El catálogo no es un array JSON"));
+                return false;
+            }
+            ++m_pos;
+            break;
+
+        case InArray:
+            if (c == ']') {
+                ++m_pos;
+                m_state = Finished;
+                return false;
+            }
+            if (c == '{') {
+                m_objectStart = m_pos;
+                m_depth = 0;
+                m_inString = false;
+                m_escape = false;
+                m_state = InObject;
+                break; // el '{' se contabiliza en InObject
+            }
+            if (c != ',' && !isspace(static_cast<unsigned char>(c))) {
+                fail(QStringLiteral("Elemento inesperado en el catálogo"));
+                return false;
+            }
+            ++m_pos;
+            break;
+
+        case InObject: {
+            // Bucle interno sobre el buffer sin pasar por el switch en cada byte
+            int i = m_pos;
+            for (; i < size; ++i) {
+                const char ch = data[i];
+                if (m_inString) {
+                    if (m_escape) m_escape = false;
+                    else if (ch == '\\') m_escape = true;
+                    else if (ch == '"') m_inString = false;
+                } else if (ch == '"') {
+                    m_inString = true;
+                } else if (ch == '{' || ch == '[') {
+                    ++m_depth;
+                } else if (ch == '}' || ch == ']') {
+                    if (--m_depth == 0) break;
+                }
+            }
+            if (i >= size) {
+                m_pos = size;
+                break; // falta el resto del objeto: recargar
+            }
+
+            m_pos = i + 1;
+            m_state = InArray;
+
+            raw = QByteArray(data + m_objectStart, m_pos - m_objectStart);
+            ++m_count;
+            return true;
+        }
+
+        case Finished:
+        case Failed:
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Lee el siguiente registro de catálogo como Picture (nombre, url y descripcion).
+ * @param picture Picture de salida.
+ * @return true si se ha leído un registro.
+ */
+bool CatalogReader::readNext(Picture& picture)
+{
+    QJsonObject obj;
+    if (!readNext(obj)) return false;
+
+    picture = PictureSchema::fromJson(obj, PictureSchema::Catalog);
+    return true;
+}
+
+/**
+ * @brief Descarta lo ya consumido del buffer y añade el siguiente bloque del dispositivo.
+ * @return false si el dispositivo no tiene más datos.
+ */
+bool CatalogReader::fill()
+{
+    const int discard = (m_state == InObject) ? m_objectStart : m_pos;
+    if (discard > 0) {
+        m_buffer.remove(0, discard);
+        m_pos -= discard;
+        if (m_state == InObject) m_objectStart = 0;
+    }
+
+    const QByteArray chunk = m_device->read(m_chunkSize);
+    if (chunk.isEmpty()) return false;
+
+    m_bytesRead += chunk.size();
+    m_buffer.append(chunk);
+    return true;
+}
+
+void CatalogReader::fail(const QString& message)
+{
+    m_state = Failed;
+    m_error = message;
+    m_buffer.clear();
+}
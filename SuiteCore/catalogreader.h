@@ -0,0 +1,56 @@
+#ifndef CATALOGREADER_H
+#define CATALOGREADER_H
+
+#include "Picture.h"
+#include "SuiteCore_global.h"
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+
+class QIODevice;
+
+// Lector incremental de catálogos JSON: recorre el array de nivel superior
+// y entrega los objetos uno a uno sin construir el documento completo.
+class SUITECORE_EXPORT CatalogReader
+{
+public:
+    explicit CatalogReader(QIODevice* device, int chunkSize = 64 * 1024);
+
+    // Lee el siguiente objeto del array; false al llegar al final o si hay error
+    bool readNext(QJsonObject& object);
+    bool readNext(Picture& picture);
+    // Bytes del siguiente objeto sin convertir (para analizarlos en otro hilo)
+    bool readNextRaw(QByteArray& raw);
+
+    bool atEnd() const { return m_state == Finished; }
+    bool hasError() const { return m_state == Failed; }
+    QString errorString() const { return m_error; }
+
+    // Progreso de lectura sobre el dispositivo
+    qint64 bytesRead() const { return m_bytesRead; }
+    qint64 totalBytes() const { return m_totalBytes; }
+    int progress() const;
+    int count() const { return m_count; }
+
+private:
+    enum State { BeforeArray, InArray, InObject, Finished, Failed };
+
+    bool fill();
+    void fail(const QString& message);
+
+    QIODevice* m_device;
+    int m_chunkSize;
+    QByteArray m_buffer;
+    int m_pos = 0;
+    int m_objectStart = 0;
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escape = false;
+    State m_state = BeforeArray;
+    QString m_error;
+    qint64 m_bytesRead = 0;
+    qint64 m_totalBytes = 0;
+    int m_count = 0;
+};
+
+#endif // CATALOGREADER_H
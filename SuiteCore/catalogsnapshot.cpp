@@ -0,0 +1,284 @@
+/**
+ * @file catalogsnapshot.cpp
+ * @brief Instantánea binaria del catálogo para arranques rápidos.
+ *
+ * Tras una carga correcta desde JSON, PictureManager vuelca la lista de Picture a un
+ * fichero binario compacto junto a download.json. En el siguiente arranque el fichero
+ * se proyecta en memoria (QFile::map) y los Picture se construyen directamente desde
+ * los registros, sin ningún análisis JSON.
+ *
+ * Formato (endianness nativa; la instantánea es una caché local):
+ * - cabecera fija (FileHeader),
+ * - una huella por fichero de origen (SourceEntry): tamaño, mtime y hash SHA-1,
+ * - registros de tamaño fijo (Record) que referencian cadenas por desplazamiento,
+ * - tabla de cadenas UTF-16 con las cadenas repetidas almacenadas una sola vez.
+ *
+ * El hash de contenido se calcula sobre el tamaño y los primeros y últimos 64 KiB del
+ * fichero, para que validar la instantánea no obligue a leer un catálogo de cientos de MB.
+ */
+
+#include "catalogsnapshot.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QVector>
+#include <cstring>
+
+namespace {
+
+const quint32 SnapshotMagic = 0x50534E49; // "INSP"
+const quint32 SnapshotVersion = 1;
+const qint64 HashSampleSize = 64 * 1024;
+const int HashLength = 20; // SHA-1
+
+struct StringRef {
+    quint32 offset;  // en QChar dentro de la tabla de cadenas
+    quint32 length;
+};
+
+struct FileHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 sourceCount;
+    quint32 recordCount;
+    StringRef basePath;
+    quint64 stringsSize; // en QChar
+};
+
+struct SourceEntry {
+    qint64 size;
+    qint64 mtime;
+    char hash[HashLength];
+    char reserved[4];
+};
+
+struct Record {
+    StringRef nombre;
+    StringRef url;
+    StringRef descripcion;
+    StringRef filePath;
+    qint64 expirationDay; // QDate::toJulianDay()
+    quint32 flags;
+    quint32 reserved;
+};
+
+enum RecordFlag : quint32 {
+    FlagFavorito = 0x1,
+    FlagDescargada = 0x2
+};
+
+/**
+ * @brief Tabla de cadenas con deduplicación (descripciones y prefijos se repiten mucho).
+ */
+class StringTable
+{
+public:
+    StringRef add(const QString& text) {
+        auto it = m_index.constFind(text);
+        if (it != m_index.constEnd()) return it.value();
+
+        StringRef ref{ static_cast<quint32>(m_data.size()), static_cast<quint32>(text.size()) };
+        m_data.append(text);
+        m_index.insert(text, ref);
+        return ref;
+    }
+
+    const QString& data() const { return m_data; }
+
+private:
+    QString m_data;
+    QHash<QString, StringRef> m_index;
+};
+
+} // namespace
+
+/**
+ * @brief Calcula la huella de un fichero de origen.
+ *
+ * Si el fichero no existe se devuelve size == -1, de modo que la ausencia del
+ * fichero también forma parte de la validación.
+ */
+CatalogSnapshot::SourceStamp CatalogSnapshot::SourceStamp::of(const QString& filepath)
+{
+    SourceStamp stamp;
+    QFileInfo info(filepath);
+    if (!info.exists()) return stamp;
+
+    stamp.size = info.size();
+    stamp.mtime = info.lastModified().toMSecsSinceEpoch();
+
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly)) return stamp;
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(reinterpret_cast<const char*>(&stamp.size), sizeof(stamp.size));
+    hash.addData(file.read(HashSampleSize));
+    if (stamp.size > HashSampleSize) {
+        file.seek(qMax(HashSampleSize, stamp.size - HashSampleSize));
+        hash.addData(file.read(HashSampleSize));
+    }
+    stamp.hash = hash.result();
+    return stamp;
+}
+
+bool CatalogSnapshot::SourceStamp::operator==(const SourceStamp& other) const
+{
+    return size == other.size && mtime == other.mtime && hash == other.hash;
+}
+
+/**
+ * @brief Ruta de la instantánea asociada a un catálogo (mismo directorio, extensión .snapshot).
+ */
+QString CatalogSnapshot::pathFor(const QString& catalogPath)
+{
+    QFileInfo info(catalogPath);
+    return info.absolutePath() + "/" + info.completeBaseName() + ".snapshot";
+}
+
+/**
+ * @brief Escribe la instantánea de forma atómica (QSaveFile).
+ *
+ * @param snapshotPath Fichero destino.
+ * @param pictures Lista completa de Picture (catálogo + estado).
+ * @param sources Ficheros JSON de los que procede la lista (se guardan sus huellas).
+ * @param basePath Ruta base usada para resolver las URLs; si cambia, la instantánea no vale.
+ * @return true si se escribió correctamente.
+ */
+bool CatalogSnapshot::write(const QString& snapshotPath, const QList<Picture>& pictures,
+                            const QStringList& sources, const QString& basePath)
+{
+    StringTable strings;
+    QVector<Record> records;
+    records.reserve(pictures.size());
+
+    for (const Picture& pic : pictures) {
+        Record rec;
+        std::memset(&rec, 0, sizeof(rec));
+        rec.nombre = strings.add(pic.nombre());
+        rec.url = strings.add(pic.url());
+        rec.descripcion = strings.add(pic.descripcion());
+        rec.filePath = strings.add(pic.filePath());
+        rec.expirationDay = pic.expirationDate().toJulianDay();
+        rec.flags = (pic.favorito() ? FlagFavorito : 0u) | (pic.descargada() ? FlagDescargada : 0u);
+        records.append(rec);
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = SnapshotMagic;
+    header.version = SnapshotVersion;
+    header.sourceCount = static_cast<quint32>(sources.size());
+    header.recordCount = static_cast<quint32>(records.size());
+    header.basePath = strings.add(basePath);
+    header.stringsSize = static_cast<quint64>(strings.data().size());
+
+    QSaveFile file(snapshotPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "No se pudo escribir la instantanea:" << snapshotPath;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const QString& source : sources) {
+        const SourceStamp stamp = SourceStamp::of(source);
+        SourceEntry entry;
+        std::memset(&entry, 0, sizeof(entry));
+        entry.size = stamp.size;
+        entry.mtime = stamp.mtime;
+        std::memcpy(entry.hash, stamp.hash.constData(), qMin(stamp.hash.size(), HashLength));
+        file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    }
+    file.write(reinterpret_cast<const char*>(records.constData()),
+               static_cast<qint64>(records.size()) * sizeof(Record));
+    file.write(reinterpret_cast<const char*>(strings.data().constData()),
+               static_cast<qint64>(strings.data().size()) * sizeof(QChar));
+
+    return file.commit();
+}
+
+/**
+ * @brief Lee la instantánea proyectándola en memoria.
+ *
+ * Comprueba la cabecera, los límites de cada cadena, la ruta base y las huellas de los
+ * ficheros de origen. Cualquier discrepancia hace que se devuelva false y el llamador
+ * recurra a la carga desde JSON.
+ *
+ * @param snapshotPath Fichero de instantánea.
+ * @param sources Ficheros JSON actuales (en el mismo orden que al escribir).
+ * @param basePath Ruta base actual.
+ * @param pictures Lista de salida (solo se modifica si la lectura es válida).
+ * @return true si la instantánea es válida y se ha cargado.
+ */
+bool CatalogSnapshot::read(const QString& snapshotPath, const QStringList& sources,
+                           const QString& basePath, QList<Picture>& pictures)
+{
+    QFile file(snapshotPath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    const qint64 fileSize = file.size();
+    if (fileSize < static_cast<qint64>(sizeof(FileHeader))) return false;
+
+    uchar* map = file.map(0, fileSize);
+    if (!map) return false;
+
+    FileHeader header;
+    std::memcpy(&header, map, sizeof(header));
+
+    const qint64 sourcesOffset = sizeof(FileHeader);
+    const qint64 recordsOffset = sourcesOffset + static_cast<qint64>(header.sourceCount) * sizeof(SourceEntry);
+    const qint64 stringsOffset = recordsOffset + static_cast<qint64>(header.recordCount) * sizeof(Record);
+    const qint64 expectedSize = stringsOffset + static_cast<qint64>(header.stringsSize) * sizeof(QChar);
+
+    bool valid = header.magic == SnapshotMagic
+                 && header.version == SnapshotVersion
+                 && header.sourceCount == static_cast<quint32>(sources.size())
+                 && expectedSize == fileSize;
+
+    const QChar* strings = reinterpret_cast<const QChar*>(map + stringsOffset);
+    auto stringAt = [&](const StringRef& ref, bool& ok) -> QString {
+        if (static_cast<quint64>(ref.offset) + ref.length > header.stringsSize) {
+            ok = false;
+            return QString();
+        }
+        return QString(strings + ref.offset, static_cast<int>(ref.length));
+    };
+
+    if (valid)
+        valid = stringAt(header.basePath, valid) == basePath && valid;
+
+    // Huellas de los ficheros de origen: basta una diferencia para descartar la instantánea
+    for (int i = 0; valid && i < sources.size(); ++i) {
+        SourceEntry entry;
+        std::memcpy(&entry, map + sourcesOffset + i * sizeof(SourceEntry), sizeof(entry));
+        SourceStamp stored;
+        stored.size = entry.size;
+        stored.mtime = entry.mtime;
+        stored.hash = entry.size >= 0 ? QByteArray(entry.hash, HashLength) : QByteArray();
+        valid = stored == SourceStamp::of(sources.at(i));
+    }
+
+    QList<Picture> list;
+    if (valid) {
+        list.reserve(static_cast<int>(header.recordCount));
+        const Record* records = reinterpret_cast<const Record*>(map + recordsOffset);
+        for (quint32 i = 0; valid && i < header.recordCount; ++i) {
+            const Record& rec = records[i];
+            Picture pic(stringAt(rec.nombre, valid), stringAt(rec.url, valid), stringAt(rec.descripcion, valid));
+            pic.setFilePath(stringAt(rec.filePath, valid));
+            pic.setExpirationDate(QDate::fromJulianDay(rec.expirationDay));
+            pic.setFavorito(rec.flags & FlagFavorito);
+            pic.setDescargada(rec.flags & FlagDescargada);
+            list.append(pic);
+        }
+    }
+
+    file.unmap(map);
+    if (!valid) return false;
+
+    pictures.swap(list);
+    return true;
+}
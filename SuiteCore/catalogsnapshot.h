@@ -0,0 +1,38 @@
+#ifndef CATALOGSNAPSHOT_H
+#define CATALOGSNAPSHOT_H
+
+#include "Picture.h"
+#include "SuiteCore_global.h"
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+// Instantánea binaria del catálogo ya fusionado con el estado de descargadas.
+// Se valida contra los JSON de origen (tamaño, fecha de modificación y hash).
+class SUITECORE_EXPORT CatalogSnapshot
+{
+public:
+    // Huella de un fichero de origen
+    struct SourceStamp {
+        qint64 size = -1;
+        qint64 mtime = 0;
+        QByteArray hash;
+
+        static SourceStamp of(const QString& filepath);
+        bool operator==(const SourceStamp& other) const;
+        bool operator!=(const SourceStamp& other) const { return !(*this == other); }
+    };
+
+    // Ruta de la instantánea junto al catálogo (download.json -> download.snapshot)
+    static QString pathFor(const QString& catalogPath);
+
+    static bool write(const QString& snapshotPath, const QList<Picture>& pictures,
+                      const QStringList& sources, const QString& basePath);
+
+    // Devuelve false si la instantánea no existe, está corrupta o es obsoleta
+    static bool read(const QString& snapshotPath, const QStringList& sources,
+                     const QString& basePath, QList<Picture>& pictures);
+};
+
+#endif // CATALOGSNAPSHOT_H
@@ -0,0 +1,47 @@
+#ifndef CHUNKEDCOLUMN_H
+#define CHUNKEDCOLUMN_H
+
+#include <QVector>
+
+// Columna de PictureStore troceada en bloques de ChunkSize elementos. Cada bloque es un
+// QVector compartido de forma implícita: copiar la columna solo copia la tabla de
+// bloques (N / ChunkSize punteros) y escribir un elemento duplica únicamente su bloque.
+// Así, una escritura puntual sobre una versión recién copiada cuesta O(ChunkSize), no O(N).
+template <typename T>
+class ChunkedColumn
+{
+public:
+    static constexpr int ChunkShift = 12;
+    static constexpr int ChunkSize = 1 << ChunkShift; // 4096 elementos
+    static constexpr int ChunkMask = ChunkSize - 1;
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    const T& at(int i) const { return m_chunks.at(i >> ChunkShift).at(i & ChunkMask); }
+    T& operator[](int i) { return m_chunks[i >> ChunkShift][i & ChunkMask]; }
+
+    void append(const T& value)
+    {
+        if ((m_size & ChunkMask) == 0) {
+            m_chunks.append(QVector<T>());
+            m_chunks.last().reserve(ChunkSize);
+        }
+        m_chunks.last().append(value);
+        ++m_size;
+    }
+
+    void reserve(int count) { m_chunks.reserve((count + ChunkMask) >> ChunkShift); }
+
+    void clear()
+    {
+        m_chunks.clear();
+        m_size = 0;
+    }
+
+private:
+    QVector<QVector<T>> m_chunks;
+    int m_size = 0;
+};
+
+#endif // CHUNKEDCOLUMN_H
@@ -0,0 +1,260 @@
+/**
+ * @file compresseddevice.cpp
+ * @brief Compresión y descompresión en streaming (zlib/gzip) sobre QIODevice.
+ *
+ * Los catálogos son JSON muy repetitivo y comprimen más de 10x, así que leerlos
+ * comprimidos reduce mucho la E/S en directorios de red. InflateDevice se coloca
+ * delante del QFile y entrega el JSON descomprimido bloque a bloque: quien lee
+ * (CatalogReader, CatalogParser) solo ve un dispositivo secuencial normal.
+ *
+ * inflateInit2 con windowBits 15 + 32 acepta tanto gzip como zlib; el formato se
+ * decide por los bytes mágicos y no por la extensión del fichero. DeflateDevice
+ * escribe siempre gzip (compatible con gzip/zcat).
+ */
+
+#include "compresseddevice.h"
+#include <QFile>
+#include <zlib.h>
+
+namespace {
+const int BufferSize = 64 * 1024;
+}
+
+/**
+ * @brief Constructor.
+ * @param source Dispositivo comprimido ya abierto para lectura (no se toma la propiedad).
+ * @param parent Objeto padre.
+ */
+InflateDevice::InflateDevice(QIODevice* source, QObject* parent)
+    : QIODevice(parent),
+    m_source(source)
+{
+}
+
+InflateDevice::~InflateDevice()
+{
+    close();
+}
+
+/**
+ * @brief Indica si el contenido de un dispositivo está comprimido con gzip o zlib.
+ *
+ * Se usa peek(), de modo que la posición del dispositivo no cambia. Un JSON nunca
+ * empieza por estos bytes ('[', '{' o espacios), así que no hay ambigüedad.
+ */
+bool InflateDevice::isCompressed(QIODevice* device)
+{
+    if (!device) return false;
+
+    const QByteArray magic = device->peek(2);
+    if (magic.size() < 2) return false;
+
+    const uchar b0 = static_cast<uchar>(magic.at(0));
+    const uchar b1 = static_cast<uchar>(magic.at(1));
+    if (b0 == 0x1f && b1 == 0x8b) return true;                        // gzip
+    return (b0 & 0x0f) == Z_DEFLATED && ((b0 << 8) | b1) % 31 == 0;    // zlib
+}
+
+/**
+ * @brief Igual que isCompressed(QIODevice*) sobre un fichero; false si no existe.
+ */
+bool InflateDevice::isCompressed(const QString& filepath)
+{
+    QFile file(filepath);
+    return file.open(QIODevice::ReadOnly) && isCompressed(&file);
+}
+
+bool InflateDevice::open(OpenMode mode)
+{
+    if ((mode & ReadWrite) != ReadOnly || !m_source || !m_source->isReadable()) {
+        setErrorString(QStringLiteral("InflateDevice solo admite lectura"));
+        return false;
+    }
+
+    m_stream = new z_stream();
+    if (inflateInit2(m_stream, 15 + 32) != Z_OK) {
+        delete m_stream;
+        m_stream = nullptr;
+        setErrorString(QStringLiteral("No se pudo inicializar zlib"));
+        return false;
+    }
+
+    m_finished = false;
+    m_input.clear();
+    return QIODevice::open(mode | Unbuffered);
+}
+
+void InflateDevice::close()
+{
+    if (m_stream) {
+        inflateEnd(m_stream);
+        delete m_stream;
+        m_stream = nullptr;
+    }
+    m_input.clear();
+    QIODevice::close();
+}
+
+bool InflateDevice::atEnd() const
+{
+    return m_finished && QIODevice::atEnd();
+}
+
+/**
+ * @brief Descomprime hasta maxSize bytes leyendo del origen bloques de 64 KiB.
+ *
+ * Admite varios miembros gzip concatenados (como produce "cat a.gz b.gz"). Si el
+ * origen se acaba antes del final del flujo se considera un fichero truncado.
+ */
+qint64 InflateDevice::readData(char* data, qint64 maxSize)
+{
+    if (!m_stream || m_finished) return m_finished ? 0 : -1;
+
+    m_stream->next_out = reinterpret_cast<Bytef*>(data);
+    m_stream->avail_out = static_cast<uInt>(qMin<qint64>(maxSize, 0x7fffffff));
+
+    while (m_stream->avail_out > 0) {
+        if (m_stream->avail_in == 0) {
+            m_input = m_source->read(BufferSize);
+            if (m_input.isEmpty()) {
+                setErrorString(QStringLiteral("Fichero comprimido truncado"));
+                break;
+            }
+            m_stream->next_in = reinterpret_cast<Bytef*>(m_input.data());
+            m_stream->avail_in = static_cast<uInt>(m_input.size());
+        }
+
+        const int status = inflate(m_stream, Z_NO_FLUSH);
+        if (status == Z_STREAM_END) {
+            // Otro miembro gzip a continuación: reiniciar conservando la entrada pendiente
+            if (m_stream->avail_in > 0 || !m_source->atEnd()) {
+                inflateReset(m_stream);
+                continue;
+            }
+            m_finished = true;
+            break;
+        }
+        if (status != Z_OK && status != Z_BUF_ERROR) {
+            setErrorString(QString::fromLatin1(m_stream->msg ? m_stream->msg : "zlib error"));
+            break;
+        }
+    }
+
+    const qint64 produced = maxSize - m_stream->avail_out;
+    if (produced == 0 && !m_finished) return -1;
+    return produced;
+}
+
+qint64 InflateDevice::writeData(const char*, qint64)
+{
+    return -1;
+}
+
+/**
+ * @brief Constructor.
+ * @param target Dispositivo de destino ya abierto para escritura (no se toma la propiedad).
+ * @param level Nivel de compresión zlib (1-9).
+ * @param parent Objeto padre.
+ */
+DeflateDevice::DeflateDevice(QIODevice* target, int level, QObject* parent)
+    : QIODevice(parent),
+    m_target(target),
+    m_level(level)
+{
+}
+
+DeflateDevice::~DeflateDevice()
+{
+    close();
+}
+
+bool DeflateDevice::open(OpenMode mode)
+{
+    if ((mode & ReadWrite) != WriteOnly || !m_target || !m_target->isWritable()) {
+        setErrorString(QStringLiteral("DeflateDevice solo admite escritura"));
+        return false;
+    }
+
+    m_stream = new z_stream();
+    // windowBits 15 + 16: cabecera y cola gzip
+    if (deflateInit2(m_stream, m_level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        delete m_stream;
+        m_stream = nullptr;
+        setErrorString(QStringLiteral("No se pudo inicializar zlib"));
+        return false;
+    }
+
+    m_failed = false;
+    return QIODevice::open(mode | Unbuffered);
+}
+
+/**
+ * @brief Escribe el final del flujo gzip y libera zlib.
+ * @return false si alguna escritura en el destino falló.
+ */
+bool DeflateDevice::finish()
+{
+    if (!m_stream) return !m_failed;
+
+    const bool ok = deflateInto(Z_FINISH) && !m_failed;
+    deflateEnd(m_stream);
+    delete m_stream;
+    m_stream = nullptr;
+    m_failed = !ok;
+    return ok;
+}
+
+void DeflateDevice::close()
+{
+    if (isOpen()) finish();
+    QIODevice::close();
+}
+
+qint64 DeflateDevice::readData(char*, qint64)
+{
+    return -1;
+}
+
+qint64 DeflateDevice::writeData(const char* data, qint64 maxSize)
+{
+    if (!m_stream || m_failed) return -1;
+
+    qint64 written = 0;
+    while (written < maxSize) {
+        const uInt chunk = static_cast<uInt>(qMin<qint64>(maxSize - written, 0x7fffffff));
+        m_stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data + written));
+        m_stream->avail_in = chunk;
+        if (!deflateInto(Z_NO_FLUSH)) {
+            m_failed = true;
+            return -1;
+        }
+        written += chunk;
+    }
+    return written;
+}
+
+/**
+ * @brief Comprime la entrada pendiente y vuelca la salida al destino por bloques.
+ */
+bool DeflateDevice::deflateInto(int flush)
+{
+    char out[BufferSize];
+    int status = Z_OK;
+    do {
+        m_stream->next_out = reinterpret_cast<Bytef*>(out);
+        m_stream->avail_out = BufferSize;
+        status = deflate(m_stream, flush);
+        if (status == Z_STREAM_ERROR) {
+            setErrorString(QStringLiteral("Error de compresión zlib"));
+            return false;
+        }
+
+        const qint64 produced = BufferSize - m_stream->avail_out;
+        if (produced > 0 && m_target->write(out, produced) != produced) {
+            setErrorString(m_target->errorString());
+            return false;
+        }
+    } while (m_stream->avail_out == 0 || (flush == Z_FINISH && status != Z_STREAM_END));
+
+    return true;
+}
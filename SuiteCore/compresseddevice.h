@@ -0,0 +1,69 @@
+#ifndef COMPRESSEDDEVICE_H
+#define COMPRESSEDDEVICE_H
+
+#include "SuiteCore_global.h"
+#include <QByteArray>
+#include <QIODevice>
+
+struct z_stream_s;
+
+// Dispositivo de solo lectura que descomprime al vuelo (gzip o zlib, detectado por
+// la cabecera) el contenido de otro dispositivo. Nunca descomprime el fichero entero.
+class SUITECORE_EXPORT InflateDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit InflateDevice(QIODevice* source, QObject* parent = nullptr);
+    ~InflateDevice() override;
+
+    // Comprueba los bytes mágicos (gzip 1f 8b o cabecera zlib) sin consumirlos
+    static bool isCompressed(QIODevice* device);
+    static bool isCompressed(const QString& filepath);
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return true; }
+    bool atEnd() const override;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    QIODevice* m_source;
+    z_stream_s* m_stream = nullptr;
+    QByteArray m_input;
+    bool m_finished = false;
+};
+
+// Dispositivo de solo escritura que comprime en formato gzip hacia otro dispositivo.
+// finish() (o close()) escribe el final del flujo.
+class SUITECORE_EXPORT DeflateDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    explicit DeflateDevice(QIODevice* target, int level = 6, QObject* parent = nullptr);
+    ~DeflateDevice() override;
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return true; }
+
+    bool finish();
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    bool deflateInto(int flush);
+
+    QIODevice* m_target;
+    int m_level;
+    z_stream_s* m_stream = nullptr;
+    bool m_failed = false;
+};
+
+#endif // COMPRESSEDDEVICE_H
@@ -0,0 +1,54 @@
+#ifndef CONCURRENTIDSET_H
+#define CONCURRENTIDSET_H
+
+#include "Picture.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <array>
+
+// Conjunto de PictureId seguro entre hilos, repartido en Stripes fragmentos con su
+// propio mutex (cada uno en su línea de caché): dos hilos solo compiten si sus ids
+// caen en el mismo fragmento. Lo usa PictureManager para las tareas en curso.
+class ConcurrentIdSet
+{
+public:
+    static constexpr int Stripes = 16;
+
+    // false si el id ya estaba (otra tarea lo tiene reservado)
+    bool insert(PictureId id)
+    {
+        Stripe& s = stripe(id);
+        QMutexLocker locker(&s.mutex);
+        if (s.ids.contains(id)) return false;
+        s.ids.insert(id);
+        return true;
+    }
+
+    void remove(PictureId id)
+    {
+        Stripe& s = stripe(id);
+        QMutexLocker locker(&s.mutex);
+        s.ids.remove(id);
+    }
+
+    bool contains(PictureId id) const
+    {
+        const Stripe& s = stripe(id);
+        QMutexLocker locker(&s.mutex);
+        return s.ids.contains(id);
+    }
+
+private:
+    struct alignas(64) Stripe {
+        mutable QMutex mutex;
+        QSet<PictureId> ids;
+    };
+
+    Stripe& stripe(PictureId id) { return m_stripes[id % Stripes]; }
+    const Stripe& stripe(PictureId id) const { return m_stripes[id % Stripes]; }
+
+    std::array<Stripe, Stripes> m_stripes;
+};
+
+#endif // CONCURRENTIDSET_H
@@ -0,0 +1,737 @@
+/**
+ * @file downloadengine.cpp
+ * @brief Descargas asíncronas sobre QNetworkAccessManager.
+ *
+ * DownloadEngine sustituye a la simulación con QThread::msleep: en lugar de un hilo
+ * del pool dormido por cada descarga, un único hilo de red ejecuta un bucle de
+ * eventos con un QNetworkAccessManager que atiende todas las transferencias.
+ *  - http://, https:// y file:// pasan por el mismo camino (QNetworkReply).
+ *  - Cada bloque recibido se escribe en <destino>.part en cuanto llega; el .part solo
+ *    se renombra al destino cuando la transferencia termina sin error.
+ *  - Los rangos ya escritos se anotan en un PartialDownload (<destino>.part.json),
+ *    guardado como mucho cada SidecarIntervalMs, al pausar, al fallar y al cerrar.
+ *    Al volver a pedir la descarga se validan longitud y ETag con HEAD y se piden solo
+ *    los rangos que faltan; si el origen cambió se empieza de cero.
+ *  - El progreso se emite únicamente cuando cambia el porcentaje.
+ *  - DownloadScheduler decide qué transferencia empieza (carriles interactivo y
+ *    masivo, límite de simultáneas, pausas); al terminar o pausarse una, el motor
+ *    le pide la siguiente.
+ *  - Pausar una transferencia en curso la aborta y la devuelve a la cola; al
+ *    reanudarse continúa desde su .part (si el servidor admite Range).
+ *  - DownloadStats mide caudal y tiempos hasta completar de las transferencias reales.
+ *
+ * Descargas segmentadas: para http(s) se pregunta primero el tamaño con HEAD. Si el
+ * servidor acepta Range y el fichero supera SegmentThreshold, el destino se
+ * preasigna con su tamaño final y se piden segmentos de SegmentSize en paralelo; cada
+ * uno se escribe en su posición según llega. QNetworkAccessManager reutiliza sus
+ * conexiones persistentes con el servidor, así que los segmentos no abren conexiones
+ * nuevas. El número de segmentos simultáneos empieza en InitialSegments y se ajusta
+ * con el caudal observado (adaptParallelism()).
+ *
+ * m_transfers se toca solo en el hilo de red; las operaciones públicas se limitan a
+ * encolar el trabajo en ese hilo.
+ */
+
+#include "downloadengine.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+/**
+ * @brief Constructor: crea el hilo de red y su QNetworkAccessManager.
+ * @param parent Objeto padre.
+ */
+DownloadEngine::DownloadEngine(QObject* parent)
+    : QObject(parent),
+    m_network(new QNetworkAccessManager)
+{
+    m_thread.setObjectName("DownloadEngine");
+    m_network->moveToThread(&m_thread);
+    m_thread.start();
+}
+
+/**
+ * @brief Destructor: guarda el estado de lo que quedaba a medias y detiene el hilo de red.
+ *
+ * Los .part se conservan con su estado: al volver a pedir esas descargas (por ejemplo
+ * PictureManager::resumeDownloads() al arrancar) continúan donde se quedaron.
+ *
+ * Las transferencias y m_network pertenecen al hilo de red, así que se cierran en él:
+ * los .part con una llamada bloqueante y m_network (y con él las respuestas, que son
+ * hijas suyas) con deleteLater() al terminar el hilo.
+ */
+DownloadEngine::~DownloadEngine()
+{
+    QMetaObject::invokeMethod(m_network, [this]() {
+        for (Transfer& transfer : m_transfers) {
+            savePart(transfer);
+            delete transfer.file;
+        }
+        m_transfers.clear();
+    }, Qt::BlockingQueuedConnection);
+
+    connect(&m_thread, &QThread::finished, m_network, &QObject::deleteLater);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+/**
+ * @brief Pide la descarga de @p source en @p destination.
+ *
+ * Al terminar se emite finished(id, ok, error); mientras tanto progress(id, percent).
+ * Si ya hay un trabajo con ese id se ignora la petición, salvo para subirle la
+ * prioridad a Interactive.
+ */
+void DownloadEngine::start(PictureId id, const QUrl& source, const QString& destination,
+                           DownloadScheduler::Priority priority)
+{
+    DownloadScheduler::Job job;
+    job.id = id;
+    job.source = source;
+    job.destination = destination;
+    job.priority = priority;
+    QMetaObject::invokeMethod(m_network, [this, job]() { enqueue(job); });
+}
+
+/**
+ * @brief Retiene una descarga: si está en cola no empezará, si está en curso se interrumpe.
+ */
+void DownloadEngine::pause(PictureId id)
+{
+    QMetaObject::invokeMethod(m_network, [this, id]() {
+        if (m_scheduler.hold(id)) {
+            emit held(id, true);
+            emit queueChanged(m_scheduler.queueDepth(), m_scheduler.inFlight());
+        } else if (m_transfers.contains(id)) {
+            interrupt(id, true);
+        }
+    });
+}
+
+/**
+ * @brief Devuelve a la cola una descarga retenida con pause().
+ */
+void DownloadEngine::resume(PictureId id)
+{
+    QMetaObject::invokeMethod(m_network, [this, id]() {
+        if (!m_scheduler.release(id)) return;
+        emit held(id, false);
+        startQueued();
+    });
+}
+
+/**
+ * @brief Cancela una descarga en cola, retenida o en curso (termina con finished(id, false, ...)).
+ */
+void DownloadEngine::cancel(PictureId id)
+{
+    QMetaObject::invokeMethod(m_network, [this, id]() { abort(id); });
+}
+
+/**
+ * @brief Pausa global: no empieza nada nuevo y lo que está en curso vuelve a la cola.
+ */
+void DownloadEngine::pauseAll()
+{
+    QMetaObject::invokeMethod(m_network, [this]() {
+        m_scheduler.setPaused(true);
+        for (PictureId id : m_scheduler.inFlightIds())
+            interrupt(id, false);
+        emit queueChanged(m_scheduler.queueDepth(), m_scheduler.inFlight());
+    });
+}
+
+/**
+ * @brief Quita la pausa global y libera también las descargas retenidas una a una.
+ */
+void DownloadEngine::resumeAll()
+{
+    QMetaObject::invokeMethod(m_network, [this]() {
+        m_scheduler.setPaused(false);
+        for (PictureId id : m_scheduler.releaseAll())
+            emit held(id, false);
+        startQueued();
+    });
+}
+
+/**
+ * @brief Cancela todo: lo pendiente y lo que está en curso.
+ */
+void DownloadEngine::cancelAll()
+{
+    QMetaObject::invokeMethod(m_network, [this]() {
+        // Primero la cola, para que al abortar no empiece la siguiente
+        for (const DownloadScheduler::Job& job : m_scheduler.clear()) {
+            removePart(job.destination);
+            fail(job.id, tr("Cancelled"));
+        }
+        for (PictureId id : m_scheduler.inFlightIds())
+            abort(id);
+        emit queueChanged(m_scheduler.queueDepth(), m_scheduler.inFlight());
+    });
+}
+
+/**
+ * @brief Cancela las descargas de @p ids que siguen en el carril masivo.
+ *
+ * Las que se pidieron (o se subieron) por el carril interactivo no se tocan: cancelar
+ * una descarga masiva no debe llevarse por delante las que el usuario pidió una a una.
+ */
+void DownloadEngine::cancelBulk(const QVector<PictureId>& ids)
+{
+    QMetaObject::invokeMethod(m_network, [this, ids]() {
+        QSet<PictureId> targets;
+        targets.reserve(ids.size());
+        for (PictureId id : ids) targets.insert(id);
+
+        // Primero la cola, para que al abortar no empiece la siguiente
+        for (const DownloadScheduler::Job& job : m_scheduler.clear(DownloadScheduler::Bulk, targets)) {
+            removePart(job.destination);
+            fail(job.id, tr("Cancelled"));
+        }
+        for (PictureId id : m_scheduler.inFlightIds(DownloadScheduler::Bulk)) {
+            if (targets.contains(id)) abort(id);
+        }
+        emit queueChanged(m_scheduler.queueDepth(), m_scheduler.inFlight());
+    });
+}
+
+/**
+ * @brief Cambia el límite de transferencias simultáneas (no interrumpe las que sobran).
+ */
+void DownloadEngine::setMaxInFlight(int max)
+{
+    m_scheduler.setMaxInFlight(max);
+    QMetaObject::invokeMethod(m_network, [this]() { startQueued(); });
+}
+
+/**
+ * @brief Convierte una ubicación del catálogo en URL de origen.
+ *
+ * Las URLs con esquema (http, https, file) se usan tal cual; cualquier otra cosa se
+ * trata como ruta local.
+ */
+QUrl DownloadEngine::sourceUrl(const QString& location)
+{
+    const QUrl url(location);
+    const QString scheme = url.scheme().toLower();
+    if (scheme == "http" || scheme == "https" || scheme == "file")
+        return url;
+    return QUrl::fromLocalFile(location);
+}
+
+void DownloadEngine::enqueue(const DownloadScheduler::Job& job)
+{
+    if (m_scheduler.enqueue(job)) m_stats.queued(job.id);
+    startQueued();
+}
+
+/**
+ * @brief Abre el .part del destino y empieza la transferencia.
+ *
+ * Si hay un .part de una sesión anterior del mismo origen se conserva y su estado se
+ * valida con HEAD (onHeadFinished() reanuda o empieza de cero). Para http(s) también
+ * se pregunta el tamaño con HEAD para decidir entre segmentos y un solo flujo;
+ * file:// va siempre en un solo flujo y desde el principio.
+ */
+void DownloadEngine::launch(const DownloadScheduler::Job& job)
+{
+    const PictureId id = job.id;
+    const QString scheme = job.source.scheme().toLower();
+    const bool http = scheme == "http" || scheme == "https";
+
+    Transfer transfer;
+    transfer.source = job.source;
+    transfer.destination = job.destination;
+
+    const QString partPath = PartialDownload::partPath(job.destination);
+    const bool resumable = http
+                           && transfer.part.load(PartialDownload::sidecarPath(job.destination))
+                           && transfer.part.source == job.source.toString()
+                           && QFile::exists(partPath);
+    if (!resumable) transfer.part.clear();
+    transfer.part.source = job.source.toString();
+
+    QDir().mkpath(QFileInfo(job.destination).absolutePath());
+    transfer.file = new QFile(partPath);
+    const QIODevice::OpenMode mode = resumable ? QIODevice::ReadWrite
+                                               : QIODevice::WriteOnly | QIODevice::Truncate;
+    if (!transfer.file->open(mode)) {
+        const QString error = transfer.file->errorString();
+        delete transfer.file;
+        qWarning() << "No se pudo crear" << partPath << error;
+        m_scheduler.finish(id);
+        fail(id, error);
+        return;
+    }
+    transfer.clock.start();
+    m_transfers.insert(id, transfer);
+
+    if (http && (isSegmented() || resumable)) {
+        QNetworkRequest request(job.source);
+        request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
+                             QNetworkRequest::NoLessSafeRedirectPolicy);
+        QNetworkReply* reply = m_network->head(request);
+        m_transfers[id].reply = reply;
+        connect(reply, &QNetworkReply::finished, m_network, [this, id]() { onHeadFinished(id); });
+    } else {
+        startSingle(id);
+    }
+}
+
+/**
+ * @brief Lanza todo lo que el planificador permita empezar y publica los contadores.
+ */
+void DownloadEngine::startQueued()
+{
+    DownloadScheduler::Job job;
+    while (m_scheduler.next(&job))
+        launch(job);
+    emit queueChanged(m_scheduler.queueDepth(), m_scheduler.inFlight());
+}
+
+/**
+ * @brief Interrumpe una transferencia en curso para devolverla a la cola (pausa).
+ */
+void DownloadEngine::interrupt(PictureId id, bool hold)
+{
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end()) return;
+    it->requeue = true;
+    it->hold = hold;
+    abortReplies(id); // termina en finishTransfer()
+}
+
+/**
+ * @brief Cancela en el hilo de red: quita de la cola o aborta la transferencia en curso.
+ */
+void DownloadEngine::abort(PictureId id)
+{
+    DownloadScheduler::Job job;
+    if (m_scheduler.remove(id, &job)) {
+        removePart(job.destination); // una pausada pudo dejar un .part
+        fail(id, tr("Cancelled"));
+        emit queueChanged(m_scheduler.queueDepth(), m_scheduler.inFlight());
+        return;
+    }
+
+    auto it = m_transfers.find(id);
+    if (it != m_transfers.end()) {
+        it->requeue = false; // una pausa pendiente no la devuelve a la cola
+        it->cancelled = true;
+        abortReplies(id);    // termina con OperationCanceledError
+    }
+}
+
+/**
+ * @brief Aborta todas las respuestas abiertas de una transferencia.
+ *
+ * QNetworkReply::abort() emite finished() en el acto, así que la transferencia puede
+ * haber terminado (y desaparecido de m_transfers) al volver: aquí solo se recogen los
+ * punteros antes de abortar.
+ */
+void DownloadEngine::abortReplies(PictureId id)
+{
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end()) return;
+
+    QList<QNetworkReply*> replies = it->segments.keys();
+    if (it->reply) replies << it->reply;
+    for (QNetworkReply* reply : qAsConst(replies))
+        reply->abort();
+}
+
+/**
+ * @brief Cierra la transferencia (todas sus respuestas ya han terminado).
+ *
+ * - Pausa: el .part y su estado se guardan y la descarga vuelve a la cola.
+ * - Éxito: el .part se renombra al destino y se borra su estado.
+ * - Cancelación u origen cambiado: se borran el .part y su estado.
+ * - Cualquier otro error: se guardan, para reanudar cuando se vuelva a pedir.
+ */
+void DownloadEngine::finishTransfer(PictureId id, const QString& error)
+{
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end()) return;
+    Transfer transfer = *it;
+    m_transfers.erase(it);
+
+    if (transfer.requeue) {
+        savePart(transfer);
+        delete transfer.file;
+        m_scheduler.requeue(id, transfer.hold);
+        if (transfer.hold) emit held(id, true);
+        startQueued();
+        return;
+    }
+
+    m_scheduler.finish(id);
+    QString result = error;
+    if (result.isEmpty()) {
+        transfer.file->close();
+        QFile::remove(transfer.destination);
+        if (!QFile::rename(transfer.file->fileName(), transfer.destination))
+            result = tr("Could not rename %1").arg(transfer.file->fileName());
+        else
+            QFile::remove(PartialDownload::sidecarPath(transfer.destination));
+    } else if (transfer.cancelled || transfer.discard) {
+        transfer.file->close();
+        removePart(transfer.destination);
+    } else {
+        savePart(transfer);
+    }
+    delete transfer.file;
+
+    if (result.isEmpty()) {
+        m_stats.finished(id, transfer.bytes, true);
+        if (transfer.percent != 100) emit progress(id, 100);
+        emit finished(id, true, QString());
+    } else {
+        qWarning() << "Descarga fallida" << transfer.source.toString() << result;
+        fail(id, result);
+    }
+
+    startQueued();
+}
+
+/**
+ * @brief Termina una descarga sin éxito (error o cancelación) y la anota en las medidas.
+ */
+void DownloadEngine::fail(PictureId id, const QString& error)
+{
+    m_stats.finished(id, 0, false);
+    emit finished(id, false, error);
+}
+
+/**
+ * @brief Emite progress() solo cuando cambia el porcentaje.
+ */
+void DownloadEngine::reportProgress(PictureId id, Transfer& transfer, qint64 received, qint64 total)
+{
+    if (total <= 0) return;
+    const int percent = static_cast<int>(qBound<qint64>(0, received * 100 / total, 100));
+    if (percent == transfer.percent) return;
+    transfer.percent = percent;
+    emit progress(id, percent);
+}
+
+/**
+ * @brief Anota [begin, end) como escrito y guarda el estado cada SidecarIntervalMs.
+ */
+void DownloadEngine::markWritten(Transfer& transfer, qint64 begin, qint64 end)
+{
+    transfer.part.add(begin, end);
+    if (transfer.clock.elapsed() - transfer.savedMs >= SidecarIntervalMs)
+        savePart(transfer);
+}
+
+/**
+ * @brief Vacía el .part a disco y después guarda su estado.
+ *
+ * En ese orden: el estado nunca anota rangos que no estén ya en el fichero.
+ */
+void DownloadEngine::savePart(Transfer& transfer)
+{
+    transfer.savedMs = transfer.clock.elapsed();
+    if (transfer.part.isEmpty()) return;
+    transfer.file->flush();
+    if (!transfer.part.save(PartialDownload::sidecarPath(transfer.destination)))
+        qWarning() << "No se pudo guardar el estado de" << transfer.file->fileName();
+}
+
+/**
+ * @brief Descarta el contenido del .part (el origen cambió o no admite reanudar).
+ */
+void DownloadEngine::resetPart(Transfer& transfer)
+{
+    transfer.part.clear();
+    transfer.file->resize(0);
+    transfer.file->seek(0);
+    QFile::remove(PartialDownload::sidecarPath(transfer.destination));
+}
+
+/**
+ * @brief Borra el .part de @p destination y su estado.
+ */
+void DownloadEngine::removePart(const QString& destination)
+{
+    QFile::remove(PartialDownload::partPath(destination));
+    QFile::remove(PartialDownload::sidecarPath(destination));
+}
+
+/**
+ * @brief Descarga de un solo flujo: GET escrito en orden según llega, desde el byte 0.
+ */
+void DownloadEngine::startSingle(PictureId id)
+{
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end()) return;
+
+    QNetworkRequest request(it->source);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
+                         QNetworkRequest::NoLessSafeRedirectPolicy);
+    QNetworkReply* reply = m_network->get(request);
+    it->reply = reply;
+
+    // El contexto es m_network: las ranuras se ejecutan en el hilo de red
+    connect(reply, &QNetworkReply::readyRead, m_network, [this, id]() { onReadyRead(id); });
+    connect(reply, &QNetworkReply::downloadProgress, m_network, [this, id](qint64 received, qint64 total) {
+        auto it = m_transfers.find(id);
+        if (it != m_transfers.end()) reportProgress(id, *it, received, total);
+    });
+    connect(reply, &QNetworkReply::finished, m_network, [this, id]() { onFinished(id); });
+}
+
+/**
+ * @brief Vuelca a disco lo recibido; si la escritura falla se aborta la transferencia.
+ */
+void DownloadEngine::onReadyRead(PictureId id)
+{
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end() || !it->reply) return;
+
+    // Validadores de la respuesta, por si hay que reanudarla en otra sesión
+    if (it->part.length < 0) {
+        it->part.length = it->reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+        it->part.etag = it->reply->rawHeader("ETag");
+    }
+
+    const QByteArray data = it->reply->readAll();
+    const qint64 position = it->bytes;
+    it->bytes += data.size();
+    if (it->file->write(data) != data.size()) {
+        it->error = it->file->errorString();
+        it->reply->abort();
+        return;
+    }
+    markWritten(*it, position, it->bytes);
+}
+
+/**
+ * @brief Fin del GET de un solo flujo: escribe lo que quede y cierra la transferencia.
+ */
+void DownloadEngine::onFinished(PictureId id)
+{
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end() || !it->reply) return;
+    QNetworkReply* reply = it->reply;
+    it->reply = nullptr;
+    reply->deleteLater();
+
+    QString error = it->error;
+    if (error.isEmpty() && reply->error() != QNetworkReply::NoError)
+        error = reply->errorString();
+    if (error.isEmpty()) {
+        const QByteArray rest = reply->readAll();
+        const qint64 position = it->bytes;
+        it->bytes += rest.size();
+        if (it->file->write(rest) != rest.size())
+            error = it->file->errorString();
+        else
+            it->part.add(position, it->bytes);
+    }
+    finishTransfer(id, error);
+}
+
+/**
+ * @brief Respuesta al HEAD: reanudar, segmentos o un solo flujo.
+ *
+ * - Si había un .part y el origen sigue igual (misma longitud y, si el servidor lo da,
+ *   mismo ETag) y admite Range, se piden solo los rangos que faltan.
+ * - Si no, el .part se descarta y, si el fichero es grande y admite Range, se
+ *   descarga por segmentos.
+ * - Cualquier otra respuesta (sin Content-Length, sin Accept-Ranges, HEAD no admitido)
+ *   pasa a un solo flujo, que es el que informa de los errores reales.
+ */
+void DownloadEngine::onHeadFinished(PictureId id)
+{
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end() || !it->reply) return;
+    QNetworkReply* reply = it->reply;
+    it->reply = nullptr;
+    reply->deleteLater();
+
+    if (reply->error() == QNetworkReply::OperationCanceledError) {
+        finishTransfer(id, reply->errorString()); // pausa o cancelación
+        return;
+    }
+
+    const bool ok = reply->error() == QNetworkReply::NoError;
+    const qint64 size = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+    const bool ranges = reply->rawHeader("Accept-Ranges").trimmed().toLower() == "bytes";
+    const QByteArray etag = reply->rawHeader("ETag");
+
+    // Los rangos piden la URL final, sin repetir redirecciones
+    if (ok && reply->url().isValid()) it->source = reply->url();
+
+    if (!it->part.isEmpty()) {
+        const bool unchanged = it->part.length == size
+                               && (it->part.etag.isEmpty() || it->part.etag == etag);
+        if (ok && ranges && size > 0 && unchanged) {
+            startRanged(id, size, it->part.missing());
+            return;
+        }
+        resetPart(*it);
+    }
+
+    it->part.length = size;
+    it->part.etag = etag;
+    if (ok && ranges && isSegmented() && size >= SegmentThreshold)
+        startRanged(id, size, QVector<PartialDownload::Range>{PartialDownload::Range{0, size}});
+    else
+        startSingle(id);
+}
+
+/**
+ * @brief Preasigna el .part con su tamaño final y pide los primeros segmentos.
+ * @param ranges Rangos a descargar (todo el fichero, o lo que falta al reanudar).
+ */
+void DownloadEngine::startRanged(PictureId id, qint64 size, const QVector<PartialDownload::Range>& ranges)
+{
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end()) return;
+
+    if (it->file->size() != size && !it->file->resize(size)) {
+        finishTransfer(id, it->file->errorString());
+        return;
+    }
+    it->size = size;
+    it->base = it->part.completedBytes();
+    it->pending = ranges;
+    if (!isSegmented()) it->maxParallel = it->parallel = 1;
+    it->sampleMs = it->clock.elapsed();
+
+    requestSegments(id);
+    if (it->segments.isEmpty()) finishTransfer(id, QString()); // ya estaba completo
+}
+
+/**
+ * @brief Pide segmentos hasta tener transfer.parallel abiertos o no quedar rangos.
+ *
+ * Cada segmento es un GET con Range de como mucho SegmentSize bytes;
+ * QNetworkAccessManager los reparte sobre sus conexiones persistentes con el
+ * servidor. Con If-Range, si el origen cambió el servidor responde 200 y la
+ * transferencia se descarta (onSegmentData()).
+ */
+void DownloadEngine::requestSegments(PictureId id)
+{
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end()) return;
+
+    while (it->segments.size() < it->parallel && !it->pending.isEmpty()) {
+        PartialDownload::Range& range = it->pending.first();
+        Segment segment;
+        segment.offset = range.begin;
+        segment.length = qMin(SegmentSize, range.end - range.begin);
+        range.begin += segment.length;
+        if (range.begin >= range.end) it->pending.removeFirst();
+
+        QNetworkRequest request(it->source);
+        request.setRawHeader("Range", QByteArray("bytes=")
+                                          + QByteArray::number(segment.offset) + '-'
+                                          + QByteArray::number(segment.offset + segment.length - 1));
+        if (!it->part.etag.isEmpty() && !it->part.etag.startsWith("W/"))
+            request.setRawHeader("If-Range", it->part.etag); // If-Range no admite ETag débiles
+        QNetworkReply* reply = m_network->get(request);
+        it->segments.insert(reply, segment);
+
+        connect(reply, &QNetworkReply::readyRead, m_network, [this, id, reply]() { onSegmentData(id, reply); });
+        connect(reply, &QNetworkReply::finished, m_network, [this, id, reply]() { onSegmentFinished(id, reply); });
+    }
+}
+
+/**
+ * @brief Escribe los datos de un segmento en su posición del fichero preasignado.
+ */
+void DownloadEngine::onSegmentData(PictureId id, QNetworkReply* reply)
+{
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end()) return;
+    auto segment = it->segments.find(reply);
+    if (segment == it->segments.end()) return;
+
+    // Un 200 traería el fichero entero (Range ignorado u origen cambiado según
+    // If-Range): no se puede escribir en la posición del rango y el .part ya no vale
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 206) {
+        if (it->error.isEmpty()) it->error = tr("The server ignored the Range request");
+        it->discard = true;
+        abortReplies(id);
+        return;
+    }
+
+    QByteArray data = reply->readAll();
+    data.truncate(int(qMin<qint64>(data.size(), segment->length - segment->written)));
+    if (!it->file->seek(segment->offset + segment->written)
+        || it->file->write(data) != data.size()) {
+        if (it->error.isEmpty()) it->error = it->file->errorString();
+        abortReplies(id);
+        return;
+    }
+    const qint64 position = segment->offset + segment->written;
+    segment->written += data.size();
+    it->bytes += data.size();
+    markWritten(*it, position, position + data.size());
+    reportProgress(id, *it, it->base + it->bytes, it->size);
+}
+
+/**
+ * @brief Fin de un segmento: ajusta el paralelismo y pide más, o cierra la transferencia.
+ *
+ * Ante el primer fallo se abortan los demás segmentos; la transferencia se cierra
+ * cuando termina el último.
+ */
+void DownloadEngine::onSegmentFinished(PictureId id, QNetworkReply* reply)
+{
+    reply->deleteLater();
+    auto it = m_transfers.find(id);
+    if (it == m_transfers.end() || !it->segments.contains(reply)) return;
+    const Segment segment = it->segments.take(reply);
+
+    if (it->error.isEmpty() && !it->requeue) {
+        if (reply->error() != QNetworkReply::NoError)
+            it->error = reply->errorString();
+        else if (segment.written != segment.length)
+            it->error = tr("Incomplete segment");
+    }
+
+    if (!it->error.isEmpty() || it->requeue) {
+        if (it->segments.isEmpty())
+            finishTransfer(id, it->error);
+        else
+            abortReplies(id); // el último en terminar cierra la transferencia
+        return;
+    }
+
+    adaptParallelism(*it);
+    requestSegments(id);
+    if (it->segments.isEmpty()) finishTransfer(id, QString()); // ya no quedan rangos
+}
+
+/**
+ * @brief Ajusta cuántos segmentos se piden a la vez según el caudal observado.
+ *
+ * Se mide el caudal desde el último ajuste: si mejora claramente respecto al mejor
+ * visto se abre un segmento más (hasta maxParallel); si empeora, uno menos.
+ */
+void DownloadEngine::adaptParallelism(Transfer& transfer)
+{
+    const qint64 now = transfer.clock.elapsed();
+    const qint64 ms = now - transfer.sampleMs;
+    if (ms <= 0) return;
+
+    const double rate = double(transfer.bytes - transfer.sampleBytes) / ms;
+    transfer.sampleBytes = transfer.bytes;
+    transfer.sampleMs = now;
+
+    if (rate > transfer.bestRate * 1.1) {
+        transfer.bestRate = rate;
+        transfer.parallel = qMin(transfer.parallel + 1, transfer.maxParallel);
+    } else if (rate < transfer.bestRate * 0.8) {
+        transfer.parallel = qMax(1, transfer.parallel - 1);
+    }
+}
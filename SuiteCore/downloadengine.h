@@ -0,0 +1,147 @@
+#ifndef DOWNLOADENGINE_H
+#define DOWNLOADENGINE_H
+
+#include "Picture.h"
+#include "downloadscheduler.h"
+#include "downloadstats.h"
+#include "partialdownload.h"
+#include "SuiteCore_global.h"
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QThread>
+#include <QUrl>
+
+class QNetworkAccessManager;
+class QFile;
+class QNetworkReply;
+
+// Motor de descargas asíncrono (http://, https:// y file://) sobre un único
+// QNetworkAccessManager en un hilo propio. Ninguna transferencia ocupa un hilo:
+// los datos se escriben según llegan (readyRead) en <destino>.part, que solo se
+// renombra al destino si la transferencia termina bien. El estado del .part se guarda
+// en un PartialDownload para reanudar tras una pausa, un error o un cierre. El orden,
+// el límite de transferencias simultáneas y las pausas los decide DownloadScheduler.
+// Los ficheros http(s) grandes se descargan por segmentos (Range) en paralelo.
+class SUITECORE_EXPORT DownloadEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Descargas segmentadas (HTTP Range): a partir de qué tamaño, de qué tamaño es cada
+    // segmento y cuántos se piden a la vez (el máximo coincide con las conexiones
+    // persistentes que QNetworkAccessManager mantiene por servidor)
+    static constexpr qint64 SegmentThreshold = 4 * 1024 * 1024;
+    static constexpr qint64 SegmentSize = 1024 * 1024;
+    static constexpr int InitialSegments = 2;
+    static constexpr int MaxSegments = 6;
+
+    // Frecuencia máxima con la que se guarda el estado de un .part mientras se descarga
+    static constexpr int SidecarIntervalMs = 1000;
+
+    explicit DownloadEngine(QObject* parent = nullptr);
+    ~DownloadEngine() override;
+
+    // Seguras desde cualquier hilo; el trabajo se hace en el hilo de red
+    void start(PictureId id, const QUrl& source, const QString& destination,
+               DownloadScheduler::Priority priority = DownloadScheduler::Bulk);
+    void pause(PictureId id);
+    void resume(PictureId id);
+    void cancel(PictureId id);
+    void pauseAll();
+    void resumeAll();
+    void cancelAll();
+    void cancelBulk(const QVector<PictureId>& ids);
+    void setMaxInFlight(int max);
+    void setSegmented(bool enabled) { m_segmented.storeRelease(enabled ? 1 : 0); }
+    bool isSegmented() const { return m_segmented.loadAcquire() != 0; }
+
+    // Monitorización (lectura directa del planificador)
+    int maxInFlight() const { return m_scheduler.maxInFlight(); }
+    int queueDepth() const { return m_scheduler.queueDepth(); }
+    int inFlight() const { return m_scheduler.inFlight(); }
+    int heldCount() const { return m_scheduler.heldCount(); }
+    bool isPaused() const { return m_scheduler.isPaused(); }
+    DownloadStats::Summary stats() const { return m_stats.summary(); }
+    void resetStats() { m_stats.reset(); }
+
+    // URL de origen para una ubicación del catálogo (URL o ruta local)
+    static QUrl sourceUrl(const QString& location);
+
+signals:
+    // Se emiten desde el hilo de red: conectar en cola
+    void progress(PictureId id, int percent);
+    void finished(PictureId id, bool ok, const QString& error);
+    void held(PictureId id, bool held);
+    void queueChanged(int queued, int inFlight);
+
+private:
+    struct Segment {
+        qint64 offset = 0;  // primer byte del rango
+        qint64 length = 0;
+        qint64 written = 0;
+    };
+    struct Transfer {
+        QUrl source;
+        QString destination;
+        QFile* file = nullptr;                    // <destino>.part
+        PartialDownload part;                     // lo que ya está escrito en el .part
+        QNetworkReply* reply = nullptr;           // HEAD o GET de un solo flujo
+        QHash<QNetworkReply*, Segment> segments;  // GET con Range en curso
+        QVector<PartialDownload::Range> pending;  // rangos aún sin pedir
+        qint64 size = -1;       // tamaño total (descarga por rangos)
+        qint64 base = 0;        // bytes que ya estaban en el .part al empezar
+        int parallel = InitialSegments;
+        int maxParallel = MaxSegments;
+        double bestRate = 0;    // mejor caudal observado, bytes/ms
+        qint64 sampleBytes = 0; // inicio de la ventana de medida actual
+        qint64 sampleMs = 0;
+        qint64 savedMs = 0;     // último guardado del estado del .part
+        QElapsedTimer clock;
+        int percent = -1;
+        qint64 bytes = 0;       // recibidos en esta sesión
+        QString error; // primer fallo (red o disco); aborta el resto de la transferencia
+        bool requeue = false;   // abortada por una pausa: vuelve a la cola, no termina
+        bool hold = false;      // ... y además queda retenida (pausa individual)
+        bool cancelled = false; // cancelada: se borra el .part
+        bool discard = false;   // el .part ya no vale (el origen cambió)
+    };
+
+    // Solo en el hilo de red
+    void enqueue(const DownloadScheduler::Job& job);
+    void launch(const DownloadScheduler::Job& job);
+    void startQueued();
+    void interrupt(PictureId id, bool hold);
+    void abort(PictureId id);
+    void abortReplies(PictureId id);
+    void finishTransfer(PictureId id, const QString& error);
+    void fail(PictureId id, const QString& error);
+    void reportProgress(PictureId id, Transfer& transfer, qint64 received, qint64 total);
+    void markWritten(Transfer& transfer, qint64 begin, qint64 end);
+    static void savePart(Transfer& transfer);
+    static void resetPart(Transfer& transfer);
+    static void removePart(const QString& destination);
+
+    // Un solo flujo
+    void startSingle(PictureId id);
+    void onReadyRead(PictureId id);
+    void onFinished(PictureId id);
+
+    // Por rangos: HEAD, fichero preasignado y segmentos en paralelo (también al reanudar)
+    void onHeadFinished(PictureId id);
+    void startRanged(PictureId id, qint64 size, const QVector<PartialDownload::Range>& ranges);
+    void requestSegments(PictureId id);
+    void onSegmentData(PictureId id, QNetworkReply* reply);
+    void onSegmentFinished(PictureId id, QNetworkReply* reply);
+    static void adaptParallelism(Transfer& transfer);
+
+    QThread m_thread;
+    QNetworkAccessManager* m_network;
+    DownloadScheduler m_scheduler;
+    DownloadStats m_stats;
+    QAtomicInt m_segmented = 1;
+    QHash<PictureId, Transfer> m_transfers;
+};
+
+#endif // DOWNLOADENGINE_H
@@ -0,0 +1,299 @@
+/**
+ * @file downloadscheduler.cpp
+ * @brief Orden y límite de las descargas de DownloadEngine.
+ *
+ * Cada trabajo está en uno de estos estados (m_state):
+ *  - Queued: en su carril (m_interactive o m_bulk), por orden de llegada.
+ *  - Held: pausado individualmente (m_held); no sale hasta release().
+ *  - InFlight: entregado por next() al motor (m_inFlight) hasta finish() o requeue().
+ *
+ * next() respeta la pausa global, el límite m_maxInFlight para el carril masivo y
+ * InteractiveSlots plazas extra para el interactivo. Un trabajo masivo que se vuelve
+ * a pedir con prioridad interactiva pasa al final del carril interactivo.
+ */
+
+#include "downloadscheduler.h"
+#include <QMutexLocker>
+
+/**
+ * @brief Añade un trabajo al final de su carril.
+ * @return false si el id ya estaba (en ese caso solo se le sube la prioridad si procede).
+ */
+bool DownloadScheduler::enqueue(const Job& job)
+{
+    QMutexLocker locker(&m_mutex);
+    const State current = m_state.value(job.id, Unknown);
+    if (current == Unknown) {
+        lane(job.priority).append(job);
+        m_state.insert(job.id, Queued);
+        return true;
+    }
+
+    if (job.priority == Interactive) {
+        Job promoted;
+        if (current == Queued && takeFromLane(m_bulk, job.id, &promoted)) {
+            promoted.priority = Interactive;
+            m_interactive.append(promoted);
+        } else if (current == Held) {
+            m_held[job.id].priority = Interactive;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Saca el siguiente trabajo que puede empezar y lo marca en curso.
+ * @return false si no hay ninguno (cola vacía, pausa global o límite alcanzado).
+ */
+bool DownloadScheduler::next(Job* job)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_paused) return false;
+
+    QList<Job>* from = nullptr;
+    if (!m_interactive.isEmpty() && m_inFlight.size() < m_maxInFlight + InteractiveSlots)
+        from = &m_interactive;
+    else if (!m_bulk.isEmpty() && m_inFlight.size() < m_maxInFlight)
+        from = &m_bulk;
+    if (!from) return false;
+
+    *job = from->takeFirst();
+    m_inFlight.insert(job->id, *job);
+    m_state.insert(job->id, InFlight);
+    return true;
+}
+
+/**
+ * @brief Un trabajo en curso ha terminado (bien, mal o cancelado): se olvida.
+ */
+void DownloadScheduler::finish(PictureId id)
+{
+    QMutexLocker locker(&m_mutex);
+    m_inFlight.remove(id);
+    m_state.remove(id);
+}
+
+/**
+ * @brief Devuelve un trabajo en curso a la cabeza de su carril (o a retenidos).
+ * @param hold true para retenerlo hasta release() (pausa individual).
+ */
+void DownloadScheduler::requeue(PictureId id, bool hold)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_inFlight.find(id);
+    if (it == m_inFlight.end()) return;
+    const Job job = *it;
+    m_inFlight.erase(it);
+
+    if (hold) {
+        m_held.insert(id, job);
+        m_state.insert(id, Held);
+    } else {
+        lane(job.priority).prepend(job);
+        m_state.insert(id, Queued);
+    }
+}
+
+/**
+ * @brief Retiene un trabajo en cola. Los que están en curso se retienen con requeue().
+ */
+bool DownloadScheduler::hold(PictureId id)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_state.value(id, Unknown) != Queued) return false;
+
+    Job job;
+    if (!takeFromLane(m_interactive, id, &job) && !takeFromLane(m_bulk, id, &job))
+        return false;
+    m_held.insert(id, job);
+    m_state.insert(id, Held);
+    return true;
+}
+
+/**
+ * @brief Vuelve a poner en cola un trabajo retenido, por delante de los de su carril.
+ */
+bool DownloadScheduler::release(PictureId id)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_held.find(id);
+    if (it == m_held.end()) return false;
+    const Job job = *it;
+    m_held.erase(it);
+
+    lane(job.priority).prepend(job);
+    m_state.insert(id, Queued);
+    return true;
+}
+
+/**
+ * @brief Quita un trabajo en cola o retenido (cancelación). Los que están en curso no.
+ * @param removed Si no es nulo, recibe el trabajo quitado.
+ */
+bool DownloadScheduler::remove(PictureId id, Job* removed)
+{
+    QMutexLocker locker(&m_mutex);
+    const State current = m_state.value(id, Unknown);
+    Job job;
+    if (current == Held) {
+        job = m_held.take(id);
+    } else if (current == Queued) {
+        if (!takeFromLane(m_interactive, id, &job)) takeFromLane(m_bulk, id, &job);
+    } else {
+        return false;
+    }
+    m_state.remove(id);
+    if (removed) *removed = job;
+    return true;
+}
+
+/**
+ * @brief Quita todo lo que no está en curso (cola y retenidos).
+ * @return Trabajos quitados.
+ */
+QVector<DownloadScheduler::Job> DownloadScheduler::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<Job> jobs;
+    jobs.reserve(m_interactive.size() + m_bulk.size() + m_held.size());
+    for (const Job& job : qAsConst(m_interactive)) jobs << job;
+    for (const Job& job : qAsConst(m_bulk)) jobs << job;
+    for (const Job& job : qAsConst(m_held)) jobs << job;
+
+    for (const Job& job : qAsConst(jobs)) m_state.remove(job.id);
+    m_interactive.clear();
+    m_bulk.clear();
+    m_held.clear();
+    return jobs;
+}
+
+/**
+ * @brief Quita de la cola y de retenidos los trabajos de @p ids con prioridad @p priority.
+ *
+ * Los que se subieron al carril interactivo (o ya estaban en él) se quedan.
+ * @return Trabajos quitados.
+ */
+QVector<DownloadScheduler::Job> DownloadScheduler::clear(Priority priority, const QSet<PictureId>& ids)
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<Job> jobs;
+    QList<Job>& from = lane(priority);
+    for (auto it = from.begin(); it != from.end();) {
+        if (ids.contains(it->id)) {
+            jobs << *it;
+            it = from.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = m_held.begin(); it != m_held.end();) {
+        if (it->priority == priority && ids.contains(it.key())) {
+            jobs << *it;
+            it = m_held.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (const Job& job : qAsConst(jobs)) m_state.remove(job.id);
+    return jobs;
+}
+
+/**
+ * @brief Vuelve a poner en cola todos los retenidos.
+ * @return Ids liberados.
+ */
+QVector<PictureId> DownloadScheduler::releaseAll()
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<PictureId> ids;
+    ids.reserve(m_held.size());
+    for (auto it = m_held.cbegin(); it != m_held.cend(); ++it) {
+        lane(it->priority).prepend(*it);
+        m_state.insert(it.key(), Queued);
+        ids << it.key();
+    }
+    m_held.clear();
+    return ids;
+}
+
+void DownloadScheduler::setPaused(bool paused)
+{
+    QMutexLocker locker(&m_mutex);
+    m_paused = paused;
+}
+
+bool DownloadScheduler::isPaused() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_paused;
+}
+
+void DownloadScheduler::setMaxInFlight(int max)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxInFlight = qMax(1, max);
+}
+
+int DownloadScheduler::maxInFlight() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxInFlight;
+}
+
+DownloadScheduler::State DownloadScheduler::state(PictureId id) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_state.value(id, Unknown);
+}
+
+int DownloadScheduler::queueDepth() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_interactive.size() + m_bulk.size();
+}
+
+int DownloadScheduler::heldCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_held.size();
+}
+
+int DownloadScheduler::inFlight() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_inFlight.size();
+}
+
+QVector<PictureId> DownloadScheduler::inFlightIds() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<PictureId> ids;
+    ids.reserve(m_inFlight.size());
+    for (auto it = m_inFlight.cbegin(); it != m_inFlight.cend(); ++it) ids << it.key();
+    return ids;
+}
+
+QVector<PictureId> DownloadScheduler::inFlightIds(Priority priority) const
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<PictureId> ids;
+    for (auto it = m_inFlight.cbegin(); it != m_inFlight.cend(); ++it) {
+        if (it->priority == priority) ids << it.key();
+    }
+    return ids;
+}
+
+/**
+ * @brief Saca de @p lane el trabajo @p id (búsqueda lineal; se llama con m_mutex tomado).
+ */
+bool DownloadScheduler::takeFromLane(QList<Job>& lane, PictureId id, Job* job)
+{
+    for (int i = 0; i < lane.size(); ++i) {
+        if (lane.at(i).id == id) {
+            *job = lane.takeAt(i);
+            return true;
+        }
+    }
+    return false;
+}
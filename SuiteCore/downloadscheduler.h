@@ -0,0 +1,72 @@
+#ifndef DOWNLOADSCHEDULER_H
+#define DOWNLOADSCHEDULER_H
+
+#include "Picture.h"
+#include "SuiteCore_global.h"
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QUrl>
+#include <QVector>
+
+// Cola de descargas con límite de transferencias simultáneas y dos carriles FIFO:
+// el interactivo (doble clic) siempre se atiende antes que el masivo y dispone de
+// InteractiveSlots plazas por encima del límite, de modo que no espera a que termine
+// una descarga masiva. Solo decide el orden; DownloadEngine ejecuta las transferencias.
+class SUITECORE_EXPORT DownloadScheduler
+{
+public:
+    enum Priority { Bulk, Interactive };
+    enum State { Unknown, Queued, Held, InFlight };
+
+    struct Job {
+        PictureId id = InvalidPictureId;
+        QUrl source;
+        QString destination;
+        Priority priority = Bulk;
+    };
+
+    static constexpr int DefaultMaxInFlight = 6;
+    static constexpr int InteractiveSlots = 2;
+
+    // Todas seguras desde cualquier hilo
+    bool enqueue(const Job& job);
+    bool next(Job* job);
+    void finish(PictureId id);
+    void requeue(PictureId id, bool hold);
+    bool hold(PictureId id);
+    bool release(PictureId id);
+    bool remove(PictureId id, Job* removed = nullptr);
+    QVector<Job> clear();
+    QVector<Job> clear(Priority priority, const QSet<PictureId>& ids);
+    QVector<PictureId> releaseAll();
+
+    void setPaused(bool paused);
+    bool isPaused() const;
+    void setMaxInFlight(int max);
+    int maxInFlight() const;
+
+    State state(PictureId id) const;
+    int queueDepth() const; // en cola, sin contar las retenidas
+    int heldCount() const;
+    int inFlight() const;
+    QVector<PictureId> inFlightIds() const;
+    QVector<PictureId> inFlightIds(Priority priority) const;
+
+private:
+    QList<Job>& lane(Priority priority) { return priority == Interactive ? m_interactive : m_bulk; }
+    bool takeFromLane(QList<Job>& lane, PictureId id, Job* job);
+
+    mutable QMutex m_mutex;
+    QList<Job> m_interactive;
+    QList<Job> m_bulk;
+    QHash<PictureId, Job> m_held;     // pausadas una a una: no salen hasta release()
+    QHash<PictureId, Job> m_inFlight;
+    QHash<PictureId, State> m_state;
+    int m_maxInFlight = DefaultMaxInFlight;
+    bool m_paused = false;
+};
+
+#endif // DOWNLOADSCHEDULER_H
@@ -0,0 +1,97 @@
+/**
+ * @file downloadstats.cpp
+ * @brief Medidas de rendimiento de las descargas reales.
+ *
+ * DownloadEngine anota aquí cuándo entra cada descarga en la cola y cuándo termina
+ * (con los bytes escritos). summary() calcula sobre esos datos el caudal (imágenes/s
+ * y MB/s en la ventana del primer encolado a la última terminación) y los percentiles
+ * p50/p99 del tiempo hasta completar, para comparar cambios del motor con números.
+ */
+
+#include "downloadstats.h"
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+
+DownloadStats::DownloadStats()
+{
+    m_clock.start();
+}
+
+/**
+ * @brief Una descarga entra en la cola (si ya estaba, se conserva la primera hora).
+ */
+void DownloadStats::queued(PictureId id)
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 now = m_clock.elapsed();
+    if (m_queuedAt.contains(id)) return;
+    m_queuedAt.insert(id, now);
+    if (m_firstQueued < 0) m_firstQueued = now;
+}
+
+/**
+ * @brief Una descarga termina; solo las completadas cuentan para caudal y percentiles.
+ */
+void DownloadStats::finished(PictureId id, qint64 bytes, bool ok)
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 now = m_clock.elapsed();
+    const qint64 queuedAt = m_queuedAt.take(id);
+    if (!ok) {
+        ++m_failed;
+        return;
+    }
+    m_durations << now - queuedAt;
+    m_bytes += bytes;
+    m_lastFinished = now;
+}
+
+/**
+ * @brief Empieza una medida nueva (las descargas ya encoladas siguen contando su espera).
+ */
+void DownloadStats::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_durations.clear();
+    m_bytes = 0;
+    m_failed = 0;
+    m_firstQueued = m_queuedAt.isEmpty() ? -1 : m_clock.elapsed();
+    m_lastFinished = -1;
+}
+
+/**
+ * @brief Resumen de lo medido desde el último reset().
+ */
+DownloadStats::Summary DownloadStats::summary() const
+{
+    QVector<qint64> durations;
+    Summary result;
+    {
+        QMutexLocker locker(&m_mutex);
+        durations = m_durations;
+        result.failed = m_failed;
+        result.bytes = m_bytes;
+        if (m_firstQueued >= 0 && m_lastFinished >= m_firstQueued)
+            result.elapsedMs = m_lastFinished - m_firstQueued;
+    }
+
+    result.completed = durations.size();
+    if (durations.isEmpty()) return result;
+
+    if (result.elapsedMs > 0) {
+        const double seconds = result.elapsedMs / 1000.0;
+        result.itemsPerSecond = result.completed / seconds;
+        result.megabytesPerSecond = result.bytes / (1024.0 * 1024.0) / seconds;
+    }
+
+    // Percentil por rango más cercano
+    std::sort(durations.begin(), durations.end());
+    auto percentile = [&durations](double p) {
+        const int rank = static_cast<int>(std::ceil(p * durations.size()));
+        return durations.at(qBound(0, rank - 1, durations.size() - 1));
+    };
+    result.p50Ms = percentile(0.50);
+    result.p99Ms = percentile(0.99);
+    return result;
+}
@@ -0,0 +1,47 @@
+#ifndef DOWNLOADSTATS_H
+#define DOWNLOADSTATS_H
+
+#include "Picture.h"
+#include "SuiteCore_global.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+
+// Medidas de rendimiento de DownloadEngine desde el último reset(): imágenes y bytes
+// por segundo y percentiles del tiempo hasta completar (desde que la descarga entra
+// en la cola, espera incluida).
+class SUITECORE_EXPORT DownloadStats
+{
+public:
+    struct Summary {
+        int completed = 0;
+        int failed = 0;
+        qint64 bytes = 0;
+        qint64 elapsedMs = 0;   // del primer encolado a la última terminación
+        double itemsPerSecond = 0;
+        double megabytesPerSecond = 0;
+        qint64 p50Ms = 0;
+        qint64 p99Ms = 0;
+    };
+
+    DownloadStats();
+
+    // Seguras desde cualquier hilo
+    void queued(PictureId id);
+    void finished(PictureId id, qint64 bytes, bool ok);
+    void reset();
+    Summary summary() const;
+
+private:
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+    QHash<PictureId, qint64> m_queuedAt;
+    QVector<qint64> m_durations; // de las completadas, en ms
+    qint64 m_firstQueued = -1;
+    qint64 m_lastFinished = -1;
+    qint64 m_bytes = 0;
+    int m_failed = 0;
+};
+
+#endif // DOWNLOADSTATS_H
@@ -0,0 +1,202 @@
+/**
+ * @file expirationscheduler.cpp
+ * @brief Programación de la caducidad de las imágenes.
+ *
+ * Una imagen caduca el día siguiente a su expirationDate. En lugar de comparar la
+ * fecha de cada imagen con QDate::currentDate() cada vez que se consulta o se pinta,
+ * ExpirationScheduler las agrupa en cubos por ese día (QMap ordenado) y arma un solo
+ * QTimer para la medianoche del primer cubo. Al vencer, saca de golpe todos los cubos
+ * cuyo día ya ha llegado y emite expired() con sus ids; PictureManager actualiza
+ * entonces el bit Expired del almacén y las vistas solo tocan esas filas.
+ *
+ * La espera se limita a MaxWaitMs: si el reloj del sistema cambia o el equipo se
+ * suspende, la siguiente comprobación corrige el retraso sin perder ningún cubo.
+ */
+
+#include "expirationscheduler.h"
+#include "picturestore.h"
+#include <QDateTime>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QTimer>
+
+namespace {
+
+const qint64 NoDay = -1;
+
+/**
+ * @brief Día juliano a partir del cual una imagen con esa fecha está caducada.
+ */
+qint64 expiryDay(qint64 expirationDay)
+{
+    return expirationDay + 1;
+}
+
+} // namespace
+
+/**
+ * @brief Constructor: crea el temporizador (de una sola vez, se rearma tras cada cubo).
+ * @param parent Objeto padre.
+ */
+ExpirationScheduler::ExpirationScheduler(QObject* parent)
+    : QObject(parent),
+    m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::VeryCoarseTimer);
+    connect(m_timer, &QTimer::timeout, this, &ExpirationScheduler::fire);
+}
+
+/**
+ * @brief Programa (o reprograma) la caducidad de una imagen.
+ *
+ * Una fecha no válida equivale a unschedule(). Si la fecha ya ha pasado, la imagen
+ * se emite en la siguiente vuelta del bucle de eventos.
+ */
+void ExpirationScheduler::schedule(PictureId id, const QDate& expirationDate)
+{
+    if (!expirationDate.isValid()) {
+        unschedule(id);
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    const qint64 previousFirst = m_buckets.isEmpty() ? NoDay : m_buckets.firstKey();
+    remove(id);
+    insert(id, expiryDay(expirationDate.toJulianDay()));
+    requestArm(previousFirst);
+}
+
+/**
+ * @brief Programa las filas de 'store' a partir de 'first' que aún no han caducado.
+ */
+void ExpirationScheduler::schedule(const PictureStore& store, int first)
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 previousFirst = m_buckets.isEmpty() ? NoDay : m_buckets.firstKey();
+    for (int row = first; row < store.size(); ++row) {
+        const qint32 day = store.expirationDay(row);
+        if (day == PictureStore::NoDate || store.test(PictureStore::Expired, row)) continue;
+
+        const PictureId id = store.id(row);
+        remove(id);
+        insert(id, expiryDay(day));
+    }
+    requestArm(previousFirst);
+}
+
+void ExpirationScheduler::unschedule(PictureId id)
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 previousFirst = m_buckets.isEmpty() ? NoDay : m_buckets.firstKey();
+    remove(id);
+    requestArm(previousFirst);
+}
+
+/**
+ * @brief Sustituye todo lo programado por las caducidades de 'store'.
+ */
+void ExpirationScheduler::reset(const PictureStore& store)
+{
+    clear();
+    schedule(store);
+}
+
+void ExpirationScheduler::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 previousFirst = m_buckets.isEmpty() ? NoDay : m_buckets.firstKey();
+    m_buckets.clear();
+    m_dayById.clear();
+    requestArm(previousFirst);
+}
+
+int ExpirationScheduler::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dayById.size();
+}
+
+/**
+ * @brief Día en que caducará el próximo cubo (no válida si no hay nada programado).
+ */
+QDate ExpirationScheduler::nextExpiration() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_buckets.isEmpty() ? QDate() : QDate::fromJulianDay(m_buckets.firstKey());
+}
+
+// Con m_mutex tomado
+void ExpirationScheduler::insert(PictureId id, qint64 day)
+{
+    m_buckets[day].append(id);
+    m_dayById.insert(id, day);
+}
+
+// Con m_mutex tomado
+void ExpirationScheduler::remove(PictureId id)
+{
+    const auto it = m_dayById.find(id);
+    if (it == m_dayById.end()) return;
+
+    const auto bucket = m_buckets.find(it.value());
+    bucket->removeOne(id);
+    if (bucket->isEmpty()) m_buckets.erase(bucket);
+    m_dayById.erase(it);
+}
+
+/**
+ * @brief Rearma el temporizador si ha cambiado el primer cubo (con m_mutex tomado).
+ *
+ * El QTimer solo puede tocarse desde el hilo del objeto, así que se encola.
+ */
+void ExpirationScheduler::requestArm(qint64 previousFirst)
+{
+    const qint64 first = m_buckets.isEmpty() ? NoDay : m_buckets.firstKey();
+    if (first == previousFirst) return;
+    QMetaObject::invokeMethod(this, [this]() { arm(); }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Arma el temporizador para la medianoche del primer cubo (como mucho MaxWaitMs).
+ */
+void ExpirationScheduler::arm()
+{
+    qint64 first = NoDay;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_buckets.isEmpty()) first = m_buckets.firstKey();
+    }
+    if (first == NoDay) {
+        m_timer->stop();
+        return;
+    }
+
+    const QDateTime boundary(QDate::fromJulianDay(first), QTime(0, 0));
+    const qint64 wait = QDateTime::currentDateTime().msecsTo(boundary);
+    m_timer->start(int(qBound<qint64>(0, wait, MaxWaitMs)));
+}
+
+/**
+ * @brief Vence el temporizador: emite de una vez los ids de todos los cubos ya alcanzados.
+ *
+ * Si la espera se cortó en MaxWaitMs o el reloj se adelantó, no hay cubos pendientes
+ * y solo se rearma. La señal se emite sin m_mutex tomado.
+ */
+void ExpirationScheduler::fire()
+{
+    const qint64 today = QDate::currentDate().toJulianDay();
+    QVector<PictureId> ids;
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_buckets.isEmpty() && m_buckets.firstKey() <= today) {
+            for (PictureId id : m_buckets.first())
+                m_dayById.remove(id);
+            ids += m_buckets.first();
+            m_buckets.erase(m_buckets.begin());
+        }
+    }
+
+    if (!ids.isEmpty()) emit expired(ids);
+    arm();
+}
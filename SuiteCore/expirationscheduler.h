@@ -0,0 +1,55 @@
+#ifndef EXPIRATIONSCHEDULER_H
+#define EXPIRATIONSCHEDULER_H
+
+#include "Picture.h"
+#include "SuiteCore_global.h"
+#include <QDate>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+
+class PictureStore;
+class QTimer;
+
+// Programa la caducidad de las imágenes: las agrupa por el día en que caducan y
+// mantiene un único temporizador armado para el próximo cambio de día con caducidades.
+// Al vencer emite expired() con todos los ids de ese día de una vez.
+class SUITECORE_EXPORT ExpirationScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Espera máxima entre comprobaciones (cambios de hora del sistema, suspensión)
+    static constexpr int MaxWaitMs = 60 * 60 * 1000;
+
+    explicit ExpirationScheduler(QObject* parent = nullptr);
+
+    // Seguras desde cualquier hilo; el temporizador se rearma en el hilo del objeto
+    void schedule(PictureId id, const QDate& expirationDate);
+    void schedule(const PictureStore& store, int first = 0);
+    void unschedule(PictureId id);
+    void reset(const PictureStore& store);
+    void clear();
+
+    int count() const;
+    QDate nextExpiration() const;
+
+signals:
+    void expired(const QVector<PictureId>& ids);
+
+private:
+    void insert(PictureId id, qint64 day);
+    void remove(PictureId id);
+    void requestArm(qint64 previousFirst);
+    void arm();
+    void fire();
+
+    mutable QMutex m_mutex;
+    QMap<qint64, QVector<PictureId>> m_buckets; // día juliano en que caducan -> ids
+    QHash<PictureId, qint64> m_dayById;
+    QTimer* m_timer;
+};
+
+#endif // EXPIRATIONSCHEDULER_H
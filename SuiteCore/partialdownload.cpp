@@ -0,0 +1,116 @@
+/**
+ * @file partialdownload.cpp
+ * @brief Estado persistente de las descargas a medias (.part.json).
+ *
+ * Los rangos se mantienen ordenados y fusionados: una descarga de un solo flujo tiene
+ * un único rango [0, n) y una segmentada, como mucho uno por segmento abierto. El
+ * fichero se reescribe completo con QSaveFile, así que nunca queda a medio escribir;
+ * DownloadEngine lo guarda después de vaciar el .part a disco, de modo que los rangos
+ * anotados siempre están escritos de verdad.
+ */
+
+#include "partialdownload.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+/**
+ * @brief Anota el rango [begin, end) como escrito, fusionándolo con los vecinos.
+ */
+void PartialDownload::add(qint64 begin, qint64 end)
+{
+    if (begin >= end) return;
+
+    // Primer rango que acaba en begin o después: ahí empieza la fusión
+    int first = 0;
+    while (first < m_ranges.size() && m_ranges.at(first).end < begin) ++first;
+
+    Range merged{begin, end};
+    int last = first;
+    while (last < m_ranges.size() && m_ranges.at(last).begin <= end) {
+        merged.begin = qMin(merged.begin, m_ranges.at(last).begin);
+        merged.end = qMax(merged.end, m_ranges.at(last).end);
+        ++last;
+    }
+    m_ranges.remove(first, last - first);
+    m_ranges.insert(first, merged);
+}
+
+/**
+ * @brief Rangos que faltan en [0, length) (vacío si la longitud es desconocida).
+ */
+QVector<PartialDownload::Range> PartialDownload::missing() const
+{
+    QVector<Range> result;
+    if (length <= 0) return result;
+
+    qint64 position = 0;
+    for (const Range& range : m_ranges) {
+        if (range.begin >= length) break;
+        if (range.begin > position) result.append(Range{position, range.begin});
+        position = qMax(position, range.end);
+    }
+    if (position < length) result.append(Range{position, length});
+    return result;
+}
+
+qint64 PartialDownload::completedBytes() const
+{
+    qint64 total = 0;
+    for (const Range& range : m_ranges) total += range.end - range.begin;
+    return total;
+}
+
+void PartialDownload::clear()
+{
+    length = -1;
+    etag.clear();
+    m_ranges.clear();
+}
+
+/**
+ * @brief Lee el estado de @p path.
+ * @return false si no existe o no es válido (la descarga empezará de cero).
+ */
+bool PartialDownload::load(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    const QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+    if (obj.isEmpty()) return false;
+
+    clear();
+    source = obj.value("source").toString();
+    length = static_cast<qint64>(obj.value("length").toDouble(-1));
+    etag = obj.value("etag").toString().toUtf8();
+    for (const QJsonValue& value : obj.value("ranges").toArray()) {
+        const QJsonArray pair = value.toArray();
+        if (pair.size() == 2)
+            add(static_cast<qint64>(pair.at(0).toDouble()), static_cast<qint64>(pair.at(1).toDouble()));
+    }
+    return !source.isEmpty();
+}
+
+/**
+ * @brief Escribe el estado en @p path de forma atómica.
+ */
+bool PartialDownload::save(const QString& path) const
+{
+    QJsonArray ranges;
+    for (const Range& range : m_ranges)
+        ranges.append(QJsonArray{double(range.begin), double(range.end)});
+
+    QJsonObject obj;
+    obj.insert("source", source);
+    obj.insert("length", double(length));
+    obj.insert("etag", QString::fromUtf8(etag));
+    obj.insert("ranges", ranges);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
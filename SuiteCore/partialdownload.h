@@ -0,0 +1,41 @@
+#ifndef PARTIALDOWNLOAD_H
+#define PARTIALDOWNLOAD_H
+
+#include "SuiteCore_global.h"
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// Estado de una descarga a medias, guardado junto a su fichero .part en un pequeño
+// JSON (<destino>.part.json): origen, validadores (longitud y ETag) y rangos de bytes
+// ya escritos. Con él DownloadEngine reanuda la descarga pidiendo solo lo que falta.
+class SUITECORE_EXPORT PartialDownload
+{
+public:
+    struct Range {
+        qint64 begin; // incluido
+        qint64 end;   // excluido
+    };
+
+    QString source;
+    qint64 length = -1;
+    QByteArray etag;
+
+    const QVector<Range>& ranges() const { return m_ranges; }
+    void add(qint64 begin, qint64 end);
+    QVector<Range> missing() const;
+    qint64 completedBytes() const;
+    bool isEmpty() const { return m_ranges.isEmpty(); }
+    void clear();
+
+    bool load(const QString& path);
+    bool save(const QString& path) const;
+
+    static QString partPath(const QString& destination) { return destination + ".part"; }
+    static QString sidecarPath(const QString& destination) { return destination + ".part.json"; }
+
+private:
+    QVector<Range> m_ranges; // ordenados, sin solapes ni contiguos
+};
+
+#endif // PARTIALDOWNLOAD_H
@@ -0,0 +1,299 @@
+/**
+ * @file persistencewriter.cpp
+ * @brief Escritura en segundo plano del estado de las imágenes.
+ *
+ * PersistenceWriter saca la E/S de disco del hilo de la interfaz y de los hilos de
+ * descarga. Los cambios llegan como notificaciones (append/markDirty) que solo
+ * encolan datos; un temporizador en el hilo de escritura abre una ventana de
+ * DebounceMs y, al vencer, confirma todo lo acumulado de una vez:
+ *  - los registros pendientes se añaden al diario con una única escritura,
+ *  - si hay base de datos SQLite configurada, el mismo lote se aplica en una transacción
+ *    (antes, si el catálogo cambió, se alinea la base de datos con el estado publicado),
+ *  - si se pidió (o el diario supera sus umbrales) se serializa una copia del estado
+ *    obtenida con el SnapshotProvider y se reescribe downloaded.json con QSaveFile;
+ *    la instantánea binaria del catálogo se renueva con la misma copia, porque se
+ *    valida contra downloaded.json y, si no, el siguiente arranque no podría usarla,
+ *  - si solo cambió el catálogo (recarga en caliente), se renueva únicamente la instantánea.
+ *
+ * Así, una descarga masiva produce unas pocas escrituras en lugar de una por imagen.
+ * Cerrar la aplicación sin cambios no toca downloaded.json: el diario basta.
+ */
+
+#include "persistencewriter.h"
+#include "PictureDAO.h"
+#include "catalogsnapshot.h"
+#include "compresseddevice.h"
+#include "sqlitepicturedao.h"
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QTimer>
+
+/**
+ * @brief Constructor: crea el hilo de escritura y su temporizador de agrupación.
+ * @param journal Diario donde se confirman los registros (no se toma la propiedad).
+ * @param parent Objeto padre.
+ */
+PersistenceWriter::PersistenceWriter(StateJournal* journal, QObject* parent)
+    : QObject(parent),
+    m_journal(journal),
+    m_timer(new QTimer)
+{
+    m_thread.setObjectName("PersistenceWriter");
+
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(DebounceMs);
+    m_timer->moveToThread(&m_thread);
+    connect(m_timer, &QTimer::timeout, m_timer, [this]() { commit(); });
+
+    m_thread.start(QThread::LowPriority);
+}
+
+/**
+ * @brief Destructor: detiene el hilo y confirma lo que quedara pendiente.
+ */
+PersistenceWriter::~PersistenceWriter()
+{
+    m_thread.quit();
+    m_thread.wait();
+    delete m_timer;
+
+    commit();
+}
+
+void PersistenceWriter::setSnapshotProvider(const SnapshotProvider& provider)
+{
+    QMutexLocker locker(&m_mutex);
+    m_provider = provider;
+}
+
+void PersistenceWriter::setTargetPath(const QString& path)
+{
+    QMutexLocker locker(&m_mutex);
+    m_targetPath = path;
+}
+
+/**
+ * @brief Catálogo cuya instantánea se renueva al reescribir downloaded.json.
+ */
+void PersistenceWriter::setCatalogPath(const QString& catalogPath, const QString& basePath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_catalogPath = catalogPath;
+    m_basePath = basePath;
+}
+
+/**
+ * @brief Permite o bloquea la reescritura de downloaded.json (y la compactación).
+ *
+ * Con la reescritura bloqueada los cambios se siguen confirmando en el diario, que
+ * no se recorta; la compactación pendiente se hace en la primera confirmación tras
+ * volver a permitirla.
+ */
+void PersistenceWriter::setRewriteEnabled(bool enabled)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_rewriteEnabled = enabled;
+    }
+    if (enabled) schedule();
+}
+
+/**
+ * @brief Base de datos a la que se replican los cambios (nullptr para desactivar).
+ *
+ * La conexión SQLite se abre en el hilo de escritura la primera vez que se usa.
+ */
+void PersistenceWriter::setDatabase(SqlitePictureDAO* database)
+{
+    QMutexLocker locker(&m_mutex);
+    m_database = database;
+}
+
+/**
+ * @brief Encola un registro de diario y programa una confirmación.
+ */
+void PersistenceWriter::append(const StateJournal::Record& record)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pending.append(record);
+        ++m_requested;
+    }
+    schedule();
+}
+
+/**
+ * @brief Encola varios registros (una operación masiva) con un solo bloqueo.
+ */
+void PersistenceWriter::append(const QList<StateJournal::Record>& records)
+{
+    if (records.isEmpty()) return;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pending.append(records);
+        ++m_requested;
+    }
+    schedule();
+}
+
+/**
+ * @brief Pide una reescritura completa de downloaded.json en la próxima confirmación.
+ */
+void PersistenceWriter::markDirty()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_fullRewrite = true;
+        ++m_requested;
+    }
+    schedule();
+}
+
+/**
+ * @brief Pide renovar la instantánea del catálogo en la próxima confirmación, sin
+ * reescribir downloaded.json.
+ *
+ * Como la reescritura, espera a que el estado publicado esté completo (setRewriteEnabled()).
+ */
+void PersistenceWriter::markSnapshotDirty()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_snapshotDirty = true;
+        ++m_requested;
+    }
+    schedule();
+}
+
+/**
+ * @brief Pide alinear la base de datos con el catálogo publicado (SqlitePictureDAO::syncCatalog())
+ * en la próxima confirmación, p. ej. tras cargarlo o recargarlo.
+ *
+ * Como la reescritura, espera a que el estado publicado esté completo.
+ */
+void PersistenceWriter::markDatabaseStale()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_databaseStale = true;
+        ++m_requested;
+    }
+    schedule();
+}
+
+/**
+ * @brief Confirma inmediatamente todo lo pendiente y espera a que termine.
+ *
+ * Pensado para el cierre de la aplicación. Solo reescribe downloaded.json si se pidió
+ * con markDirty() o el diario necesita compactarse; si no, basta con el diario, y
+ * downloaded.json (y con él la instantánea del catálogo) sigue vigente.
+ *
+ * @param deadline Tiempo máximo de espera.
+ * @return true si la confirmación terminó antes del plazo.
+ */
+bool PersistenceWriter::flush(QDeadlineTimer deadline)
+{
+    QMutexLocker locker(&m_mutex);
+    const quint64 target = ++m_requested;
+    locker.unlock();
+
+    QMetaObject::invokeMethod(m_timer, [this]() {
+        m_timer->stop();
+        commit();
+    }, Qt::QueuedConnection);
+
+    locker.relock();
+    while (m_completed < target) {
+        if (!m_committedCondition.wait(&m_mutex, deadline))
+            return false;
+    }
+    return true;
+}
+
+int PersistenceWriter::commitCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_commitCount;
+}
+
+/**
+ * @brief Arranca la ventana de agrupación si no hay una abierta.
+ *
+ * El temporizador no se reinicia con cada notificación: el retraso máximo de un
+ * cambio es DebounceMs aunque lleguen notificaciones de forma continua.
+ */
+void PersistenceWriter::schedule()
+{
+    QMetaObject::invokeMethod(m_timer, [this]() {
+        if (!m_timer->isActive()) m_timer->start();
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Confirma lo acumulado. Se ejecuta en el hilo de escritura.
+ */
+void PersistenceWriter::commit()
+{
+    QList<StateJournal::Record> records;
+    bool fullRewrite = false;
+    bool renewSnapshot = false;
+    bool syncDatabase = false;
+    QString target;
+    QString catalogPath;
+    QString basePath;
+    bool rewriteEnabled = true;
+    SnapshotProvider provider;
+    SqlitePictureDAO* database = nullptr;
+    quint64 generation = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        records.swap(m_pending);
+        rewriteEnabled = m_rewriteEnabled;
+        fullRewrite = m_fullRewrite && rewriteEnabled;
+        renewSnapshot = m_snapshotDirty && rewriteEnabled;
+        syncDatabase = m_databaseStale && rewriteEnabled && m_database;
+        if (rewriteEnabled) {
+            m_fullRewrite = false;
+            m_snapshotDirty = false;
+            m_databaseStale = false;
+        }
+        target = m_targetPath;
+        catalogPath = m_catalogPath;
+        basePath = m_basePath;
+        provider = m_provider;
+        database = m_database;
+        generation = m_requested;
+    }
+
+    if (m_journal) m_journal->append(records);
+    if (syncDatabase && provider) database->syncCatalog(provider());
+    if (database) database->applyChanges(records);
+
+    // El diario solo se escribe desde este hilo, así que 'covered' abarca todo lo confirmado
+    const bool compact = rewriteEnabled && m_journal && m_journal->needsCompaction();
+    if (!target.isEmpty() && provider && (fullRewrite || compact)) {
+        const qint64 covered = m_journal ? m_journal->size() : 0;
+        const QList<Picture> state = provider();
+        // Se respeta el formato actual del fichero (JSON plano o gzip)
+        const bool compress = InflateDevice::isCompressed(target);
+        if (PictureDAO::saveDownloaded(state, target, compress)) {
+            if (m_journal) m_journal->discardPrefix(covered);
+            if (!catalogPath.isEmpty())
+                CatalogSnapshot::write(CatalogSnapshot::pathFor(catalogPath), state,
+                                       QStringList() << catalogPath << target, basePath);
+            renewSnapshot = false;
+        }
+    }
+    if (renewSnapshot && provider && !catalogPath.isEmpty()) {
+        CatalogSnapshot::write(CatalogSnapshot::pathFor(catalogPath), provider(),
+                               QStringList() << catalogPath << target, basePath);
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_completed = qMax(m_completed, generation);
+        ++m_commitCount;
+        m_committedCondition.wakeAll();
+    }
+    emit committed();
+}
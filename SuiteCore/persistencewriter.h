@@ -0,0 +1,84 @@
+#ifndef PERSISTENCEWRITER_H
+#define PERSISTENCEWRITER_H
+
+#include "Picture.h"
+#include "statejournal.h"
+#include "SuiteCore_global.h"
+#include <QDeadlineTimer>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QWaitCondition>
+#include <functional>
+
+class QTimer;
+class SqlitePictureDAO;
+
+// Hilo dedicado a la persistencia: agrupa los cambios recibidos durante una ventana
+// corta y los confirma de una vez (diario + downloaded.json con QSaveFile).
+class SUITECORE_EXPORT PersistenceWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    using SnapshotProvider = std::function<QList<Picture>()>;
+
+    static constexpr int DebounceMs = 250;
+
+    explicit PersistenceWriter(StateJournal* journal, QObject* parent = nullptr);
+    ~PersistenceWriter() override;
+
+    void setSnapshotProvider(const SnapshotProvider& provider);
+    void setTargetPath(const QString& path);
+    void setCatalogPath(const QString& catalogPath, const QString& basePath);
+    void setDatabase(SqlitePictureDAO* database);
+
+    // Mientras el estado publicado esté incompleto (carga en curso) no se reescribe
+    // downloaded.json: los cambios solo van al diario
+    void setRewriteEnabled(bool enabled);
+
+    // Seguras desde cualquier hilo; no hacen E/S
+    void append(const StateJournal::Record& record);
+    void append(const QList<StateJournal::Record>& records);
+    void markDirty();
+    // Renueva la instantánea del catálogo (p. ej. tras recargarlo) en la próxima confirmación
+    void markSnapshotDirty();
+    // Alinea la base de datos (si hay) con el catálogo publicado en la próxima confirmación
+    void markDatabaseStale();
+
+    // Confirma todo lo pendiente; espera hasta 'deadline'
+    bool flush(QDeadlineTimer deadline);
+
+    int commitCount() const;
+
+signals:
+    void committed();
+
+private:
+    void schedule();
+    void commit();
+
+    StateJournal* m_journal;
+    SnapshotProvider m_provider;
+
+    QThread m_thread;
+    QTimer* m_timer;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_committedCondition;
+    QString m_targetPath;
+    QString m_catalogPath; // para renovar la instantánea tras reescribir downloaded.json
+    QString m_basePath;
+    SqlitePictureDAO* m_database = nullptr;
+    QList<StateJournal::Record> m_pending;
+    bool m_fullRewrite = false;
+    bool m_snapshotDirty = false;
+    bool m_databaseStale = false;
+    bool m_rewriteEnabled = true;
+    quint64 m_requested = 0;
+    quint64 m_completed = 0;
+    int m_commitCount = 0;
+};
+
+#endif // PERSISTENCEWRITER_H
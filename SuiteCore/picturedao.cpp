@@ -7,10 +7,18 @@
  *
  * Notas:
  * - Las funciones devuelven QList<Picture> o bool según correspondan.
+ * - Las lecturas usan CatalogParser, que reparte el análisis entre varios hilos.
  * - Se usan qWarning/qDebug para mensajes de diagnóstico cuando hay errores de I/O.
+ * - Las escrituras usan QSaveFile: el fichero anterior solo se sustituye si la
+ *   escritura completa tuvo éxito.
+ * - Las escrituras pueden comprimirse con gzip; las lecturas detectan gzip/zlib por
+ *   los bytes mágicos, sea cual sea la extensión.
  */
 
 #include "PictureDAO.h"
+#include "catalogparser.h"
+#include "compresseddevice.h"
+#include "pictureschema.h"
 #include <QFile>
 #include <QFileInfo>
 #include <QJsonDocument>
@@ -18,42 +26,95 @@
 #include <QJsonObject>
 #include <QDebug>
 #include <QDir>
+#include <QSaveFile>
+
+namespace {
+
+/**
+ * @brief Escribe un documento JSON con QSaveFile, opcionalmente comprimido con gzip.
+ */
+bool writeJson(const QJsonDocument& doc, const QString& filepath, bool compress)
+{
+    QSaveFile file(filepath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "No se pudo guardar el JSON:" << filepath;
+        return false;
+    }
+
+    if (compress) {
+        DeflateDevice gzip(&file);
+        const QByteArray json = doc.toJson(QJsonDocument::Compact);
+        if (!gzip.open(QIODevice::WriteOnly) || gzip.write(json) != json.size() || !gzip.finish()) {
+            qWarning() << "No se pudo comprimir el JSON:" << filepath << gzip.errorString();
+            file.cancelWriting();
+            return false;
+        }
+    } else {
+        file.write(doc.toJson());
+    }
+    return file.commit();
+}
+
+/**
+ * @brief Lee un fichero en formato binario de PictureSerializer.
+ * @return false si el fichero no tiene cabecera binaria (debe tratarse como JSON).
+ */
+bool loadBinary(const QString& filepath, QList<Picture>& pictures)
+{
+    QFile file(filepath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    if (PictureSerializer::detect(file.peek(4)) == PictureSerializer::Json) return false;
+
+    bool ok = false;
+    pictures = PictureSerializer::deserialize(file.readAll(), &ok);
+    if (!ok) qWarning() << "Fichero binario invalido:" << filepath;
+    return true;
+}
+
+} // namespace
 
 /**
  * @brief Guarda una lista de Picture en un fichero JSON.
  *
- * Cada Picture se mapea a un objeto JSON con las siguientes claves:
- * - "nombre", "url", "descripcion", "favorito", "descargada", "expirationDate" (opcional).
+ * Cada Picture se mapea a un objeto JSON con las claves de PictureSchema (ámbito State):
+ * - "nombre", "url", "descripcion", "favorito", "descargada", "filePath",
+ *   "expirationDate" (opcional, ISO YYYY-MM-DD).
  *
  * @param pictures Lista de objetos Picture a serializar.
  * @param filepath Ruta completa del fichero donde se guardará el JSON.
+ * @param compress true para escribir el JSON comprimido con gzip.
  * @return true si el fichero se escribió correctamente; false en caso de error de I/O.
  */
-bool PictureDAO::savePictures(const QList<Picture>& pictures, const QString& filepath)
+bool PictureDAO::savePictures(const QList<Picture>& pictures, const QString& filepath,
+                              bool compress)
 {
     QJsonArray array;
-    for (const Picture& pic : pictures) {
-        QJsonObject obj;
-        obj["nombre"] = pic.nombre();
-        obj["url"] = pic.url();
-        obj["descripcion"] = pic.descripcion();
-        obj["favorito"] = pic.favorito();
-        obj["descargada"] = pic.descargada();
-        if (pic.expirationDate().isValid())
-            obj["expirationDate"] = pic.expirationDate().toString(Qt::ISODate); // ISO (YYYY-MM-DD)
-        array.append(obj);
-    }
+    for (const Picture& pic : pictures)
+        array.append(PictureSchema::toJson(pic, PictureSchema::State));
 
-    QJsonDocument doc(array);
-    QFile file(filepath);
+    return writeJson(QJsonDocument(array), filepath, compress);
+}
+
+/**
+ * @brief Guarda una lista de Picture en un formato binario (CBOR o QDataStream).
+ *
+ * Los ficheros resultantes se pueden leer con loadPictures() y loadDownloaded(),
+ * que detectan el formato por la cabecera.
+ *
+ * @param format Formato de PictureSerializer.
+ * @return true si el fichero se escribió correctamente.
+ */
+bool PictureDAO::exportPictures(const QList<Picture>& pictures, const QString& filepath,
+                                PictureSerializer::Format format)
+{
+    QSaveFile file(filepath);
     if (!file.open(QIODevice::WriteOnly)) {
-        qWarning() << "No se pudo guardar el JSON:" << filepath;
+        qWarning() << "No se pudo guardar:" << filepath;
         return false;
     }
 
-    file.write(doc.toJson());
-    file.close();
-    return true;
+    file.write(PictureSerializer::serialize(pictures, format));
+    return file.commit();
 }
 
 /**
@@ -61,125 +122,67 @@ bool PictureDAO::savePictures(const QList<Picture>& pictures, const QString& fil
  *
  * Se espera que el documento JSON sea un array de objetos con las mismas claves que
  * produce savePictures(). Si el fichero no puede abrirse o el JSON no es un array,
- * se devuelve una lista vacía.
+ * se devuelve una lista vacía. El análisis lo hace CatalogParser en varios hilos.
+ * Los ficheros escritos con exportPictures() (CBOR o QDataStream) también se aceptan.
  *
  * @param filepath Ruta del fichero JSON a leer.
  * @return QList<Picture> con los objetos cargados (puede estar vacío).
  */
 QList<Picture> PictureDAO::loadPictures(const QString& filepath)
 {
-    QList<Picture> list;
-    QFile file(filepath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning() << "No se pudo abrir el JSON:" << filepath;
-        return list;
-    }
+    QList<Picture> pictures;
+    if (loadBinary(filepath, pictures)) return pictures;
 
-    QByteArray data = file.readAll();
-    file.close();
-
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isArray()) return list;
-
-    QJsonArray array = doc.array();
-    for (auto value : array) {
-        QJsonObject obj = value.toObject();
-        Picture pic(obj["nombre"].toString(),
-                    obj["url"].toString(),
-                    obj["descripcion"].toString());
-        pic.setFavorito(obj["favorito"].toBool());
-        pic.setDescargada(obj["descargada"].toBool());
-
-        // Leer fecha de caducidad si existe (ISO date)
-        if (obj.contains("expirationDate")) {
-            QDate date = QDate::fromString(obj["expirationDate"].toString(), Qt::ISODate);
-            pic.setExpirationDate(date);
-        }
-
-        list.append(pic);
-    }
-    return list;
+    // Análisis en paralelo sobre el fichero proyectado en memoria
+    return CatalogParser::parseFile(filepath, CatalogParser::AllFields);
 }
 
 /**
  * @brief Carga un catálogo (lista de Pictures) desde un fichero JSON.
  *
  * Función similar a loadPictures pero pensada para catálogos (no lee flags ni fechas
- * adicionales salvo nombre/url/descripcion). Se registran mensajes de depuración con
- * información sobre la apertura del fichero.
+ * adicionales salvo nombre/url/descripcion). El fichero se analiza con CatalogParser
+ * (índice estructural vectorizado + conversión en paralelo). Se registran mensajes de
+ * depuración con información sobre la apertura del fichero.
  *
  * @param filepath Ruta del fichero JSON del catálogo.
  * @return QList<Picture> con los elementos del catálogo (vacío si error).
  */
 QList<Picture> PictureDAO::loadCatalog(const QString& filepath)
 {
-    QList<Picture> list;
-    QFile file(filepath);
     qDebug() << "Intentando abrir catalogo:" << filepath;
-    qDebug() << "¿Existe el archivo?" << file.exists();
+    qDebug() << "¿Existe el archivo?" << QFile::exists(filepath);
 
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning() << "No se pudo abrir catalogo:" << filepath
-                   << "Error:" << file.errorString();
-        return list;
-    }
-
-    QByteArray data = file.readAll();
-    file.close();
-
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isArray()) return list;
-
-    for (auto value : doc.array()) {
-        QJsonObject obj = value.toObject();
-        Picture pic(obj["nombre"].toString(),
-                    obj["url"].toString(),
-                    obj["descripcion"].toString());
-        list.append(pic);
-    }
-
-    return list;
+    return CatalogParser::parseFile(filepath, CatalogParser::CatalogFields);
 }
 
 /**
  * @brief Guarda el estado de las imágenes descargadas en un fichero JSON.
  *
- * Solo se serializan las Picture cuya propiedad descargada() es true. Si la imagen
- * no tiene fecha de caducidad válida, se añade una fecha por defecto a 7 días
- * desde la fecha actual.
+ * Solo se serializan las Picture cuya propiedad descargada() es true, con todos los
+ * campos del ámbito State (incluidos filePath y expirationDate). La URL se guarda
+ * relativa al directorio del fichero.
  *
  * @param pictures Lista completa de Picture; se filtrarán las descargadas.
  * @param filepath Ruta del fichero donde se guardará el estado.
+ * @param compress true para escribir el JSON comprimido con gzip.
  * @return true si la escritura tuvo éxito; false en caso contrario.
  */
-bool PictureDAO::saveDownloaded(const QList<Picture>& pictures, const QString& filepath)
+bool PictureDAO::saveDownloaded(const QList<Picture>& pictures, const QString& filepath,
+                                bool compress)
 {
     QJsonArray array;
     QDir baseDir(QFileInfo(filepath).absolutePath());
 
-    for (const Picture& pic : pictures) {
+    for (Picture pic : pictures) {
         if (!pic.descargada()) continue;
 
-        QJsonObject obj;
-        obj["nombre"] = pic.nombre();
-
         // Convertir ruta absoluta a relativa
-        QString relativePath = baseDir.relativeFilePath(pic.url());
-        obj["url"] = relativePath;
-
-        obj["descripcion"] = pic.descripcion();
-        obj["descargada"] = pic.descargada();
-        obj["favorito"] = pic.favorito();
-
-        array.append(obj);
+        pic.setUrl(baseDir.relativeFilePath(pic.url()));
+        array.append(PictureSchema::toJson(pic, PictureSchema::State));
     }
 
-    QJsonDocument doc(array);
-    QFile file(filepath);
-    if (!file.open(QIODevice::WriteOnly)) return false;
-
-    file.write(doc.toJson());
-    return true;
+    return writeJson(QJsonDocument(array), filepath, compress);
 }
 
 /**
@@ -193,39 +196,13 @@ bool PictureDAO::saveDownloaded(const QList<Picture>& pictures, const QString& f
  */
 QList<Picture> PictureDAO::loadDownloaded(const QString& filepath)
 {
-    QList<Picture> list;
-    QFile file(filepath);
-
-    if (!file.open(QIODevice::ReadOnly)) {
+    if (!QFile::exists(filepath)) {
         qWarning() << "No se pudo abrir descargadas:" << filepath;
-        return list;
+        return QList<Picture>();
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    file.close();
-
-    if (!doc.isArray()) return list;
-
-    for (const QJsonValue &value : doc.array()) {
-        QJsonObject obj = value.toObject();
-
-        Picture pic(
-            obj["nombre"].toString(),
-            obj["url"].toString(),
-            obj["descripcion"].toString()
-            );
-
-        pic.setDescargada(obj["descargada"].toBool());
-        pic.setFavorito(obj["favorito"].toBool());
-
-        // Leer fecha de caducidad si existe (ISO date)
-        if (obj.contains("expirationDate")) {
-            QDate date = QDate::fromString(obj["expirationDate"].toString(), Qt::ISODate);
-            pic.setExpirationDate(date);
-        }
-
-        list.append(pic);
-    }
+    QList<Picture> pictures;
+    if (loadBinary(filepath, pictures)) return pictures;
 
-    return list;
+    return CatalogParser::parseFile(filepath, CatalogParser::AllFields);
 }
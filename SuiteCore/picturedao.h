@@ -2,20 +2,27 @@
 #define PICTUREDAO_H
 
 #include "Picture.h"
+#include "pictureserializer.h"
+#include "SuiteCore_global.h"
 #include <QString>
 #include <QList>
 
-class PictureDAO
+class SUITECORE_EXPORT PictureDAO
 {
 public:
-    // Guarda la lista de imágenes en JSON
-    static bool savePictures(const QList<Picture>& pictures, const QString& filepath);
+    // Guarda la lista de imágenes en JSON (compress = gzip; la lectura lo detecta sola)
+    static bool savePictures(const QList<Picture>& pictures, const QString& filepath,
+                             bool compress = false);
     static QList<Picture> loadCatalog(const QString& filepath);
+    // Copia en CBOR o QDataStream; las cargas detectan el formato por la cabecera
+    static bool exportPictures(const QList<Picture>& pictures, const QString& filepath,
+                               PictureSerializer::Format format);
 
 
     // Carga la lista de imágenes desde JSON
     static QList<Picture> loadPictures(const QString& filepath);
-    static bool saveDownloaded(const QList<Picture>& pictures, const QString& filepath);
+    static bool saveDownloaded(const QList<Picture>& pictures, const QString& filepath,
+                               bool compress = false);
     static QList<Picture> loadDownloaded(const QString& filepath);
 };
 
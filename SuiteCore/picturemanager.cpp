@@ -2,36 +2,129 @@
  * @file PictureManager.cpp
  * @brief Gestión en memoria y persistencia de objetos Picture.
  *
- * Esta clase actúa como un servicio central que mantiene la lista de imágenes
- * (m_pictures), delega la carga/guardado en PictureDAO y expone métodos para
+ * Esta clase actúa como un servicio central que mantiene las imágenes en un
+ * almacén columnar (PictureStore), delega la carga/guardado en PictureDAO y expone métodos para
  * descargar, marcar como favorito y eliminar imágenes descargadas.
  *
- * Las operaciones que simulan progreso usan QTimer para emitir señales
- * (downloadProgress, pictureDownloaded, pictureRemoved).
+ * Las descargas son reales y asíncronas: DownloadEngine (QNetworkAccessManager en
+ * su propio hilo, http:// y file://) transfiere sin ocupar un hilo por imagen y
+ * PictureManager confirma cada una al terminar (downloadProgress, pictureDownloaded).
+ * El borrado todavía simula su progreso (pictureRemoved).
  *
- * Nota: los métodos que modifican el estado guardan automáticamente el fichero
- * de descargadas mediante saveDownloaded(getDownloadedJsonPath()).
+ * El catálogo se publica como versiones inmutables (estilo RCU): m_snapshot apunta a
+ * un PictureStore constante y se lee y sustituye con std::atomic_load/atomic_store.
+ * - Los lectores (snapshot(), picture(), las vistas) nunca toman m_mutex y siempre
+ *   ven una versión coherente, aunque se publique otra mientras la recorren.
+ * - Los escritores se serializan con m_mutex, copian la versión actual (barato: las
+ *   columnas se comparten de forma implícita), aplican todos sus cambios y publican
+ *   el resultado una sola vez.
+ * - Los cambios de estado que llegan desde muchos hilos (descargas y borrados que
+ *   terminan, favoritos) no compiten por m_mutex uno a uno: commit() los agrupa y un
+ *   solo hilo aplica cada tanda. Ningún bloqueo se mantiene durante E/S o al emitir.
+ * - Las tareas en curso están en un ConcurrentIdSet con bloqueos por fragmento.
+ * - Una versión antigua se libera cuando la suelta su último lector (shared_ptr).
+ *
+ * Las imágenes se identifican con un PictureId compacto que se asigna al cargarlas
+ * (assignIds()). Todas las señales y operaciones usan ese id: no se copian nombres ni
+ * URLs entre hilos y dos imágenes con el mismo nombre no se confunden. El id de una
+ * URL se conserva entre recargas del catálogo.
+ *
+ * La caducidad no se calcula al consultar: ExpirationScheduler agrupa las imágenes por
+ * día de caducidad y, al llegar cada día, onPicturesExpired() marca el bit Expired de
+ * esas filas en una sola versión y emite picturesExpired() con sus ids.
+ *
+ * Nota: los métodos que modifican el estado no reescriben downloaded.json; añaden un
+ * registro al diario (StateJournal, downloaded.journal). El diario se reproduce en
+ * loadDownloaded() y se compacta en downloaded.json al superar un tamaño o
+ * antigüedad máximos. Toda esa E/S la realiza PersistenceWriter en su propio hilo,
+ * agrupando los cambios; al cerrar, flush() confirma lo pendiente.
  */
 
 #include "PictureManager.h"
 #include "PictureDAO.h"
+#include "catalogparser.h"
+#include "catalogreader.h"
+#include "catalogsnapshot.h"
+#include "compresseddevice.h"
+#include "sqlitepicturedao.h"
 #include <QDir>
+#include <QFile>
+#include <QFuture>
+#include <QFileSystemWatcher>
+#include <QHash>
 #include <QJsonArray>
 #include <QJsonDocument>
-#include <QJsonObject>
+#include <QSaveFile>
 #include <QTimer>
 #include <QDate>
 #include <QDebug>
-#include <QThread>
 #include <QMutexLocker>
-#include <QRandomGenerator>
 #include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
 
 /**
  * @brief Constructor.
  * @param parent Objeto padre (por defecto nullptr).
  */
-PictureManager::PictureManager(QObject* parent) : QObject(parent) {}
+PictureManager::PictureManager(QObject* parent)
+    : QObject(parent),
+    m_snapshot(std::make_shared<const PictureStore>()),
+    m_writer(&m_journal)
+{
+    // Conexiones en cola (progreso desde hilos del pool) con el nombre del typedef
+    qRegisterMetaType<PictureId>("PictureId");
+    qRegisterMetaType<QVector<PictureId>>("QVector<PictureId>");
+
+    // El hilo de escritura serializa siempre una versión coherente
+    m_writer.setSnapshotProvider([this]() {
+        return snapshot()->toList();
+    });
+
+    connect(&m_expiration, &ExpirationScheduler::expired,
+            this, &PictureManager::onPicturesExpired);
+
+    // El motor emite desde su hilo de red: el progreso se reenvía tal cual y el final
+    // se procesa aquí (conexión en cola al hilo del objeto)
+    connect(&m_engine, &DownloadEngine::progress, this, [this](PictureId id, int percent) {
+        emit downloadProgress(percent, id);
+    });
+    connect(&m_engine, &DownloadEngine::finished, this, &PictureManager::onTransferFinished);
+    connect(&m_engine, &DownloadEngine::held, this, &PictureManager::downloadPaused);
+    connect(&m_engine, &DownloadEngine::queueChanged, this, &PictureManager::downloadQueueChanged);
+
+    // Terminaciones de downloadMany() que llegan juntas: una sola picturesDownloaded()
+    m_bulkTimer = new QTimer(this);
+    m_bulkTimer->setSingleShot(true);
+    m_bulkTimer->setInterval(BulkNotifyMs);
+    connect(m_bulkTimer, &QTimer::timeout, this, [this]() {
+        QVector<PictureId> ids;
+        ids.swap(m_finishedBulk);
+        if (!ids.isEmpty()) emit picturesDownloaded(ids);
+    });
+
+    m_pendingTimer = new QTimer(this);
+    m_pendingTimer->setSingleShot(true);
+    m_pendingTimer->setInterval(PendingSaveMs);
+    connect(m_pendingTimer, &QTimer::timeout, this, &PictureManager::savePendingDownloads);
+}
+
+/**
+ * @brief Destructor. Cancela una carga asíncrona en curso, espera a que terminen ella
+ * y las recargas del catálogo, y guarda la lista de descargas pendientes.
+ *
+ * Definido aquí porque SqlitePictureDAO solo se declara en la cabecera.
+ */
+PictureManager::~PictureManager()
+{
+    m_loadCancelled.storeRelease(1);
+    m_loadFuture.waitForFinished();
+    for (QFuture<void>& reload : m_reloads)
+        reload.waitForFinished();
+
+    // Lo que quede en la cola se reanuda en la próxima sesión (resumeDownloads());
+    // las transferencias a medias guardan su .part al destruirse m_engine
+    savePendingDownloads();
+}
 
 /**
  * @brief Establece la ruta base donde se guardan las imágenes y el JSON.
@@ -39,6 +132,23 @@ PictureManager::PictureManager(QObject* parent) : QObject(parent) {}
  */
 void PictureManager::setBasePath(const QString& path) {
     m_basePath = path;
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        m_carriedPending.clear();
+        m_carriedRead = false;
+    }
+    m_journal.setPath(m_basePath + "/downloaded.journal");
+    m_writer.setTargetPath(getDownloadedJsonPath());
+    m_writer.setCatalogPath(m_catalogPath, m_basePath);
+}
+
+/**
+ * @brief Fija el catálogo en uso; el hilo de escritura renueva su instantánea.
+ */
+void PictureManager::setCatalogPath(const QString& path)
+{
+    m_catalogPath = path;
+    m_writer.setCatalogPath(path, m_basePath);
 }
 
 /**
@@ -49,14 +159,23 @@ QString PictureManager::getDownloadedJsonPath() const {
     return m_basePath + "/downloaded.json";
 }
 
+/**
+ * @brief Ruta de la lista de descargas pendientes (URLs del catálogo, JSON).
+ */
+QString PictureManager::getPendingDownloadsPath() const {
+    return m_basePath + "/downloads.pending";
+}
+
 /**
  * @brief Carga un catálogo desde un fichero JSON y lo une al listado interno.
  *
- * Para cada Picture del catálogo se añade a m_pictures únicamente si no existe
- * ya una entrada con la misma URL (evita duplicados).
+ * El fichero se lee de forma incremental con CatalogReader: los Picture se crean a
+ * medida que se delimitan los objetos del array, sin construir el documento JSON
+ * completo. Durante la lectura se emite catalogLoadProgress(0-100). Los catálogos
+ * comprimidos con gzip o zlib se leen a través de InflateDevice.
  *
  * @param filepath Ruta del JSON de catálogo.
- * @return true Siempre devuelve true (la función no reporta errores a nivel API).
+ * @return true si el catálogo se leyó completo; false si no se pudo abrir o es inválido.
  */
 bool PictureManager::loadCatalog(const QString& filepath)
 {
@@ -66,27 +185,53 @@ bool PictureManager::loadCatalog(const QString& filepath)
         return false;
     }
 
-    QByteArray data = file.readAll();
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isArray()) return false;
+    // Catálogos .json.gz / zlib: se descomprimen en streaming (detección por bytes mágicos)
+    QScopedPointer<InflateDevice> inflater;
+    if (InflateDevice::isCompressed(&file)) {
+        inflater.reset(new InflateDevice(&file));
+        if (!inflater->open(QIODevice::ReadOnly)) {
+            qWarning() << "No se pudo descomprimir el catalogo:" << filepath << inflater->errorString();
+            return false;
+        }
+    }
 
-    QJsonArray array = doc.array();
-    m_pictures.clear();
+    // Se construye en una lista aparte para no perder el catálogo actual si el JSON es inválido
+    CatalogReader reader(inflater ? static_cast<QIODevice*>(inflater.data()) : &file);
+    const qint64 fileSize = file.size();
+    QList<Picture> pictures;
+    Picture pic;
+    int lastProgress = -1;
 
-    for (auto value : array) {
-        QJsonObject obj = value.toObject();
+    while (reader.readNext(pic)) {
+        // Convertir la URL relativa del JSON a ruta absoluta
+        pic.setUrl(resolveImagePath(pic.url()));
+        pictures.append(pic);
 
-        // Obtener URL relativa del JSON
-        QString relativeUrl = obj["url"].toString();
+        // Comprimido: el progreso se mide sobre los bytes comprimidos consumidos
+        const int progress = inflater && fileSize > 0
+                                 ? static_cast<int>(file.pos() * 100 / fileSize)
+                                 : reader.progress();
+        if (progress != lastProgress) {
+            lastProgress = progress;
+            emit catalogLoadProgress(progress);
+        }
+    }
 
-        // Convertir a ruta absoluta
-        QString absoluteUrl = resolveImagePath(relativeUrl);
+    if (reader.hasError()) {
+        qWarning() << "Catalogo invalido:" << filepath << reader.errorString();
+        return false;
+    }
 
-        Picture pic(obj["nombre"].toString(),
-                    absoluteUrl,  // Usar ruta absoluta
-                    obj["descripcion"].toString());
-        m_pictures.append(pic);
+    {
+        QMutexLocker locker(&m_mutex);
+        PictureStore next;
+        next.append(pictures);
+        assignIds(next, 0);
+        m_expiration.reset(next);
+        publish(std::move(next));
     }
+    setCatalogPath(filepath);
+    emit catalogLoadProgress(100);
     return true;
 }
 
@@ -94,266 +239,1413 @@ bool PictureManager::loadCatalog(const QString& filepath)
  * @brief Carga el estado de las imágenes descargadas y actualiza los objetos internos.
  *
  * Para cada Picture cargada desde el JSON de descargadas, se busca el Picture
- * correspondiente en m_pictures (por URL) y se actualizan sus flags y filePath.
+ * correspondiente (por URL) y se actualizan sus flags y filePath; con el diario
+ * aplicado, el resultado se publica como una sola versión. Después se escribe la
+ * instantánea binaria (ver loadSnapshot()).
  *
  * @param filepath Ruta del JSON de descargadas.
  * @return true Siempre devuelve true (no se expone error en la firma).
  */
 bool PictureManager::loadDownloaded(const QString& filepath) {
-    QList<Picture> downloadedPics = PictureDAO::loadDownloaded(filepath);
-    for (const Picture& pic : downloadedPics) {
-        for (Picture& existing : m_pictures) {
-            if (existing.url() == pic.url()) {
-                existing.setDescargada(true);
-                existing.setFavorito(pic.favorito());
-                existing.setFilePath(pic.filePath());
-                break;
-            }
+    const QList<Picture> downloadedPics = PictureDAO::loadDownloaded(filepath);
+    const QList<StateJournal::Record> records = m_journal.replay();
+    {
+        QMutexLocker locker(&m_mutex);
+        PictureStore next = *snapshot();
+        for (const Picture& pic : downloadedPics) {
+            // downloaded.json guarda rutas relativas a basePath; el almacén tiene rutas absolutas
+            const int row = next.rowOfUrl(resolveImagePath(pic.url()));
+            if (row < 0) continue;
+
+            next.setFlag(PictureStore::Downloaded, row, true);
+            next.setFlag(PictureStore::Favorite, row, pic.favorito());
+            next.setFilePath(row, pic.filePath());
+            if (pic.expirationDate().isValid())
+                next.setExpirationDate(row, pic.expirationDate());
         }
+
+        // Cambios posteriores al último volcado de downloaded.json
+        applyJournal(next, records);
+        m_expiration.reset(next);
+        publish(std::move(next));
     }
+
+    // Catálogo y estado ya fusionados: guardar la instantánea para el próximo arranque
+    if (!m_catalogPath.isEmpty())
+        saveSnapshot(m_catalogPath, filepath);
     return true;
 }
 
 /**
- * @brief Guarda el estado actual de las imágenes descargadas en el JSON correspondiente.
- * @param filepath Ruta destino donde persistir las descargadas.
- * @return true si la operación de escritura tuvo éxito, false en caso contrario.
+ * @brief Carga el catálogo desde la instantánea binaria, si sigue siendo válida.
+ *
+ * La instantánea es válida cuando el tamaño, la fecha de modificación y el hash de
+ * ambos JSON coinciden con los registrados al escribirla. Si no lo es, el llamador
+ * debe usar loadCatalog() + loadDownloaded().
+ *
+ * @param catalogPath Ruta del JSON de catálogo.
+ * @param downloadedPath Ruta del JSON de descargadas.
+ * @return true si el catálogo se ha cargado desde la instantánea.
  */
-bool PictureManager::saveDownloaded(const QString& filepath) {
-    return PictureDAO::saveDownloaded(m_pictures, filepath);
+bool PictureManager::loadSnapshot(const QString& catalogPath, const QString& downloadedPath)
+{
+    QList<Picture> pictures;
+    if (!CatalogSnapshot::read(CatalogSnapshot::pathFor(catalogPath),
+                               QStringList() << catalogPath << downloadedPath,
+                               m_basePath, pictures)) {
+        return false;
+    }
+
+    const QList<StateJournal::Record> records = m_journal.replay();
+    setCatalogPath(catalogPath);
+    {
+        QMutexLocker locker(&m_mutex);
+        PictureStore next;
+        next.append(pictures);
+        assignIds(next, 0);
+        applyJournal(next, records);
+        m_expiration.reset(next);
+        publish(std::move(next));
+    }
+    return true;
 }
 
 /**
- * @brief Simula la descarga de una imagen indicada por índice dentro de la lista "toDownload()".
+ * @brief Carga catálogo y estado en segundo plano, sin bloquear la interfaz.
  *
- * Este método:
- *  - crea un QTimer que actúa como simulador de progreso,
- *  - emite downloadProgress(progress, nombre) periódicamente,
- *  - cuando el progreso alcanza 100 marca la imagen como descargada,
- *    asigna filePath y expirationDate (si no lo tenía),
- *  - guarda el estado descargado y emite pictureDownloaded(p).
+ * Vacía la lista actual y lanza runLoad() en el pool. Las imágenes llegan al hilo
+ * principal por lotes (picturesLoaded) para que las vistas se vayan poblando mientras
+ * se analiza el resto; al terminar se emite loadFinished(). El tiempo hasta el primer
+ * lote visible se publica con firstRowsLoaded() y timeToFirstRows().
  *
- * @param index Índice relativo dentro de la lista devuelta por toDownload().
+ * Hasta loadFinished(true) la versión publicada está incompleta: PersistenceWriter no
+ * reescribe downloaded.json (ni compacta el diario) con ella, y flush() solo confirma
+ * el diario. Si la carga falla, el bloqueo se mantiene.
+ *
+ * @param catalogPath Ruta del JSON de catálogo.
+ * @param downloadedPath Ruta del JSON de descargadas.
  */
-void PictureManager::downloadPicture(const Picture &picture, int seconds) {
-    QString targetUrl = picture.url();
-    QString targetName = picture.nombre();
+void PictureManager::loadAsync(const QString& catalogPath, const QString& downloadedPath)
+{
+    m_loadCancelled.storeRelease(1);
+    m_loadFuture.waitForFinished();
+    m_loadCancelled.storeRelease(0);
+    const int generation = ++m_loadGeneration;
 
-    // Evitamos doble descarga
+    m_writer.setRewriteEnabled(false);
     {
         QMutexLocker locker(&m_mutex);
-        if (m_activeTasks.contains(targetUrl))
-            return;
-        m_activeTasks.insert(targetUrl);
+        publish(PictureStore());
+        m_expiration.clear();
     }
+    setCatalogPath(catalogPath);
+    m_firstRowsMs = -1;
+    m_loadTimer.start();
 
-    // Simulación de descarga en un hilo (para no bloquear la UI)
-    QtConcurrent::run([this, picture, seconds]() mutable {
-        for (int p = 0; p <= 100; p += 5) {
-            QThread::msleep((seconds * 1000) / 20);
-            emit downloadProgress(p, picture.nombre());
+    m_loadFuture = QtConcurrent::run([this, catalogPath, downloadedPath, generation]() {
+        runLoad(catalogPath, downloadedPath, generation);
+    });
+}
+
+bool PictureManager::isLoading() const
+{
+    return m_loadFuture.isRunning();
+}
+
+/**
+ * @brief Trabajo de la carga asíncrona. Se ejecuta en un hilo del pool.
+ *
+ * - Si la instantánea binaria es válida se usa directamente.
+ * - Si no, downloaded.json se analiza en otra tarea en paralelo con la lectura en
+ *   streaming del catálogo; ambos se unen al completar el primer lote (el estado es
+ *   mucho más pequeño que el catálogo) y a partir de ahí cada lote sale ya fusionado
+ *   con el estado y con el diario.
+ *
+ * No publica versiones: el almacén y sus índices se construyen aquí, lote a lote, y
+ * cada lote se entrega al hilo principal con deliverBatch() como una copia del almacén.
+ */
+void PictureManager::runLoad(const QString& catalogPath, const QString& downloadedPath,
+                             int generation)
+{
+    const int FirstBatchSize = 200;   // primer lote pequeño: algo visible cuanto antes
+    const int BatchSize = 2000;
+    const QStringList sources = QStringList() << catalogPath << downloadedPath;
+
+    // Cambios del diario agrupados por URL, en orden
+    QHash<QString, QList<StateJournal::Record>> journal;
+    for (const StateJournal::Record& rec : m_journal.replay())
+        journal[rec.url].append(rec);
+
+    auto applyRecords = [&journal](Picture& p) {
+        const auto it = journal.constFind(p.url());
+        if (it == journal.constEnd()) return;
+        for (const StateJournal::Record& rec : it.value()) {
+            switch (rec.type) {
+            case StateJournal::Downloaded:
+                p.setDescargada(true);
+                p.setFilePath(rec.filePath);
+                p.setExpirationDate(rec.expirationDate);
+                break;
+            case StateJournal::Removed:
+                p.setDescargada(false);
+                p.setFavorito(false);
+                break;
+            case StateJournal::Favorite:
+                p.setFavorito(rec.favorito);
+                break;
+            }
         }
+    };
 
-        // Actualizar datos en la lista principal (m_pictures)
+    auto finish = [this, generation](bool ok) {
+        QMetaObject::invokeMethod(this, [this, ok, generation]() {
+            // Una carga posterior vuelve a bloquear la reescritura hasta terminar la suya
+            if (ok && generation == m_loadGeneration) {
+                if (m_database) m_writer.markDatabaseStale();
+                m_writer.setRewriteEnabled(true);
+                prunePendingDownloads();
+            }
+            emit catalogLoadProgress(100);
+            emit loadFinished(ok);
+        }, Qt::QueuedConnection);
+    };
+
+    // El almacén se construye en este hilo; assignIds() necesita m_mutex por m_idsByUrl
+    PictureStore building;
+    auto deliver = [&](const QList<Picture>& batch) {
+        if (batch.isEmpty()) return;
+        const int first = building.size();
+        building.append(batch);
         {
             QMutexLocker locker(&m_mutex);
-            for (Picture &p : m_pictures) {
-                if (p.url() == picture.url()) {
-                    p.setDescargada(true);
-                    p.setFilePath(m_basePath + "/images/" + p.nombre() + ".jpg");
-                    if (!p.expirationDate().isValid()) p.setExpirationDate(QDate::currentDate().addDays(30));
-                    saveDownloaded(getDownloadedJsonPath());
-                    emit pictureDownloaded(p);
-                    break;
-                }
+            assignIds(building, first);
+        }
+        deliverBatch(std::make_shared<const PictureStore>(building), generation);
+    };
+
+    // 1. Instantánea vigente: ya contiene catálogo y estado fusionados
+    QList<Picture> snapshot;
+    if (CatalogSnapshot::read(CatalogSnapshot::pathFor(catalogPath), sources, m_basePath, snapshot)) {
+        for (int first = 0; first < snapshot.size() && !m_loadCancelled.loadAcquire(); first += BatchSize) {
+            QList<Picture> batch = snapshot.mid(first, BatchSize);
+            for (Picture& p : batch) applyRecords(p);
+            deliver(batch);
+        }
+        if (!m_loadCancelled.loadAcquire()) finish(true);
+        return;
+    }
+
+    // 2. Estado de descargadas en paralelo con el catálogo
+    QFuture<QHash<QString, Picture>> stateFuture = QtConcurrent::run([this, downloadedPath]() {
+        QHash<QString, Picture> state;
+        for (const Picture& pic : PictureDAO::loadDownloaded(downloadedPath))
+            state.insert(resolveImagePath(pic.url()), pic);
+        return state;
+    });
+
+    QFile file(catalogPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "No se pudo abrir el JSON:" << catalogPath;
+        stateFuture.waitForFinished();
+        finish(false);
+        return;
+    }
+
+    QScopedPointer<InflateDevice> inflater;
+    if (InflateDevice::isCompressed(&file)) {
+        inflater.reset(new InflateDevice(&file));
+        if (!inflater->open(QIODevice::ReadOnly)) {
+            qWarning() << "No se pudo descomprimir el JSON:" << catalogPath;
+            stateFuture.waitForFinished();
+            finish(false);
+            return;
+        }
+    }
+
+    CatalogReader reader(inflater ? static_cast<QIODevice*>(inflater.data()) : &file);
+    const qint64 fileSize = file.size();
+    QHash<QString, Picture> state;
+    bool joined = false;
+    QList<Picture> all;
+    QList<Picture> batch;
+    Picture pic;
+    int lastProgress = -1;
+
+    auto flushBatch = [&]() {
+        if (!joined) {
+            state = stateFuture.result();
+            joined = true;
+        }
+        for (Picture& p : batch) {
+            const auto it = state.constFind(p.url());
+            if (it != state.constEnd()) {
+                p.setDescargada(true);
+                p.setFavorito(it->favorito());
+                p.setFilePath(it->filePath());
+                if (it->expirationDate().isValid())
+                    p.setExpirationDate(it->expirationDate());
             }
-            m_activeTasks.remove(picture.url());
+            applyRecords(p);
+        }
+        all.append(batch);
+        deliver(batch);
+        batch.clear();
+    };
+
+    while (!m_loadCancelled.loadAcquire() && reader.readNext(pic)) {
+        pic.setUrl(resolveImagePath(pic.url()));
+        batch.append(pic);
+        if (batch.size() >= (all.isEmpty() ? FirstBatchSize : BatchSize))
+            flushBatch();
+
+        const int progress = inflater && fileSize > 0
+                                 ? static_cast<int>(file.pos() * 100 / fileSize)
+                                 : reader.progress();
+        if (progress != lastProgress) {
+            lastProgress = progress;
+            emit catalogLoadProgress(progress);
+        }
+    }
+    if (m_loadCancelled.loadAcquire()) {
+        stateFuture.waitForFinished(); // la tarea usa 'this'
+        return;
+    }
+    flushBatch();
+
+    if (reader.hasError()) {
+        qWarning() << "Catalogo invalido:" << catalogPath << reader.errorString();
+        finish(false);
+        return;
+    }
+
+    // Catálogo y estado fusionados: instantánea para el próximo arranque
+    CatalogSnapshot::write(CatalogSnapshot::pathFor(catalogPath), all, sources, m_basePath);
+    finish(true);
+}
+
+/**
+ * @brief Entrega un lote al hilo principal: se publica una versión con las filas nuevas
+ * de 'built' y se emite picturesLoaded.
+ *
+ * 'built' es la copia del almacén que construye runLoad(). La primera entrega la
+ * adopta tal cual; las siguientes añaden sus filas nuevas a la versión publicada con
+ * PictureStore::extendFrom(), que hereda los índices de 'built' en lugar de duplicarlos
+ * y conserva los cambios hechos entretanto (favoritos, descargas). Así, el hilo
+ * principal solo trabaja en proporción al lote.
+ *
+ * Los lotes de una carga que ya se ha sustituido por otra (loadAsync() de nuevo) se
+ * descartan: 'generation' es la de la carga que los produjo.
+ *
+ * La primera entrega fija la métrica de tiempo hasta las primeras filas (medida tras
+ * emitir la señal, es decir, con las filas ya insertadas en las vistas).
+ */
+void PictureManager::deliverBatch(const std::shared_ptr<const PictureStore>& built, int generation)
+{
+    QMetaObject::invokeMethod(this, [this, built, generation]() {
+        if (generation != m_loadGeneration) return;
+
+        QList<Picture> loaded;
+        {
+            QMutexLocker locker(&m_mutex);
+            PictureStore next = *snapshot();
+            const int first = next.size();
+            if (next.isEmpty()) next = *built;
+            else next.extendFrom(*built);
+            if (next.size() == first) return;
+
+            // Las vistas reciben las imágenes ya con su PictureId
+            loaded.reserve(next.size() - first);
+            for (int row = first; row < next.size(); ++row)
+                loaded.append(next.at(row));
+            m_expiration.schedule(next, first);
+            publish(std::move(next));
+        }
+        emit picturesLoaded(loaded);
+
+        if (m_firstRowsMs < 0) {
+            m_firstRowsMs = m_loadTimer.elapsed();
+            emit firstRowsLoaded(m_firstRowsMs);
+        }
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Vigila el fichero de catálogo y lo recarga en caliente cuando cambia.
+ *
+ * Los cambios se agrupan durante medio segundo (el publicador puede escribir el
+ * fichero en varias operaciones) y después se llama a reloadCatalog(). Si el fichero
+ * se sustituye por renombrado, el watcher deja de vigilarlo: se vuelve a añadir.
+ *
+ * @param filepath Ruta del JSON de catálogo.
+ */
+void PictureManager::watchCatalog(const QString& filepath)
+{
+    if (!m_catalogWatcher) {
+        m_catalogWatcher = new QFileSystemWatcher(this);
+        m_reloadTimer = new QTimer(this);
+        m_reloadTimer->setSingleShot(true);
+        m_reloadTimer->setInterval(500);
+
+        connect(m_catalogWatcher, &QFileSystemWatcher::fileChanged, m_reloadTimer, [this]() {
+            m_reloadTimer->start();
+        });
+        connect(m_reloadTimer, &QTimer::timeout, this, [this]() {
+            const QStringList files = m_catalogWatcher->files();
+            if (!files.contains(m_catalogPath) && QFile::exists(m_catalogPath))
+                m_catalogWatcher->addPath(m_catalogPath);
+            reloadCatalog(m_catalogPath);
+        });
+    }
+
+    if (!m_catalogWatcher->files().isEmpty())
+        m_catalogWatcher->removePaths(m_catalogWatcher->files());
+    setCatalogPath(filepath);
+    m_catalogWatcher->addPath(filepath);
+}
+
+/**
+ * @brief Vuelve a leer el catálogo y aplica solo las diferencias con el actual.
+ *
+ * A diferencia de loadCatalog(), no se parte de cero: las imágenes se comparan por
+ * PictureId (URL y número de aparición, ver assignIds()), se conservan los estados de
+ * descarga y favorito, y se emiten señales con los ids añadidos, modificados (nombre
+ * o descripción) y eliminados para que las vistas se actualicen de forma incremental.
+ * Las URLs que siguen en el catálogo conservan su PictureId; las que desaparecen se
+ * olvidan. El nuevo orden es el del fichero.
+ *
+ * No bloquea: el análisis y el diff se hacen en el pool (diffCatalog()) y en el hilo
+ * del objeto solo se publica el resultado (applyCatalogDiff()). Si llega otra recarga
+ * antes de terminar, la anterior se descarta.
+ *
+ * @param filepath Ruta del JSON de catálogo.
+ */
+void PictureManager::reloadCatalog(const QString& filepath)
+{
+    const int generation = ++m_reloadGeneration;
+    startReloadTask([this, filepath, generation]() {
+        bool ok = false;
+        QList<Picture> fresh = CatalogParser::parseFile(filepath, CatalogParser::CatalogFields, &ok);
+        if (!ok) {
+            qWarning() << "No se pudo recargar el catalogo:" << filepath;
+            return;
         }
+        for (Picture& pic : fresh)
+            pic.setUrl(resolveImagePath(pic.url()));
+        diffCatalog(fresh, generation);
     });
 }
 
+/**
+ * @brief Lanza una tarea de recarga en el pool; el destructor espera a las que sigan en curso.
+ */
+void PictureManager::startReloadTask(const std::function<void()>& task)
+{
+    m_reloads.erase(std::remove_if(m_reloads.begin(), m_reloads.end(),
+                                   [](const QFuture<void>& reload) { return reload.isFinished(); }),
+                    m_reloads.end());
+    m_reloads << QtConcurrent::run(task);
+}
 
 /**
- * @brief Elimina (marca como no descargada) una imagen y simula progreso de eliminación.
+ * @brief Calcula la versión recargada y sus diferencias con la publicada. Se ejecuta en
+ * el pool.
  *
- * Busca el Picture por URL en m_pictures, simula un progreso con QTimer y cuando
- * finaliza marca la imagen como no descargada, desmarca el favorito y emite
- * pictureRemoved(m_pictures[i]) además de saveDownloaded(...).
+ * Solo toma m_mutex para asignar los ids (m_idsByUrl); el resultado se entrega al hilo
+ * del objeto con applyCatalogDiff().
+ */
+void PictureManager::diffCatalog(const QList<Picture>& fresh, int generation)
+{
+    auto diff = std::make_shared<CatalogDiff>();
+    diff->base = snapshot();
+    const PictureStore& current = *diff->base;
+
+    PictureStore next;
+    next.append(fresh);
+    {
+        QMutexLocker locker(&m_mutex);
+        assignIds(next, 0);
+    }
+
+    for (int row = 0; row < next.size(); ++row) {
+        const PictureId id = next.id(row);
+        const int old = current.rowOf(id);
+        if (old < 0) {
+            diff->added << id;
+            continue;
+        }
+
+        // Conservar el estado local de la imagen existente
+        if (current.nombre(old) != next.nombre(row) || current.descripcion(old) != next.descripcion(row))
+            diff->changed << id;
+        next.setFlag(PictureStore::Favorite, row, current.test(PictureStore::Favorite, old));
+        next.setFlag(PictureStore::Downloaded, row, current.test(PictureStore::Downloaded, old));
+        next.setFilePath(row, current.filePath(old));
+        next.setExpirationDate(row, current.expirationDate(old));
+    }
+
+    for (int row = 0; row < current.size(); ++row) {
+        if (next.rowOf(current.id(row)) >= 0) continue;
+        diff->removed << current.id(row);
+        if (next.rowOfUrl(current.url(row)) < 0) diff->forgottenUrls << current.url(row);
+    }
+    diff->next = std::make_shared<const PictureStore>(std::move(next));
+
+    QMetaObject::invokeMethod(this, [this, fresh, diff, generation]() {
+        applyCatalogDiff(fresh, *diff, generation);
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Publica una recarga calculada por diffCatalog() y emite sus señales.
  *
- * @param picture Picture a eliminar (por valor; se compara su URL).
+ * Si entretanto se ha publicado otra versión (un favorito, una descarga), el diff ya
+ * no corresponde a ella y se vuelve a calcular en el pool con el catálogo ya leído. La
+ * instantánea del catálogo se renueva en el hilo de PersistenceWriter.
  */
-void PictureManager::removeDownloaded(const Picture& picture, int seconds) {
-    QString pictureName = picture.nombre();
-    QString pictureUrl = picture.url();
+void PictureManager::applyCatalogDiff(const QList<Picture>& fresh, const CatalogDiff& diff,
+                                      int generation)
+{
+    // Una recarga posterior o una carga completa en curso sustituyen a esta
+    if (generation != m_reloadGeneration || isLoading()) return;
 
-    // 1. --- CONTROL ANTI-BUG (Clicks repetidos) ---
+    bool stale = false;
     {
         QMutexLocker locker(&m_mutex);
-        if (m_activeTasks.contains(pictureUrl)) {
-            return; // Si ya se está borrando (o descargando), ignoramos
+        stale = snapshot() != diff.base;
+        if (!stale) {
+            for (const QString& url : diff.forgottenUrls)
+                m_idsByUrl.remove(url);
+            for (PictureId id : diff.removed)
+                m_expiration.unschedule(id);
+            PictureStore next = *diff.next;
+            publish(std::move(next));
         }
-        m_activeTasks.insert(pictureUrl);
     }
+    if (stale) {
+        startReloadTask([this, fresh, generation]() { diffCatalog(fresh, generation); });
+        return;
+    }
+
+    if (!diff.removed.isEmpty()) emit picturesRemoved(diff.removed);
+    if (!diff.changed.isEmpty()) emit picturesChanged(diff.changed);
+    if (!diff.added.isEmpty()) emit picturesAdded(diff.added);
+
+    if (!diff.added.isEmpty() || !diff.changed.isEmpty() || !diff.removed.isEmpty()) {
+        m_writer.markSnapshotDirty();
+        if (m_database) m_writer.markDatabaseStale();
+    }
+}
+
+/**
+ * @brief Busca una imagen por id.
+ * @return Copia de la imagen, o un Picture vacío (url() vacía) si no existe.
+ */
+Picture PictureManager::picture(PictureId id) const
+{
+    const std::shared_ptr<const PictureStore> store = snapshot();
+    const int row = store->rowOf(id);
+    return row >= 0 ? store->at(row) : Picture();
+}
+
+/**
+ * @brief Usa una base de datos SQLite como almacenamiento de las imágenes.
+ *
+ * La primera vez se migran download.json y downloaded.json a la base de datos; en
+ * cada apertura se alinea además con download.json (syncCatalog()), para que las
+ * ediciones del catálogo lleguen a ella. Después el catálogo se carga desde la base de
+ * datos, se reproduce el diario (por si el último lote no llegó a ella) y
+ * PersistenceWriter replica en ella cada lote de cambios dentro de una transacción;
+ * las recargas del catálogo y las cargas posteriores la vuelven a alinear.
+ *
+ * Es opcional: SuiteUI trabaja con los JSON y no la abre.
+ *
+ * @param dbPath Fichero SQLite.
+ * @param catalogPath Ruta de download.json.
+ * @param downloadedPath Ruta de downloaded.json (solo para la migración).
+ * @return true si la base de datos está abierta y cargada.
+ */
+bool PictureManager::openDatabase(const QString& dbPath, const QString& catalogPath,
+                                  const QString& downloadedPath)
+{
+    QScopedPointer<SqlitePictureDAO> db(new SqlitePictureDAO(dbPath));
+    if (!db->open() || !db->migrateFromJson(catalogPath, downloadedPath, m_basePath))
+        return false;
 
-    // 2. --- SIMULACIÓN DE DESINSTALACIÓN ---
-    // Usamos pasos de 10% para que sea visualmente distinto a la descarga
-    for (int p = 0; p <= 100; p += 10) {
-        QThread::msleep((seconds * 1000) / 10);
-        emit downloadProgress(p, pictureName);
+    // Un catálogo que no se puede leer no borra nada: se usa lo que haya en la base de datos
+    bool parsed = false;
+    QList<Picture> catalog = CatalogParser::parseFile(catalogPath, CatalogParser::CatalogFields, &parsed);
+    if (parsed) {
+        for (Picture& pic : catalog)
+            pic.setUrl(resolveImagePath(pic.url()));
+        if (!db->syncCatalog(catalog)) return false;
     }
 
-    // 3. --- LIMPIEZA DE DATOS Y PERSISTENCIA ---
+    QList<Picture> pictures = db->loadAll();
+    const QList<StateJournal::Record> records = m_journal.replay();
+
+    // Ninguna confirmación en curso debe seguir usando la base de datos anterior
+    m_writer.setDatabase(nullptr);
+    m_writer.flush(QDeadlineTimer(QDeadlineTimer::Forever));
+    m_database.swap(db);
     {
         QMutexLocker locker(&m_mutex);
+        setCatalogPath(catalogPath);
+        PictureStore next;
+        next.append(pictures);
+        assignIds(next, 0);
+        applyJournal(next, records);
+        m_expiration.reset(next);
+        publish(std::move(next));
+    }
+    m_writer.setDatabase(m_database.data());
+    return true;
+}
 
-        for (int i = 0; i < m_pictures.size(); ++i) {
-            if (m_pictures[i].url() == pictureUrl) {
-                // Cambiamos el estado a "no descargada"
-                m_pictures[i].setDescargada(false);
-                m_pictures[i].setFavorito(false); // Al borrarla, quitamos el favorito
+/**
+ * @brief Base de datos en uso (nullptr si se trabaja solo con JSON).
+ */
+SqlitePictureDAO* PictureManager::database() const
+{
+    return m_database.data();
+}
 
-                // Persistimos el cambio en el JSON
-                saveDownloaded(getDownloadedJsonPath());
-                    emit downloadProgress(-1, pictureName); // -1 puede significar "sin progreso"
-                    emit pictureRemoved(m_pictures[i]);
-                    break;
-                }
-            }
+/**
+ * @brief Escribe la instantánea binaria del estado actual junto al catálogo.
+ * @param catalogPath Ruta del JSON de catálogo.
+ * @param downloadedPath Ruta del JSON de descargadas.
+ * @return true si la escritura tuvo éxito.
+ */
+bool PictureManager::saveSnapshot(const QString& catalogPath, const QString& downloadedPath) const
+{
+    return CatalogSnapshot::write(CatalogSnapshot::pathFor(catalogPath), snapshot()->toList(),
+                                  QStringList() << catalogPath << downloadedPath,
+                                  m_basePath);
+}
 
-        // 4. --- LIBERAR TAREA ---
-        m_activeTasks.remove(pictureUrl);
+/**
+ * @brief Guarda el estado actual de las imágenes descargadas en el JSON correspondiente.
+ *
+ * downloaded.json y el diario son del hilo de escritura: para esa ruta se pide una
+ * reescritura a PersistenceWriter y se espera a que la confirme. Cualquier otra ruta
+ * es una exportación y no toca el diario.
+ *
+ * @param filepath Ruta destino donde persistir las descargadas.
+ * @return true si la operación de escritura tuvo éxito, false en caso contrario.
+ */
+bool PictureManager::saveDownloaded(const QString& filepath) {
+    if (filepath == getDownloadedJsonPath()) {
+        m_writer.markDirty();
+        return m_writer.flush(QDeadlineTimer(QDeadlineTimer::Forever));
     }
+
+    // Si el fichero existente está comprimido se mantiene el formato gzip
+    const bool compress = InflateDevice::isCompressed(filepath);
+    return PictureDAO::saveDownloaded(snapshot()->toList(), filepath, compress);
 }
 
 /**
- * @brief Alterna la marca de favorito para un índice real en m_pictures.
+ * @brief Reproduce el diario de cambios sobre una versión en preparación.
  *
- * Este método cambia el flag favorito y persiste el estado inmediatamente.
+ * Los registros contienen el estado final de cada cambio (no un conmutador), por lo
+ * que aplicarlos de nuevo sobre un estado que ya los incluye no tiene efecto.
+ */
+void PictureManager::applyJournal(PictureStore& store, const QList<StateJournal::Record>& records) const
+{
+    for (const StateJournal::Record& rec : records) {
+        const int row = store.rowOfUrl(rec.url);
+        if (row < 0) continue;
+
+        switch (rec.type) {
+        case StateJournal::Downloaded:
+            store.setFlag(PictureStore::Downloaded, row, true);
+            store.setFilePath(row, rec.filePath);
+            store.setExpirationDate(row, rec.expirationDate);
+            break;
+        case StateJournal::Removed:
+            store.setFlag(PictureStore::Downloaded, row, false);
+            store.setFlag(PictureStore::Favorite, row, false);
+            break;
+        case StateJournal::Favorite:
+            store.setFlag(PictureStore::Favorite, row, rec.favorito);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Asigna ids a las filas de 'store' a partir de 'first' (lotes añadidos al final).
  *
- * @param indexReal Índice dentro de m_pictures.
+ * Se llama con m_mutex tomado. El id depende de la URL y de su número de aparición:
+ * la n-ésima fila con una URL recibe siempre el n-ésimo id de m_idsByUrl, de modo que
+ * también las URLs repetidas conservan sus ids entre recargas. Las apariciones nuevas
+ * reciben el siguiente id libre.
  */
-void PictureManager::toggleFavorite(int indexReal) {
-    if (indexReal >= 0 && indexReal < m_pictures.size()) {
-        m_pictures[indexReal].setFavorito(!m_pictures[indexReal].favorito());
-        saveDownloaded(getDownloadedJsonPath());
+void PictureManager::assignIds(PictureStore& store, int first)
+{
+    for (int i = first; i < store.size(); ++i) {
+        QVector<PictureId>& ids = m_idsByUrl[store.url(i)];
+        PictureId id = InvalidPictureId;
+        for (const PictureId candidate : qAsConst(ids)) {
+            const int row = store.rowOf(candidate);
+            if (row < 0 || row == i) {
+                id = candidate;
+                break;
+            }
+        }
+        if (id == InvalidPictureId) {
+            id = m_nextId++;
+            ids.append(id);
+        }
+        store.setId(i, id);
     }
 }
 
 /**
- * @brief Devuelve la lista de imágenes marcadas como descargadas.
- * @return QList<Picture> Lista filtrada de imágenes con descargada() == true.
+ * @brief Publica una versión nueva del catálogo (con m_mutex tomado).
+ *
+ * Los lectores que ya tenían la anterior la siguen usando; se libera al soltarla el último.
  */
-QList<Picture> PictureManager::downloaded() const {
-    QList<Picture> list;
-    for (const Picture& p : m_pictures) if (p.descargada()) list.append(p);
-    return list;
+void PictureManager::publish(PictureStore&& store)
+{
+    std::atomic_store(&m_snapshot, std::shared_ptr<const PictureStore>(
+                                       std::make_shared<PictureStore>(std::move(store))));
+}
+
+/**
+ * @brief Versión publicada actual del catálogo.
+ *
+ * No bloquea: es una carga atómica del puntero. La versión devuelta no cambia nunca.
+ */
+std::shared_ptr<const PictureStore> PictureManager::snapshot() const
+{
+    return std::atomic_load(&m_snapshot);
 }
 
 /**
- * @brief Devuelve la lista de imágenes que aún no están descargadas.
- * @return QList<Picture> Lista filtrada de imágenes con descargada() == false.
+ * @brief Id de la primera imagen con el nombre dado.
+ * @return Id, o InvalidPictureId si no existe.
  */
-QList<Picture> PictureManager::toDownload() const {
-    QList<Picture> list;
-    for (const Picture& p : m_pictures) if (!p.descargada()) list.append(p);
-    return list;
+PictureId PictureManager::idOf(const QString& name) const
+{
+    const std::shared_ptr<const PictureStore> store = snapshot();
+    const int row = store->rowOfName(name);
+    return row >= 0 ? store->id(row) : InvalidPictureId;
 }
 
 /**
- * @brief Acceso const a todas las imágenes gestionadas.
- * @return const QList<Picture>& Referencia const a la lista interna m_pictures.
+ * @brief Id de la imagen con la URL dada.
+ * @return Id, o InvalidPictureId si no existe.
  */
-const QList<Picture>& PictureManager::allPictures() const {
-    return m_pictures;
+PictureId PictureManager::idOfUrl(const QString& url) const
+{
+    const std::shared_ptr<const PictureStore> store = snapshot();
+    const int row = store->rowOfUrl(url);
+    return row >= 0 ? store->id(row) : InvalidPictureId;
 }
 
 /**
- * @brief Alterna favorito buscando por nombre.
+ * @brief Registro de diario con el estado actual de una fila tras un cambio.
+ *
+ * Sustituye a la reescritura completa de downloaded.json: applyChanges() entrega los
+ * registros de cada tanda a PersistenceWriter, que los confirma desde su hilo.
  *
- * Si se encuentra el primer elemento con el nombre dado, se alterna su flag
- * favorito y se persiste el estado.
+ * @param store Versión en preparación, ya modificada.
+ * @param row Fila cambiada.
+ * @param type Tipo de cambio.
+ */
+StateJournal::Record PictureManager::changeRecord(const PictureStore& store, int row,
+                                                  StateJournal::RecordType type)
+{
+    StateJournal::Record rec;
+    rec.type = type;
+    rec.url = store.url(row);
+    rec.favorito = store.test(PictureStore::Favorite, row);
+    rec.filePath = store.filePath(row);
+    rec.expirationDate = store.expirationDate(row);
+    return rec;
+}
+
+/**
+ * @brief Marca una fila como descargada: filePath y caducidad a 30 días si no tenía.
  *
- * @param name Nombre de la imagen a buscar.
+ * Se llama desde applyChanges() sobre la versión en preparación.
  */
-void PictureManager::toggleFavoriteByName(const QString& name) {
-    for (int i = 0; i < m_pictures.size(); ++i) {
-        if (m_pictures[i].nombre() == name) {
-            m_pictures[i].setFavorito(!m_pictures[i].favorito());
-            saveDownloaded(getDownloadedJsonPath());
-            return; // Salimos en cuanto lo encontramos
+void PictureManager::markDownloaded(PictureStore& store, int row)
+{
+    store.setFlag(PictureStore::Downloaded, row, true);
+    store.setFilePath(row, downloadPath(store.nombre(row)));
+    if (store.expirationDay(row) == PictureStore::NoDate) {
+        store.setExpirationDate(row, QDate::currentDate().addDays(30));
+        m_expiration.schedule(store.id(row), store.expirationDate(row));
+    }
+}
+
+/**
+ * @brief Marca una fila como no descargada; al borrarla también se quita el favorito.
+ */
+void PictureManager::markRemoved(PictureStore& store, int row)
+{
+    store.setFlag(PictureStore::Downloaded, row, false);
+    store.setFlag(PictureStore::Favorite, row, false);
+}
+
+/**
+ * @brief Confirma en disco todos los cambios pendientes (diario y downloaded.json).
+ * @param deadline Tiempo máximo de espera.
+ * @return true si la escritura terminó antes del plazo.
+ */
+bool PictureManager::flush(QDeadlineTimer deadline)
+{
+    return m_writer.flush(deadline);
+}
+
+/**
+ * @brief Confirma un grupo de cambios de filas junto con los de los demás hilos.
+ *
+ * Confirmación agrupada (flat combining): el grupo se encola con un bloqueo corto
+ * (m_queueMutex) y el primer hilo que encuentra libre el papel de combinador saca
+ * todo lo encolado, lo aplica sobre una sola copia del catálogo y publica una sola
+ * versión. Los demás esperan a que su grupo quede confirmado. Así, cientos de
+ * descargas que terminan a la vez pagan una copia y una publicación por tanda, no
+ * una cada una, y ningún bloqueo se mantiene durante E/S ni emisión de señales.
+ *
+ * @param changes Cambios a aplicar.
+ * @param applied Si no es nulo, recibe los ids cuyos cambios se han aplicado.
+ */
+void PictureManager::commit(const QVector<RowChange>& changes, QVector<PictureId>* applied)
+{
+    QMutexLocker locker(&m_queueMutex);
+    m_queue.append(Submission{changes, applied});
+    const quint64 ticket = ++m_enqueued;
+
+    while (m_committed < ticket) {
+        if (m_combining) {
+            m_committedCondition.wait(&m_queueMutex);
+            continue;
+        }
+
+        // Este hilo combina todo lo encolado hasta ahora (incluido su grupo)
+        m_combining = true;
+        QVector<Submission> batch;
+        batch.swap(m_queue);
+        const quint64 upTo = m_enqueued;
+        locker.unlock();
+
+        applyChanges(batch);
+
+        locker.relock();
+        m_committed = upTo;
+        m_combining = false;
+        m_committedCondition.wakeAll();
+    }
+}
+
+/**
+ * @brief Aplica una tanda de grupos sobre una copia del catálogo y la publica.
+ *
+ * Solo la llama el combinador de commit(). m_mutex (escritores) se toma únicamente
+ * para copiar, modificar y publicar; los registros se entregan a PersistenceWriter
+ * después de soltarlo.
+ */
+void PictureManager::applyChanges(QVector<Submission>& batch)
+{
+    QList<StateJournal::Record> records;
+    {
+        QMutexLocker locker(&m_mutex);
+        PictureStore next = *snapshot();
+        for (Submission& submission : batch) {
+            for (const RowChange& change : submission.changes) {
+                const int row = next.rowOf(change.id);
+                if (row < 0) continue;
+
+                switch (change.type) {
+                case StateJournal::Downloaded:
+                    markDownloaded(next, row);
+                    break;
+                case StateJournal::Removed:
+                    markRemoved(next, row);
+                    break;
+                case StateJournal::Favorite:
+                    if (next.test(PictureStore::Favorite, row) == change.favorito) continue;
+                    next.setFlag(PictureStore::Favorite, row, change.favorito);
+                    break;
+                }
+                records << changeRecord(next, row, change.type);
+                if (submission.applied) *submission.applied << change.id;
+            }
         }
+        if (records.isEmpty()) return;
+        publish(std::move(next));
     }
+    m_writer.append(records);
 }
 
 /**
- * @brief Marca como no descargada la imagen con el nombre dado y emite pictureRemoved.
+ * @brief Descarga una imagen con DownloadEngine, por el carril interactivo.
+ *
+ * No bloquea ni ocupa un hilo: reserva la imagen en las tareas en curso y pide la
+ * transferencia al motor, por delante de cualquier descarga masiva en cola. El
+ * progreso llega como downloadProgress(progress, id) y, al terminar,
+ * onTransferFinished() confirma la imagen como descargada con commit() y emite
+ * pictureDownloaded(id) (o downloadFailed() si la transferencia falla).
  *
- * Persiste el cambio y emite la señal correspondiente.
+ * Si la imagen ya espera en la cola de una descarga masiva, solo se adelanta. No hace
+ * nada si ya está descargada o tiene otra operación en curso (un borrado).
  *
- * @param name Nombre de la imagen a eliminar (marcar como no descargada).
+ * @param id Imagen a descargar.
  */
-void PictureManager::removeDownloadedByName(const QString& name) {
-    for (int i = 0; i < m_pictures.size(); ++i) {
-        if (m_pictures[i].nombre() == name) {
-            m_pictures[i].setDescargada(false);
-            m_pictures[i].setFavorito(false);
-            saveDownloaded(getDownloadedJsonPath());
-            emit pictureRemoved(m_pictures[i]);
-            return;
+void PictureManager::downloadPicture(PictureId id)
+{
+    // Evitamos doble descarga (el conjunto de tareas en curso tiene su propio bloqueo)
+    const std::shared_ptr<const PictureStore> store = snapshot();
+    const int row = store->rowOf(id);
+    if (row < 0 || store->test(PictureStore::Downloaded, row))
+        return;
+
+    if (m_activeTasks.insert(id))
+        setPending(id, store->url(row));
+    else if (!m_bulkDownloads.contains(id))
+        return;
+    startTransfer(*store, row, DownloadScheduler::Interactive);
+}
+
+/**
+ * @brief Retiene una descarga (en cola o en curso) hasta resumeDownload().
+ */
+void PictureManager::pauseDownload(PictureId id)
+{
+    m_engine.pause(id);
+}
+
+/**
+ * @brief Devuelve a la cola una descarga retenida con pauseDownload().
+ */
+void PictureManager::resumeDownload(PictureId id)
+{
+    m_engine.resume(id);
+}
+
+/**
+ * @brief Cancela una descarga pendiente o en curso; termina con downloadFailed().
+ */
+void PictureManager::cancelDownload(PictureId id)
+{
+    m_engine.cancel(id);
+}
+
+/**
+ * @brief Pausa global de la cola: lo que está en curso vuelve a la cola.
+ */
+void PictureManager::pauseAllDownloads()
+{
+    m_engine.pauseAll();
+}
+
+/**
+ * @brief Reanuda la cola y las descargas retenidas una a una.
+ */
+void PictureManager::resumeAllDownloads()
+{
+    m_engine.resumeAll();
+}
+
+/**
+ * @brief Cancela todas las descargas pendientes y en curso.
+ */
+void PictureManager::cancelAllDownloads()
+{
+    m_engine.cancelAll();
+}
+
+/**
+ * @brief Cancela las descargas de una operación masiva (downloadMany()).
+ *
+ * Solo las que siguen en el carril masivo: las pedidas con downloadPicture(), o
+ * subidas a él con un doble clic, continúan.
+ */
+void PictureManager::cancelBulkDownloads(const QVector<PictureId>& ids)
+{
+    m_engine.cancelBulk(ids);
+}
+
+/**
+ * @brief Límite de descargas masivas simultáneas (las interactivas tienen
+ * DownloadScheduler::InteractiveSlots plazas más).
+ */
+void PictureManager::setMaxConcurrentDownloads(int max)
+{
+    m_engine.setMaxInFlight(max);
+}
+
+int PictureManager::maxConcurrentDownloads() const
+{
+    return m_engine.maxInFlight();
+}
+
+int PictureManager::downloadQueueDepth() const
+{
+    return m_engine.queueDepth();
+}
+
+int PictureManager::downloadsInFlight() const
+{
+    return m_engine.inFlight();
+}
+
+bool PictureManager::isDownloadQueuePaused() const
+{
+    return m_engine.isPaused();
+}
+
+/**
+ * @brief Activa o desactiva las descargas segmentadas (HTTP Range en paralelo).
+ *
+ * Desactivadas, todo va en un solo flujo: sirve para comparar ambos modos con
+ * downloadStats() sobre el mismo catálogo.
+ */
+void PictureManager::setSegmentedDownloads(bool enabled)
+{
+    m_engine.setSegmented(enabled);
+}
+
+bool PictureManager::segmentedDownloads() const
+{
+    return m_engine.isSegmented();
+}
+
+/**
+ * @brief Caudal y tiempos hasta completar de las descargas desde resetDownloadStats().
+ */
+DownloadStats::Summary PictureManager::downloadStats() const
+{
+    return m_engine.stats();
+}
+
+void PictureManager::resetDownloadStats()
+{
+    m_engine.resetStats();
+}
+
+/**
+ * @brief Pide al motor la transferencia de una fila ya reservada en m_activeTasks.
+ */
+void PictureManager::startTransfer(const PictureStore& store, int row,
+                                   DownloadScheduler::Priority priority)
+{
+    m_engine.start(store.id(row), DownloadEngine::sourceUrl(store.url(row)),
+                   downloadPath(store.nombre(row)), priority);
+}
+
+/**
+ * @brief Ruta local donde se guarda la imagen descargada de nombre @p nombre.
+ */
+QString PictureManager::downloadPath(const QString& nombre) const
+{
+    return m_basePath + "/images/" + nombre + ".jpg";
+}
+
+/**
+ * @brief Anota (url no vacía) o quita (url vacía) una descarga pendiente.
+ *
+ * Segura desde cualquier hilo; la lista se escribe agrupada tras PendingSaveMs.
+ */
+void PictureManager::setPending(PictureId id, const QString& url)
+{
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        if (url.isEmpty()) {
+            if (!m_pending.remove(id)) return;
+        } else {
+            m_pending.insert(id, url);
         }
     }
+    QMetaObject::invokeMethod(m_pendingTimer, [this]() {
+        if (!m_pendingTimer->isActive()) m_pendingTimer->start();
+    });
 }
 
 /**
- * @brief Devuelve las imágenes que no están descargadas en un QVector (alternativa a toDownload()).
- * @return QVector<Picture> Vector con las imágenes no descargadas.
+ * @brief Escribe la lista de descargas pendientes (o la borra si no queda ninguna).
  */
-QVector<Picture> PictureManager::notDownloaded() const {
-    QVector<Picture> result;
-    for (const auto &pic : allPictures()) {  // allPictures() devuelve todas
-        if (!pic.descargada()) result.append(pic);
+void PictureManager::savePendingDownloads()
+{
+    if (m_basePath.isEmpty()) return;
+
+    QJsonArray urls;
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        readCarriedPending();
+        for (const QString& url : qAsConst(m_pending))
+            urls.append(url);
+        for (const QString& url : qAsConst(m_carriedPending))
+            urls.append(url);
+    }
+
+    const QString path = getPendingDownloadsPath();
+    if (urls.isEmpty()) {
+        QFile::remove(path);
+        return;
     }
-    return result;
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "No se pudo guardar" << path << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(urls).toJson(QJsonDocument::Compact));
+    if (!file.commit())
+        qWarning() << "No se pudo guardar" << path << file.errorString();
 }
 
 /**
- * @brief resuelve las rutas de las imagenes
- * @param relativePath
- * @return  QDir(m_basePath).filePath(relativePath); ruta obsoluta desde el basepath
+ * @brief Lee downloads.pending en m_carriedPending, una sola vez (con m_pendingMutex tomado).
+ *
+ * Hasta que se reanudan, las descargas de la sesión anterior solo están en el fichero:
+ * se leen antes de reescribirlo para no perderlas, p. ej. si la carga del catálogo
+ * falla y no se llega a llamar a resumeDownloads().
  */
+void PictureManager::readCarriedPending()
+{
+    if (m_carriedRead) return;
+    m_carriedRead = true;
 
-QString PictureManager::resolveImagePath(const QString& relativePath) const
+    QFile file(getPendingDownloadsPath());
+    if (!file.open(QIODevice::ReadOnly)) return;
+    for (const QJsonValue& url : QJsonDocument::fromJson(file.readAll()).array())
+        m_carriedPending << url.toString();
+}
+
+/**
+ * @brief Quita de la lista de pendientes las URLs que ya no están en el catálogo o que
+ * ya están descargadas.
+ *
+ * Solo se llama al terminar bien una carga completa: con un catálogo a medias o que no
+ * se pudo leer, que una URL no aparezca no significa que se haya quitado de él.
+ */
+void PictureManager::prunePendingDownloads()
 {
-    if (QFileInfo(relativePath).isAbsolute()) {
-        return relativePath;  // Ya es absoluta
+    const std::shared_ptr<const PictureStore> store = snapshot();
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        readCarriedPending();
+        const int before = m_carriedPending.size();
+        m_carriedPending.erase(std::remove_if(m_carriedPending.begin(), m_carriedPending.end(),
+                                              [&store](const QString& url) {
+                                                  const int row = store->rowOfUrl(url);
+                                                  return row < 0 || store->test(PictureStore::Downloaded, row);
+                                              }),
+                               m_carriedPending.end());
+        if (m_carriedPending.size() == before) return;
     }
+    savePendingDownloads();
+}
 
+/**
+ * @brief Vuelve a pedir las descargas que quedaron pendientes en la sesión anterior.
+ *
+ * Se llama con el catálogo ya cargado. Las que estaban en cola empiezan de cero; las
+ * que estaban a medias continúan desde su .part (DownloadEngine lo valida con HEAD).
+ * Todas van al carril masivo, como una descarga masiva. Las que no se pueden reanudar
+ * siguen en la lista: solo las descarta prunePendingDownloads().
+ *
+ * @return Número de descargas reanudadas.
+ */
+int PictureManager::resumeDownloads()
+{
+    QStringList urls;
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        readCarriedPending();
+        urls.swap(m_carriedPending);
+    }
 
-    return QDir(m_basePath).filePath(relativePath);
+    const std::shared_ptr<const PictureStore> store = snapshot();
+    QVector<PictureId> ids;
+    ids.reserve(urls.size());
+    QStringList carried;
+    for (const QString& url : qAsConst(urls)) {
+        const int row = store->rowOfUrl(url);
+        if (row >= 0 && !store->test(PictureStore::Downloaded, row))
+            ids << store->id(row);
+        else
+            carried << url;
+    }
+    {
+        QMutexLocker locker(&m_pendingMutex);
+        m_carriedPending << carried;
+    }
+    if (!ids.isEmpty()) downloadMany(ids); // pasan a m_pending con setPending()
+    return ids.size();
 }
 
-void PictureManager::downloadPictureByUrl(const QString &url, int seconds)
+/**
+ * @brief Fin de una transferencia (en el hilo del objeto, conexión en cola).
+ *
+ * Si fue bien confirma la fila como descargada (commit()), libera la tarea y avisa
+ * sin bloqueos tomados: pictureDownloaded() para las individuales y, para las de
+ * downloadMany(), una sola picturesDownloaded() por cada ráfaga de terminaciones.
+ */
+void PictureManager::onTransferFinished(PictureId id, bool ok, const QString& error)
 {
-    const auto list = toDownload();
-    for (const Picture &pic : list) {
-        if (pic.url() == url) {
-            downloadPicture(pic, seconds); //  ahora usa la versión correcta
-            return;
-        }
+    const bool bulk = m_bulkDownloads.contains(id);
+    m_bulkDownloads.remove(id);
+
+    QVector<PictureId> done;
+    if (ok) commit(QVector<RowChange>{RowChange{id, StateJournal::Downloaded, false}}, &done);
+    m_activeTasks.remove(id);
+    setPending(id, QString());
+
+    if (!ok) {
+        emit downloadFailed(id, error);
+        return;
+    }
+    if (done.isEmpty()) return; // la fila desapareció con una recarga
+
+    if (!bulk) {
+        emit pictureDownloaded(id);
+        return;
     }
+    m_finishedBulk << id;
+    if (!m_bulkTimer->isActive()) m_bulkTimer->start();
+}
+
+/**
+ * @brief Elimina (marca como no descargada) una imagen y simula progreso de eliminación.
+ *
+ * No bloquea: el progreso lo emite un temporizador (ver removeAfterDelay()). Al
+ * terminar confirma con commit() la imagen no descargada y sin favorito (con su
+ * registro en el diario) y emite pictureRemoved(id). Segura desde cualquier hilo.
+ *
+ * @param id Imagen a eliminar.
+ * @param seconds Duración simulada.
+ */
+void PictureManager::removeDownloaded(PictureId id, int seconds) {
+    // Si ya se está borrando (o descargando), se ignora
+    if (!m_activeTasks.insert(id))
+        return;
+    removeAfterDelay(QVector<PictureId>{id}, seconds, true);
+}
+
+/**
+ * @brief Alterna la marca de favorito de una imagen.
+ *
+ * Es setFavoriteMany() con un solo id: registra el cambio en el diario y emite
+ * favoritesChanged().
+ *
+ * @param id Imagen a modificar.
+ */
+void PictureManager::toggleFavorite(PictureId id) {
+    const std::shared_ptr<const PictureStore> store = snapshot();
+    const int row = store->rowOf(id);
+    if (row >= 0)
+        setFavoriteMany(QVector<PictureId>{id}, !store->test(PictureStore::Favorite, row));
+}
+
+/**
+ * @brief Descarga varias imágenes como una sola operación.
+ *
+ * Se descartan las ya descargadas o con otra operación en curso y se reservan las
+ * demás; todas entran por orden en el carril masivo del motor, que mantiene como
+ * mucho maxConcurrentDownloads() transferencias abiertas a la vez. Cada una se
+ * confirma al terminar (commit() agrupa las que terminan juntas) y se notifican con
+ * picturesDownloaded() en lugar de pictureDownloaded() por cada una.
+ *
+ * @param ids Imágenes a descargar (los repetidos se ignoran).
+ */
+void PictureManager::downloadMany(const QVector<PictureId>& ids)
+{
+    const std::shared_ptr<const PictureStore> store = snapshot();
+    for (PictureId id : ids) {
+        const int row = store->rowOf(id);
+        if (row < 0 || store->test(PictureStore::Downloaded, row) || !m_activeTasks.insert(id))
+            continue;
+        m_bulkDownloads.insert(id);
+        setPending(id, store->url(row));
+        startTransfer(*store, row, DownloadScheduler::Bulk);
+    }
+}
+
+/**
+ * @brief Elimina varias imágenes descargadas como una sola operación.
+ *
+ * Igual que removeDownloaded() simula el progreso sin bloquear (de todas a la vez).
+ * Después las confirma en un único commit() y emite downloadsRemoved() con los ids.
+ *
+ * @param ids Imágenes a eliminar (se ignoran las no descargadas o con otra operación).
+ * @param seconds Duración simulada.
+ */
+void PictureManager::removeMany(const QVector<PictureId>& ids, int seconds)
+{
+    const std::shared_ptr<const PictureStore> store = snapshot();
+    QVector<PictureId> accepted;
+    accepted.reserve(ids.size());
+    for (PictureId id : ids) {
+        const int row = store->rowOf(id);
+        if (row < 0 || !store->test(PictureStore::Downloaded, row) || !m_activeTasks.insert(id))
+            continue;
+        accepted << id;
+    }
+    if (!accepted.isEmpty()) removeAfterDelay(accepted, seconds, false);
+}
+
+/**
+ * @brief Simula el progreso de borrado de 'ids' y después lo confirma.
+ *
+ * Un QTimer en el hilo del objeto emite el progreso en pasos del 10% cada seconds/10
+ * (en lugar de dormir el hilo llamante, que puede ser el de la interfaz). Al llegar
+ * al 100% se confirma el borrado en un commit() y se liberan las tareas.
+ *
+ * @param single true para notificar con pictureRemoved() (una imagen), false para
+ *        downloadsRemoved() (operación masiva).
+ */
+void PictureManager::removeAfterDelay(const QVector<PictureId>& ids, int seconds, bool single)
+{
+    QMetaObject::invokeMethod(this, [this, ids, seconds, single]() {
+        QTimer* timer = new QTimer(this);
+        timer->setInterval((seconds * 1000) / 10);
+        auto progress = std::make_shared<int>(0);
+        connect(timer, &QTimer::timeout, this, [this, timer, ids, single, progress]() {
+            for (PictureId id : ids)
+                emit downloadProgress(*progress, id);
+            *progress += 10;
+            if (*progress <= 100) return;
+
+            timer->stop();
+            timer->deleteLater();
+
+            QVector<RowChange> changes;
+            changes.reserve(ids.size());
+            for (PictureId id : ids)
+                changes << RowChange{id, StateJournal::Removed, false};
+            QVector<PictureId> done;
+            commit(changes, &done);
+            for (PictureId id : ids)
+                m_activeTasks.remove(id);
+
+            if (done.isEmpty()) return;
+            if (single) {
+                emit downloadProgress(-1, ids.first()); // -1: sin progreso
+                emit pictureRemoved(ids.first());
+            } else {
+                emit downloadsRemoved(done);
+            }
+        });
+        timer->start();
+    });
+}
+
+/**
+ * @brief Fija la marca de favorito de varias imágenes en una sola confirmación.
+ *
+ * Solo cuentan las que cambian: se confirman con un commit() y se emite
+ * favoritesChanged() con sus ids.
+ *
+ * @param ids Imágenes a modificar.
+ * @param favorite Nuevo valor de la marca.
+ */
+void PictureManager::setFavoriteMany(const QVector<PictureId>& ids, bool favorite)
+{
+    QVector<RowChange> changes;
+    changes.reserve(ids.size());
+    for (PictureId id : ids)
+        changes << RowChange{id, StateJournal::Favorite, favorite};
+
+    QVector<PictureId> changed;
+    commit(changes, &changed);
+    if (!changed.isEmpty()) emit favoritesChanged(changed);
+}
+
+/**
+ * @brief Indica si una imagen está caducada (bit Expired de la versión actual).
+ *
+ * No compara fechas: el bit lo mantiene ExpirationScheduler al cambiar de día.
+ */
+bool PictureManager::isExpired(PictureId id) const
+{
+    const std::shared_ptr<const PictureStore> store = snapshot();
+    const int row = store->rowOf(id);
+    return row >= 0 && store->test(PictureStore::Expired, row);
 }
 
-void PictureManager::downloadPicture(int index)
+/**
+ * @brief Caducidades entregadas por ExpirationScheduler: se publica una versión con el
+ * bit Expired de esas filas y se emite picturesExpired() (fuera de m_mutex).
+ *
+ * @param ids Imágenes cuyo día de caducidad acaba de llegar.
+ */
+void PictureManager::onPicturesExpired(const QVector<PictureId>& ids)
 {
-    const auto list = toDownload();
-    if (index < 0 || index >= list.size()) return;
+    QVector<PictureId> expired;
+    {
+        QMutexLocker locker(&m_mutex);
+        PictureStore next = *snapshot();
+        expired = next.expire(QDate::currentDate(), ids);
+        if (expired.isEmpty()) return;
+        publish(std::move(next));
+    }
+    emit picturesExpired(expired);
+}
 
-    int randomSeconds = QRandomGenerator::global()->bounded(10, 61);
-    downloadPicture(list[index], randomSeconds); //  usa la versión correcta
+/**
+ * @brief Imágenes marcadas como descargadas.
+ *
+ * Vista sobre el bitset Downloaded de la versión actual: no copia ni reserva memoria
+ * y su size() es O(1). El conjunto se mantiene al cambiar cada flag, no al consultarlo.
+ * @return PictureView Filas con descargada() == true, en orden.
+ */
+PictureView PictureManager::downloaded() const {
+    return PictureView(snapshot(), PictureStore::Downloaded, true);
 }
 
-void PictureManager::downloadPicture(int index, int seconds) {
-    const auto list = toDownload();
-    if (index < 0 || index >= list.size()) return;
-    downloadPicture(list.at(index), seconds);
+/**
+ * @brief Imágenes que aún no están descargadas (vista sin copia, ver downloaded()).
+ * @return PictureView Filas con descargada() == false, en orden.
+ */
+PictureView PictureManager::toDownload() const {
+    return PictureView(snapshot(), PictureStore::Downloaded, false);
+}
+
+/**
+ * @brief Imágenes marcadas como favoritas (vista sin copia, ver downloaded()).
+ * @return PictureView Filas con favorito() == true, en orden.
+ */
+PictureView PictureManager::favorites() const {
+    return PictureView(snapshot(), PictureStore::Favorite, true);
+}
+
+/**
+ * @brief Copia de todas las imágenes gestionadas.
+ *
+ * Las imágenes se guardan por columnas (PictureStore), así que ya no hay una lista
+ * interna a la que devolver una referencia: se construye una copia en orden de fila.
+ * @return QList<Picture> Todas las imágenes.
+ */
+QList<Picture> PictureManager::allPictures() const {
+    return snapshot()->toList();
+}
+
+/**
+ * @brief Imágenes que no están descargadas (equivalente a toDownload()).
+ * @return PictureView Vista sin copia de las filas no descargadas.
+ */
+PictureView PictureManager::notDownloaded() const {
+    return toDownload();
+}
+
+/**
+ * @brief resuelve las rutas de las imagenes
+ * @param relativePath
+ * @return  QDir(m_basePath).filePath(relativePath); ruta obsoluta desde el basepath
+ */
+
+QString PictureManager::resolveImagePath(const QString& relativePath) const
+{
+    if (QFileInfo(relativePath).isAbsolute()) {
+        return relativePath;  // Ya es absoluta
+    }
+    if (relativePath.contains("://")) {
+        return relativePath;  // URL remota o file:// (la descarga DownloadEngine)
+    }
+
+
+    return QDir(m_basePath).filePath(relativePath);
 }
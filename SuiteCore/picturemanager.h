@@ -4,26 +4,53 @@
 #include <QObject>
 #include <QList>
 #include <QString>
+#include <QStringList>
 #include <QSet>
 #include <QMutex>
+#include <QAtomicInt>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QHash>
+#include <QScopedPointer>
+#include <QVector>
+#include <QWaitCondition>
+#include <functional>
+#include <memory>
 #include "Picture.h"
+#include "concurrentidset.h"
+#include "downloadengine.h"
+#include "expirationscheduler.h"
+#include "persistencewriter.h"
+#include "picturestore.h"
+#include "statejournal.h"
 #include "SuiteCore_global.h"
 
 class PictureDAO;
+class SqlitePictureDAO;
+class QFileSystemWatcher;
+class QTimer;
 
 class SUITECORE_EXPORT PictureManager : public QObject
 {
     Q_OBJECT
 
 public:
+    // Ventana en la que se agrupan las descargas de downloadMany() que terminan
+    static constexpr int BulkNotifyMs = 100;
+    // Agrupación de las escrituras de la lista de descargas pendientes
+    static constexpr int PendingSaveMs = 1000;
+
     explicit PictureManager(QObject* parent = nullptr);
+    ~PictureManager() override;
 
     void setBasePath(const QString& path);
-    void removeDownloaded(const Picture& picture, int seconds);
+    void removeDownloaded(PictureId id, int seconds);
 
     QString getDownloadedJsonPath() const;
+    QString getPendingDownloadsPath() const;
     QString getImagesFolderPath() const;
-    QVector<Picture> notDownloaded() const;
+    PictureView notDownloaded() const;
     QString resolveImagePath(const QString& relativePath) const;
 
     // Carga y guardado
@@ -33,42 +60,189 @@ public:
     bool loadCatalog(const QString& filepath);
     bool loadDownloaded(const QString& filepath);
     bool saveDownloaded(const QString& filepath);
+    bool loadSnapshot(const QString& catalogPath, const QString& downloadedPath);
+    bool saveSnapshot(const QString& catalogPath, const QString& downloadedPath) const;
+    bool flush(QDeadlineTimer deadline);
 
+    // Carga en segundo plano: las filas llegan por lotes con picturesLoaded()
+    void loadAsync(const QString& catalogPath, const QString& downloadedPath);
+    bool isLoading() const;
+    qint64 timeToFirstRows() const { return m_firstRowsMs; }
 
-    int indexOf(const QString& name) const;
+    // Recarga en caliente del catálogo (aplica solo las diferencias)
+    void watchCatalog(const QString& filepath);
+    void reloadCatalog(const QString& filepath);
+    Picture picture(PictureId id) const;
+    bool isExpired(PictureId id) const;
 
-    // Acceso a las listas
-    const QList<Picture>& pictures() const;
-    const QList<Picture>& allPictures() const;
+    // Almacenamiento SQLite opcional (consultas indexadas)
+    bool openDatabase(const QString& dbPath, const QString& catalogPath, const QString& downloadedPath);
+    SqlitePictureDAO* database() const;
 
-    QList<Picture> favorites() const;
-    QList<Picture> toDownload() const;
-    QList<Picture> downloaded() const;
 
-    // Operaciones
-    void downloadPicture(const Picture &picture, int seconds);
-    void toggleFavorite(int indexReal); // Se recomienda usar índice real de m_pictures
-    void toggleFavoriteByName(const QString& name);
-    void removeDownloadedByName(const QString& name);
-    void downloadPictureByUrl(const QString &url, int seconds = 10);
-
-signals:
-    void pictureDownloaded(const Picture& picture);
-    void downloadProgress(int progress, const QString& pictureName);
-    void pictureRemoved(const Picture& picture);
+    PictureId idOf(const QString& name) const;
+    PictureId idOfUrl(const QString& url) const;
 
+    // Acceso a las listas
+    const QList<Picture>& pictures() const;
+    QList<Picture> allPictures() const;
+
+    // Versión publicada del catálogo: inmutable, se obtiene sin bloquear desde cualquier hilo
+    std::shared_ptr<const PictureStore> snapshot() const;
+
+    // Vistas sin copia sobre los conjuntos que mantiene el almacén, con size() O(1).
+    // Cada vista retiene la versión en la que se creó.
+    PictureView favorites() const;
+    PictureView toDownload() const;
+    PictureView downloaded() const;
+
+    // Operaciones (las descargas son asíncronas: DownloadEngine, sin hilo por descarga)
+    void downloadPicture(PictureId id);
+    void toggleFavorite(PictureId id);
+
+    // Control de la cola de descargas (downloadPicture() va por el carril interactivo)
+    void pauseDownload(PictureId id);
+    void resumeDownload(PictureId id);
+    void cancelDownload(PictureId id);
+    void pauseAllDownloads();
+    void resumeAllDownloads();
+    void cancelAllDownloads();
+    void cancelBulkDownloads(const QVector<PictureId>& ids);
+    void setMaxConcurrentDownloads(int max);
+    int maxConcurrentDownloads() const;
+    int downloadQueueDepth() const;
+    int downloadsInFlight() const;
+    bool isDownloadQueuePaused() const;
+    void setSegmentedDownloads(bool enabled);
+    bool segmentedDownloads() const;
+
+    // Descargas pendientes de la sesión anterior (en cola o a medias al cerrar)
+    int resumeDownloads();
+
+    // Medidas de las descargas reales (caudal, p50/p99 hasta completar)
+    DownloadStats::Summary downloadStats() const;
+    void resetDownloadStats();
+
+    // Operaciones masivas: se confirman en grupo (commit()) y se notifican con una señal
+    void downloadMany(const QVector<PictureId>& ids);
+    void removeMany(const QVector<PictureId>& ids, int seconds);
+    void setFavoriteMany(const QVector<PictureId>& ids, bool favorite);
 
-public slots:
-    void downloadPicture(int index);
-    void downloadPicture(int index, int seconds);
-
+signals:
+    void pictureDownloaded(PictureId id);
+    void downloadProgress(int progress, PictureId id);
+    void downloadFailed(PictureId id, const QString& error);
+    void downloadPaused(PictureId id, bool paused);
+    void downloadQueueChanged(int queued, int inFlight);
+    void catalogLoadProgress(int progress);
+    void picturesLoaded(const QList<Picture>& batch);
+    void firstRowsLoaded(qint64 msecs);
+    void loadFinished(bool ok);
+    void picturesAdded(const QVector<PictureId>& ids);
+    void picturesChanged(const QVector<PictureId>& ids);
+    void picturesRemoved(const QVector<PictureId>& ids);
+    void pictureRemoved(PictureId id);
+    void picturesExpired(const QVector<PictureId>& ids);
+    void picturesDownloaded(const QVector<PictureId>& ids);
+    void downloadsRemoved(const QVector<PictureId>& ids);
+    void favoritesChanged(const QVector<PictureId>& ids);
 
 
 private:
-    QList<Picture> m_pictures;
+    void setCatalogPath(const QString& path);
+    void runLoad(const QString& catalogPath, const QString& downloadedPath, int generation);
+    void deliverBatch(const std::shared_ptr<const PictureStore>& built, int generation);
+
+    // Recarga en caliente: el diff se calcula en el pool y se aplica en el hilo del objeto
+    struct CatalogDiff {
+        std::shared_ptr<const PictureStore> base; // versión contra la que se calculó
+        std::shared_ptr<const PictureStore> next;
+        QVector<PictureId> added;
+        QVector<PictureId> changed;
+        QVector<PictureId> removed;
+        QStringList forgottenUrls; // ya no están en el catálogo: sus ids se olvidan
+    };
+    void startReloadTask(const std::function<void()>& task);
+    void diffCatalog(const QList<Picture>& fresh, int generation);
+    void applyCatalogDiff(const QList<Picture>& fresh, const CatalogDiff& diff, int generation);
+    void onPicturesExpired(const QVector<PictureId>& ids);
+    void onTransferFinished(PictureId id, bool ok, const QString& error);
+    void startTransfer(const PictureStore& store, int row, DownloadScheduler::Priority priority);
+    void removeAfterDelay(const QVector<PictureId>& ids, int seconds, bool single);
+    QString downloadPath(const QString& nombre) const;
+    void setPending(PictureId id, const QString& url);
+    void savePendingDownloads();
+    void prunePendingDownloads();
+    void readCarriedPending();
+
+    // Escritura (con m_mutex tomado): se prepara una versión nueva y se publica de una vez
+    void applyJournal(PictureStore& store, const QList<StateJournal::Record>& records) const;
+    void assignIds(PictureStore& store, int first);
+    void publish(PictureStore&& store);
+    void markDownloaded(PictureStore& store, int row);
+    void markRemoved(PictureStore& store, int row);
+    static StateJournal::Record changeRecord(const PictureStore& store, int row,
+                                             StateJournal::RecordType type);
+
+    // Confirmación agrupada de cambios de estado de filas (descarga, borrado, favorito)
+    struct RowChange {
+        PictureId id;
+        StateJournal::RecordType type;
+        bool favorito; // solo para Favorite
+    };
+    struct Submission {
+        QVector<RowChange> changes;
+        QVector<PictureId>* applied; // del hilo que espera en commit(), puede ser nulo
+    };
+    void commit(const QVector<RowChange>& changes, QVector<PictureId>* applied);
+    void applyChanges(QVector<Submission>& batch);
+
+    std::shared_ptr<const PictureStore> m_snapshot; // solo con std::atomic_load/atomic_store
+    QHash<QString, QVector<PictureId>> m_idsByUrl; // un id por aparición de la URL
+    PictureId m_nextId = InvalidPictureId + 1;
     QString m_basePath;
-    mutable QMutex m_mutex;
-    QSet<QString> m_activeTasks;
+    QString m_catalogPath;
+    QFileSystemWatcher* m_catalogWatcher = nullptr;
+    QTimer* m_reloadTimer = nullptr;
+    mutable QMutex m_mutex; // serializa a los escritores; los lectores usan snapshot()
+    ConcurrentIdSet m_activeTasks; // tareas en curso, con bloqueos por fragmento
+
+    // Cola de commit(): m_queueMutex solo protege la cola y los contadores
+    QMutex m_queueMutex;
+    QWaitCondition m_committedCondition;
+    QVector<Submission> m_queue;
+    quint64 m_enqueued = 0;
+    quint64 m_committed = 0;
+    bool m_combining = false;
+    StateJournal m_journal;
+    ExpirationScheduler m_expiration; // cubos por día de caducidad, un solo temporizador
+
+    // Descargas: las de downloadMany() se notifican juntas con picturesDownloaded()
+    DownloadEngine m_engine;
+    ConcurrentIdSet m_bulkDownloads;
+    QVector<PictureId> m_finishedBulk; // solo en el hilo del objeto
+    QTimer* m_bulkTimer = nullptr;
+
+    // Descargas pedidas y sin terminar (id -> URL del catálogo), en downloads.pending,
+    // más las de la sesión anterior que aún no se han reanudado
+    QMutex m_pendingMutex;
+    QHash<PictureId, QString> m_pending;
+    QStringList m_carriedPending;
+    bool m_carriedRead = false;
+    QTimer* m_pendingTimer = nullptr;
+    QScopedPointer<SqlitePictureDAO> m_database;
+    PersistenceWriter m_writer; // Declarado tras m_snapshot/m_journal: se destruye antes
+
+    // Carga asíncrona
+    QFuture<void> m_loadFuture;
+    QAtomicInt m_loadCancelled;
+    QElapsedTimer m_loadTimer;
+    int m_loadGeneration = 0; // solo en el hilo del objeto
+    qint64 m_firstRowsMs = -1;
+
+    // Recargas en caliente en curso (solo en el hilo del objeto)
+    QVector<QFuture<void>> m_reloads;
+    int m_reloadGeneration = 0;
 };
 
 #endif // PICTUREMANAGER_H
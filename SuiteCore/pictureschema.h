@@ -0,0 +1,239 @@
+#ifndef PICTURESCHEMA_H
+#define PICTURESCHEMA_H
+
+#include "Picture.h"
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
+#include <QDataStream>
+#include <QDate>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Tabla de campos persistentes de Picture, fijada en tiempo de compilación.
+// Los serializadores JSON, CBOR y QDataStream se generan recorriéndola, de modo que
+// todos los formatos escriben y leen exactamente los mismos campos.
+namespace PictureSchema {
+
+// Ámbitos en los que se persiste un campo
+enum Scope : unsigned {
+    Catalog = 0x1,  // catálogo (download.json): nombre, url y descripcion
+    State = 0x2     // estado completo (downloaded.json, exportaciones)
+};
+
+// Versión de la tabla; se guarda en las cabeceras de los formatos binarios
+constexpr quint16 Version = 1;
+
+template <typename T>
+struct Field
+{
+    using Type = T;
+    using Param = std::conditional_t<std::is_class<T>::value, const T&, T>;
+
+    const char* key;
+    int keyLength;
+    T (Picture::*get)() const;
+    void (Picture::*set)(Param);
+    unsigned scopes;
+
+    bool keyIs(const char* other, int length) const
+    {
+        return length == keyLength && std::memcmp(other, key, size_t(length)) == 0;
+    }
+};
+
+template <typename T, int N>
+constexpr Field<T> field(const char (&key)[N], T (Picture::*get)() const,
+                         void (Picture::*set)(typename Field<T>::Param), unsigned scopes)
+{
+    return Field<T>{key, N - 1, get, set, scopes};
+}
+
+// El orden de la tabla es el orden de los formatos posicionales (CBOR y QDataStream):
+// añadir campos siempre al final y subir Version.
+inline constexpr auto Fields = std::make_tuple(
+    field("nombre", &Picture::nombre, &Picture::setNombre, Catalog | State),
+    field("url", &Picture::url, &Picture::setUrl, Catalog | State),
+    field("descripcion", &Picture::descripcion, &Picture::setDescripcion, Catalog | State),
+    field("favorito", &Picture::favorito, &Picture::setFavorito, State),
+    field("descargada", &Picture::descargada, &Picture::setDescargada, State),
+    field("filePath", &Picture::filePath, &Picture::setFilePath, State),
+    field("expirationDate", &Picture::expirationDate, &Picture::setExpirationDate, State));
+
+constexpr int FieldCount = int(std::tuple_size<std::decay_t<decltype(Fields)>>::value);
+
+namespace detail {
+
+template <typename F, std::size_t... I>
+void forEach(F&& f, std::index_sequence<I...>)
+{
+    (f(std::get<I>(Fields)), ...);
+}
+
+template <std::size_t... I>
+constexpr int countIn(unsigned scope, std::index_sequence<I...>)
+{
+    return (0 + ... + ((std::get<I>(Fields).scopes & scope) ? 1 : 0));
+}
+
+// --- JSON -------------------------------------------------------------------
+
+inline QJsonValue toJson(const QString& v) { return v; }
+inline QJsonValue toJson(bool v) { return v; }
+inline QJsonValue toJson(const QDate& v)
+{
+    return v.isValid() ? QJsonValue(v.toString(Qt::ISODate)) : QJsonValue(); // ISO (YYYY-MM-DD)
+}
+
+inline void fromJson(const QJsonValue& v, QString& out) { out = v.toString(); }
+inline void fromJson(const QJsonValue& v, bool& out) { out = v.toBool(); }
+inline void fromJson(const QJsonValue& v, QDate& out) { out = QDate::fromString(v.toString(), Qt::ISODate); }
+
+// --- CBOR -------------------------------------------------------------------
+
+inline void toCbor(QCborStreamWriter& w, const QString& v) { w.append(v); }
+inline void toCbor(QCborStreamWriter& w, bool v) { w.append(v); }
+inline void toCbor(QCborStreamWriter& w, const QDate& v)
+{
+    if (v.isValid()) w.append(v.toJulianDay());
+    else w.appendNull();
+}
+
+inline bool fromCbor(QCborStreamReader& r, QString& out)
+{
+    if (!r.isString()) return false;
+    out.clear();
+    auto chunk = r.readString();
+    while (chunk.status == QCborStreamReader::Ok) {
+        out += chunk.data;
+        chunk = r.readString();
+    }
+    return chunk.status == QCborStreamReader::EndOfString;
+}
+
+inline bool fromCbor(QCborStreamReader& r, bool& out)
+{
+    if (!r.isBool()) return false;
+    out = r.toBool();
+    return r.next();
+}
+
+inline bool fromCbor(QCborStreamReader& r, QDate& out)
+{
+    if (r.isNull()) {
+        out = QDate();
+        return r.next();
+    }
+    if (!r.isInteger()) return false;
+    out = QDate::fromJulianDay(r.toInteger());
+    return r.next();
+}
+
+} // namespace detail
+
+// Invoca f(campo) para cada campo de la tabla, en orden
+template <typename F>
+void forEach(F&& f)
+{
+    detail::forEach(std::forward<F>(f), std::make_index_sequence<FieldCount>());
+}
+
+// Número de campos de un ámbito (constante en compilación)
+constexpr int fieldCount(unsigned scope)
+{
+    return detail::countIn(scope, std::make_index_sequence<FieldCount>());
+}
+
+inline QJsonObject toJson(const Picture& pic, unsigned scope)
+{
+    QJsonObject obj;
+    forEach([&](const auto& f) {
+        if (!(f.scopes & scope)) return;
+        const QJsonValue value = detail::toJson((pic.*f.get)());
+        if (!value.isNull()) obj.insert(QString::fromLatin1(f.key, f.keyLength), value);
+    });
+    return obj;
+}
+
+inline Picture fromJson(const QJsonObject& obj, unsigned scope)
+{
+    Picture pic;
+    forEach([&](const auto& f) {
+        if (!(f.scopes & scope)) return;
+        const QJsonValue value = obj.value(QLatin1String(f.key, f.keyLength));
+        if (value.isUndefined()) return;
+        typename std::decay_t<decltype(f)>::Type v{};
+        detail::fromJson(value, v);
+        (pic.*f.set)(v);
+    });
+    return pic;
+}
+
+// Asigna el valor JSON al campo cuya clave coincide; false si la clave no es del ámbito
+inline bool setFromJson(Picture& pic, const char* key, int keyLength, const QJsonValue& value,
+                        unsigned scope)
+{
+    bool matched = false;
+    forEach([&](const auto& f) {
+        if (matched || !(f.scopes & scope) || !f.keyIs(key, keyLength)) return;
+        matched = true;
+        typename std::decay_t<decltype(f)>::Type v{};
+        detail::fromJson(value, v);
+        (pic.*f.set)(v);
+    });
+    return matched;
+}
+
+// CBOR posicional: un array con los campos del ámbito en el orden de la tabla (sin claves)
+inline void toCbor(QCborStreamWriter& writer, const Picture& pic, unsigned scope)
+{
+    writer.startArray(quint64(fieldCount(scope)));
+    forEach([&](const auto& f) {
+        if (f.scopes & scope) detail::toCbor(writer, (pic.*f.get)());
+    });
+    writer.endArray();
+}
+
+inline bool fromCbor(QCborStreamReader& reader, Picture& pic, unsigned scope)
+{
+    if (!reader.isArray() || !reader.isLengthKnown() || reader.length() != quint64(fieldCount(scope)))
+        return false;
+    if (!reader.enterContainer()) return false;
+
+    pic = Picture();
+    bool ok = true;
+    forEach([&](const auto& f) {
+        if (!ok || !(f.scopes & scope)) return;
+        typename std::decay_t<decltype(f)>::Type v{};
+        ok = detail::fromCbor(reader, v);
+        if (ok) (pic.*f.set)(v);
+    });
+    return ok && reader.leaveContainer();
+}
+
+// QDataStream posicional: los campos del ámbito en el orden de la tabla
+inline void toStream(QDataStream& out, const Picture& pic, unsigned scope)
+{
+    forEach([&](const auto& f) {
+        if (f.scopes & scope) out << (pic.*f.get)();
+    });
+}
+
+inline bool fromStream(QDataStream& in, Picture& pic, unsigned scope)
+{
+    pic = Picture();
+    forEach([&](const auto& f) {
+        if (!(f.scopes & scope)) return;
+        typename std::decay_t<decltype(f)>::Type v{};
+        in >> v;
+        (pic.*f.set)(v);
+    });
+    return in.status() == QDataStream::Ok;
+}
+
+} // namespace PictureSchema
+
+#endif // PICTURESCHEMA_H
@@ -0,0 +1,174 @@
+/**
+ * @file pictureserializer.cpp
+ * @brief Serializadores de listas de Picture generados desde PictureSchema.
+ *
+ * Los tres formatos recorren la misma tabla de campos, así que no pueden divergir:
+ * - JSON: array de objetos con las claves de la tabla (el formato de download.json).
+ * - CBOR: etiqueta de autodescripción (d9 d9 f7) y [versión, ámbito, [registros]];
+ *   cada registro es un array posicional, sin claves.
+ * - QDataStream: cabecera "PICS" + versión + ámbito + número de registros, y después
+ *   los campos de cada registro en el orden de la tabla.
+ *
+ * En los formatos binarios el lector no compara ni busca claves: los campos se leen
+ * por posición y el ámbito guardado en la cabecera indica cuáles hay.
+ */
+
+#include "pictureserializer.h"
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
+#include <QDataStream>
+#include <QJsonArray>
+#include <QJsonDocument>
+
+namespace {
+
+const quint32 StreamMagic = 0x50494353; // "PICS"
+
+// El ámbito de la cabecera viene del fichero: solo combinaciones de ámbitos conocidos
+bool validScope(quint64 scope)
+{
+    const quint64 known = PictureSchema::Catalog | PictureSchema::State;
+    return scope != 0 && (scope & ~known) == 0;
+}
+
+QByteArray toCbor(const QList<Picture>& pictures, unsigned scope)
+{
+    QByteArray data;
+    QCborStreamWriter writer(&data);
+    writer.append(QCborKnownTags::Signature);
+    writer.startArray(3);
+    writer.append(quint64(PictureSchema::Version));
+    writer.append(quint64(scope));
+    writer.startArray(quint64(pictures.size()));
+    for (const Picture& pic : pictures)
+        PictureSchema::toCbor(writer, pic, scope);
+    writer.endArray();
+    writer.endArray();
+    return data;
+}
+
+bool readUnsigned(QCborStreamReader& reader, quint64& value)
+{
+    if (!reader.isUnsignedInteger()) return false;
+    value = reader.toUnsignedInteger();
+    return reader.next();
+}
+
+bool fromCbor(const QByteArray& data, QList<Picture>& pictures)
+{
+    QCborStreamReader reader(data);
+    if (!reader.isTag() || reader.toTag() != QCborTag(QCborKnownTags::Signature) || !reader.next())
+        return false;
+    if (!reader.isArray() || !reader.enterContainer()) return false;
+
+    quint64 version = 0, scope = 0;
+    if (!readUnsigned(reader, version) || version != PictureSchema::Version) return false;
+    if (!readUnsigned(reader, scope) || !validScope(scope)) return false;
+
+    // Sin reserve(): la longitud del array no está validada y podría ser cualquiera
+    if (!reader.isArray() || !reader.enterContainer()) return false;
+
+    Picture pic;
+    while (reader.hasNext()) {
+        if (!PictureSchema::fromCbor(reader, pic, unsigned(scope))) return false;
+        pictures.append(pic);
+    }
+    return reader.leaveContainer() && reader.leaveContainer()
+           && reader.lastError() == QCborError::NoError;
+}
+
+QByteArray toStream(const QList<Picture>& pictures, unsigned scope)
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << StreamMagic << PictureSchema::Version << quint16(scope) << quint32(pictures.size());
+    for (const Picture& pic : pictures)
+        PictureSchema::toStream(out, pic, scope);
+    return data;
+}
+
+bool fromStream(const QByteArray& data, QList<Picture>& pictures)
+{
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0, count = 0;
+    quint16 version = 0, scope = 0;
+    in >> magic >> version >> scope >> count;
+    if (in.status() != QDataStream::Ok || magic != StreamMagic || version != PictureSchema::Version
+        || !validScope(scope))
+        return false;
+
+    // Cada campo ocupa al menos un byte: un número mayor no cabe en lo que queda
+    const qint64 remaining = data.size() - in.device()->pos();
+    if (count > quint64(remaining) / quint64(PictureSchema::fieldCount(scope))) return false;
+
+    pictures.reserve(int(count));
+    Picture pic;
+    for (quint32 i = 0; i < count; ++i) {
+        if (!PictureSchema::fromStream(in, pic, scope) || in.status() != QDataStream::Ok) return false;
+        pictures.append(pic);
+    }
+    return in.atEnd();
+}
+
+} // namespace
+
+/**
+ * @brief Serializa una lista de Picture en el formato indicado.
+ * @param scope Campos a incluir (PictureSchema::Catalog o PictureSchema::State).
+ */
+QByteArray PictureSerializer::serialize(const QList<Picture>& pictures, Format format,
+                                        unsigned scope)
+{
+    switch (format) {
+    case Cbor:
+        return toCbor(pictures, scope);
+    case DataStream:
+        return toStream(pictures, scope);
+    case Json:
+        break;
+    }
+
+    QJsonArray array;
+    for (const Picture& pic : pictures)
+        array.append(PictureSchema::toJson(pic, scope));
+    return QJsonDocument(array).toJson();
+}
+
+/**
+ * @brief Deserializa una lista detectando el formato por la cabecera.
+ * @param ok false si los datos no son válidos (se devuelve una lista vacía).
+ */
+QList<Picture> PictureSerializer::deserialize(const QByteArray& data, bool* ok)
+{
+    QList<Picture> pictures;
+    bool valid = false;
+
+    switch (detect(data)) {
+    case Cbor:
+        valid = fromCbor(data, pictures);
+        break;
+    case DataStream:
+        valid = fromStream(data, pictures);
+        break;
+    case Json: {
+        const QJsonDocument doc = QJsonDocument::fromJson(data);
+        valid = doc.isArray();
+        for (const QJsonValue& value : doc.array())
+            pictures.append(PictureSchema::fromJson(value.toObject(), PictureSchema::State));
+        break;
+    }
+    }
+
+    if (ok) *ok = valid;
+    return valid ? pictures : QList<Picture>();
+}
+
+PictureSerializer::Format PictureSerializer::detect(const QByteArray& head)
+{
+    if (head.startsWith("\xd9\xd9\xf7")) return Cbor;
+    if (head.startsWith("PICS")) return DataStream;
+    return Json;
+}
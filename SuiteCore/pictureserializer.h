@@ -0,0 +1,29 @@
+#ifndef PICTURESERIALIZER_H
+#define PICTURESERIALIZER_H
+
+#include "Picture.h"
+#include "pictureschema.h"
+#include "SuiteCore_global.h"
+#include <QByteArray>
+#include <QList>
+
+// Serialización de listas de Picture en JSON, CBOR o QDataStream a partir de la
+// tabla de PictureSchema. Los formatos binarios llevan cabecera y se detectan solos.
+class SUITECORE_EXPORT PictureSerializer
+{
+public:
+    enum Format {
+        Json,
+        Cbor,
+        DataStream
+    };
+
+    static QByteArray serialize(const QList<Picture>& pictures, Format format,
+                                unsigned scope = PictureSchema::State);
+    static QList<Picture> deserialize(const QByteArray& data, bool* ok = nullptr);
+
+    // Formato según los primeros bytes (Json si no hay cabecera binaria)
+    static Format detect(const QByteArray& head);
+};
+
+#endif // PICTURESERIALIZER_H
@@ -0,0 +1,275 @@
+/**
+ * @file picturestore.cpp
+ * @brief Almacén columnar de imágenes.
+ *
+ * En Qt5, QList<Picture> reserva cada Picture por separado en el heap (el tipo es
+ * grande), así que recorrer la lista salta de puntero en puntero. PictureStore guarda
+ * cada atributo en una columna de bloques contiguos (ChunkedColumn):
+ * - nombre, url y ruta local: un QString por fila (solo el puntero compartido, 8 bytes),
+ * - descripción: índice de 32 bits en una tabla de cadenas internadas,
+ * - favorito, descargada y caducada: bitsets de 64 filas por palabra, con contadores,
+ * - caducidad: día juliano en un qint32.
+ *
+ * PictureManager copia la versión publicada antes de cada cambio. Con columnas en
+ * bloques, marcar una imagen como favorita o descargada en un catálogo de un millón
+ * de filas duplica unos pocos bloques (decenas de KiB) en lugar de columnas enteras.
+ * Los setters no escriben si el valor no cambia, para no duplicar bloques sin motivo.
+ *
+ * Los filtros habituales (descargadas, pendientes, favoritas) son vistas sobre el
+ * bitset correspondiente (PictureView): no copian nada y count() es O(1).
+ *
+ * Los índices (id, url y nombre -> fila) y la tabla de cadenas internadas son RowIndex:
+ * todas las versiones que descienden de una misma carga comparten la tabla, y la más
+ * reciente añade sus filas en ella. La carga asíncrona construye así el almacén en su
+ * hilo y publica una copia por lote sin volver a calcular los índices (extendFrom()).
+ */
+
+#include "picturestore.h"
+
+PictureStore::PictureStore()
+    : m_today(QDate::currentDate().toJulianDay())
+{
+    clear();
+}
+
+void PictureStore::clear()
+{
+    m_id.clear();
+    m_nombre.clear();
+    m_url.clear();
+    m_descripcion.clear();
+    m_filePath.clear();
+    m_expiration.clear();
+    for (int f = 0; f < FlagCount; ++f) {
+        m_flags[f].clear();
+        m_counts[f] = 0;
+    }
+
+    m_rowById.clear();
+    m_rowByUrl.clear();
+    m_rowByName.clear();
+
+    m_strings.clear();
+    m_stringIds.clear();
+    m_strings.append(QString());
+    m_stringIds.extend(1);
+    m_stringIds.insert(QString(), 0);
+}
+
+void PictureStore::reserve(int count)
+{
+    m_id.reserve(count);
+    m_nombre.reserve(count);
+    m_url.reserve(count);
+    m_descripcion.reserve(count);
+    m_filePath.reserve(count);
+    m_expiration.reserve(count);
+    for (int f = 0; f < FlagCount; ++f)
+        m_flags[f].reserve((count + 63) / 64);
+    m_rowById.reserve(count);
+    m_rowByUrl.reserve(count);
+    m_rowByName.reserve(count);
+}
+
+/**
+ * @brief Añade una imagen al final.
+ * @return Fila asignada.
+ */
+int PictureStore::append(const Picture& picture)
+{
+    const int row = size();
+    m_id.append(InvalidPictureId);
+    m_nombre.append(picture.nombre());
+    m_url.append(picture.url());
+    m_descripcion.append(intern(picture.descripcion()));
+    m_filePath.append(picture.filePath());
+    m_expiration.append(NoDate);
+    resizeFlags();
+    m_rowById.extend(row + 1);
+    m_rowByUrl.extend(row + 1);
+    m_rowByName.extend(row + 1);
+
+    setFlag(Favorite, row, picture.favorito());
+    setFlag(Downloaded, row, picture.descargada());
+    setExpirationDate(row, picture.expirationDate());
+
+    if (!m_rowByUrl.contains(picture.url())) m_rowByUrl.insert(picture.url(), row);
+    if (!m_rowByName.contains(picture.nombre())) m_rowByName.insert(picture.nombre(), row);
+    setId(row, picture.id());
+    return row;
+}
+
+void PictureStore::append(const QList<Picture>& pictures)
+{
+    reserve(size() + pictures.size());
+    for (const Picture& pic : pictures)
+        append(pic);
+}
+
+/**
+ * @brief Añade al final las filas de 'grown' que faltan en este almacén.
+ *
+ * 'grown' es una versión posterior del mismo almacén (las mismas filas iniciales y más
+ * al final), como la que construye la carga asíncrona en su hilo. Si comparte con esta
+ * los índices y la tabla de cadenas, las filas nuevas se copian columna a columna y
+ * los índices se heredan sin recalcular nada: el coste es el de las filas añadidas.
+ * Si no, se añaden con append(). Las filas existentes conservan el estado de este
+ * almacén (p. ej. un favorito marcado durante la carga).
+ */
+void PictureStore::extendFrom(const PictureStore& grown)
+{
+    const int first = size();
+    const bool shared = first <= grown.size()
+                        && m_stringIds.sharesTable(grown.m_stringIds)
+                        && m_rowById.sharesTable(grown.m_rowById)
+                        && m_rowByUrl.sharesTable(grown.m_rowByUrl)
+                        && m_rowByName.sharesTable(grown.m_rowByName)
+                        && m_stringIds.size() <= grown.m_stringIds.size();
+    if (!shared) {
+        for (int row = first; row < grown.size(); ++row)
+            append(grown.at(row));
+        return;
+    }
+
+    // Las cadenas de esta versión son un prefijo de las de 'grown'
+    m_strings = grown.m_strings;
+    m_stringIds.adopt(grown.m_stringIds);
+    for (int row = first; row < grown.size(); ++row) {
+        m_id.append(grown.m_id.at(row));
+        m_nombre.append(grown.m_nombre.at(row));
+        m_url.append(grown.m_url.at(row));
+        m_descripcion.append(grown.m_descripcion.at(row));
+        m_filePath.append(grown.m_filePath.at(row));
+        m_expiration.append(NoDate);
+        resizeFlags();
+
+        setFlag(Favorite, row, grown.test(Favorite, row));
+        setFlag(Downloaded, row, grown.test(Downloaded, row));
+        setExpirationDate(row, grown.expirationDate(row));
+    }
+    m_rowById.adopt(grown.m_rowById);
+    m_rowByUrl.adopt(grown.m_rowByUrl);
+    m_rowByName.adopt(grown.m_rowByName);
+}
+
+/**
+ * @brief Construye el Picture de una fila (copia de las columnas).
+ */
+Picture PictureStore::at(int row) const
+{
+    Picture pic(m_nombre.at(row), m_url.at(row), descripcion(row));
+    pic.setId(m_id.at(row));
+    pic.setFilePath(filePath(row));
+    pic.setFavorito(test(Favorite, row));
+    pic.setDescargada(test(Downloaded, row));
+    pic.setExpirationDate(expirationDate(row));
+    return pic;
+}
+
+/**
+ * @brief Asigna el id de una fila y lo registra en el índice id -> fila.
+ */
+void PictureStore::setId(int row, PictureId id)
+{
+    const PictureId old = m_id.at(row);
+    if (old != InvalidPictureId && rowOf(old) == row) m_rowById.remove(old);
+
+    m_id[row] = id;
+    if (id != InvalidPictureId) m_rowById.insert(id, row);
+}
+
+QList<Picture> PictureStore::toList() const
+{
+    QList<Picture> list;
+    list.reserve(size());
+    for (int row = 0; row < size(); ++row)
+        list.append(at(row));
+    return list;
+}
+
+QDate PictureStore::expirationDate(int row) const
+{
+    const qint32 day = m_expiration.at(row);
+    return day == NoDate ? QDate() : QDate::fromJulianDay(day);
+}
+
+void PictureStore::setFlag(Flag flag, int row, bool value)
+{
+    if (test(flag, row) == value) return;
+
+    quint64& word = m_flags[flag][row >> 6];
+    const quint64 mask = quint64(1) << (row & 63);
+    if (value) word |= mask;
+    else word &= ~mask;
+    m_counts[flag] += value ? 1 : -1;
+}
+
+void PictureStore::setFilePath(int row, const QString& path)
+{
+    if (m_filePath.at(row) != path) m_filePath[row] = path;
+}
+
+/**
+ * @brief Fija la caducidad y actualiza el bit Expired de la fila.
+ */
+void PictureStore::setExpirationDate(int row, const QDate& date)
+{
+    const qint32 day = date.isValid() ? qint32(date.toJulianDay()) : NoDate;
+    if (m_expiration.at(row) != day) m_expiration[row] = day;
+    setFlag(Expired, row, day != NoDate && day < m_today);
+}
+
+void PictureStore::refreshExpired(const QDate& today)
+{
+    m_today = today.toJulianDay();
+    for (int row = 0; row < size(); ++row) {
+        const qint32 day = m_expiration.at(row);
+        setFlag(Expired, row, day != NoDate && day < m_today);
+    }
+}
+
+/**
+ * @brief Marca caducadas las imágenes que entrega ExpirationScheduler.
+ *
+ * Solo toca las filas indicadas (el resto del bitset ya es correcto); 'today' pasa a
+ * ser la referencia de setExpirationDate().
+ *
+ * @return Ids cuyo bit Expired ha pasado a true.
+ */
+QVector<PictureId> PictureStore::expire(const QDate& today, const QVector<PictureId>& ids)
+{
+    m_today = today.toJulianDay();
+
+    QVector<PictureId> changed;
+    changed.reserve(ids.size());
+    for (PictureId id : ids) {
+        const int row = rowOf(id);
+        if (row < 0 || test(Expired, row)) continue;
+
+        const qint32 day = m_expiration.at(row);
+        if (day == NoDate || day >= m_today) continue; // se reprogramó a otra fecha
+        setFlag(Expired, row, true);
+        changed << id;
+    }
+    return changed;
+}
+
+quint32 PictureStore::intern(const QString& text)
+{
+    const int found = m_stringIds.value(text);
+    if (found >= 0) return quint32(found);
+
+    const int id = m_strings.size();
+    m_strings.append(text);
+    m_stringIds.extend(id + 1);
+    m_stringIds.insert(text, id);
+    return quint32(id);
+}
+
+void PictureStore::resizeFlags()
+{
+    const int words = (size() + 63) / 64;
+    for (int f = 0; f < FlagCount; ++f) {
+        while (m_flags[f].size() < words) m_flags[f].append(0);
+    }
+}
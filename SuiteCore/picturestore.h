@@ -0,0 +1,212 @@
+#ifndef PICTURESTORE_H
+#define PICTURESTORE_H
+
+#include "Picture.h"
+#include "chunkedcolumn.h"
+#include "rowindex.h"
+#include "SuiteCore_global.h"
+#include <QDate>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <QtAlgorithms>
+#include <iterator>
+#include <memory>
+
+// Almacén columnar (struct-of-arrays) de las imágenes de PictureManager.
+// Cada atributo vive en su propia columna troceada (ChunkedColumn), las descripciones
+// se internan, los flags son bitsets empaquetados y la caducidad es un día juliano.
+// Picture sigue siendo el valor de intercambio de la API: at() lo construye.
+// Incluye los índices id/url/nombre -> fila, de modo que cada versión publicada por
+// PictureManager es autocontenida. Copiarlo cuesta O(N / ChunkSize) y un cambio de
+// estado de una fila (favorito, descarga, caducidad) solo duplica los bloques que
+// toca. Los índices y la tabla de cadenas son RowIndex compartidos entre versiones:
+// añadir filas al final de la versión más reciente no los duplica.
+class SUITECORE_EXPORT PictureStore
+{
+public:
+    enum Flag {
+        Favorite = 0,
+        Downloaded = 1,
+        Expired = 2,
+        FlagCount = 3
+    };
+
+    static constexpr qint32 NoDate = 0; // día juliano 0: sin caducidad
+
+    PictureStore();
+
+    int size() const { return m_url.size(); }
+    bool isEmpty() const { return m_url.isEmpty(); }
+    void clear();
+    void reserve(int count);
+
+    // Conversión desde/hacia Picture
+    int append(const Picture& picture);
+    void append(const QList<Picture>& pictures);
+    void extendFrom(const PictureStore& grown);
+    Picture at(int row) const;
+    QList<Picture> toList() const;
+
+    // Índices (primera fila si hay URLs o nombres repetidos); -1 si no existe
+    int rowOf(PictureId id) const { return m_rowById.value(id); }
+    int rowOfUrl(const QString& url) const { return m_rowByUrl.value(url); }
+    int rowOfName(const QString& name) const { return m_rowByName.value(name); }
+
+    // Columnas
+    PictureId id(int row) const { return m_id.at(row); }
+    void setId(int row, PictureId id);
+    const QString& nombre(int row) const { return m_nombre.at(row); }
+    const QString& url(int row) const { return m_url.at(row); }
+    const QString& descripcion(int row) const { return m_strings.at(int(m_descripcion.at(row))); }
+    const QString& filePath(int row) const { return m_filePath.at(row); }
+    qint32 expirationDay(int row) const { return m_expiration.at(row); }
+    QDate expirationDate(int row) const;
+
+    bool test(Flag flag, int row) const
+    {
+        return (m_flags[flag].at(row >> 6) >> (row & 63)) & 1;
+    }
+    void setFlag(Flag flag, int row, bool value);
+    int count(Flag flag) const { return m_counts[flag]; }
+
+    void setFilePath(int row, const QString& path);
+    void setExpirationDate(int row, const QDate& date);
+
+    // Recalcula el bitset Expired respecto a 'today' (p. ej. al cambiar de día)
+    void refreshExpired(const QDate& today = QDate::currentDate());
+    // Avanza a 'today' y marca caducadas solo las imágenes indicadas; devuelve las que cambian
+    QVector<PictureId> expire(const QDate& today, const QVector<PictureId>& ids);
+
+    // Palabra 'w' del bitset (64 filas), invertida si value es false; sin bits tras la última fila
+    quint64 word(Flag flag, bool value, int w) const
+    {
+        quint64 bits = value ? m_flags[flag].at(w) : ~m_flags[flag].at(w);
+        const int tail = size() & 63;
+        if (tail && w == wordCount() - 1)
+            bits &= (quint64(1) << tail) - 1;
+        return bits;
+    }
+    int wordCount() const { return (size() + 63) / 64; }
+
+private:
+    quint32 intern(const QString& text);
+    void resizeFlags();
+
+    ChunkedColumn<PictureId> m_id;
+    ChunkedColumn<QString> m_nombre;
+    ChunkedColumn<QString> m_url;
+    ChunkedColumn<quint32> m_descripcion; // índices en m_strings
+    ChunkedColumn<QString> m_filePath;    // sin internar: cambia con cada descarga
+    ChunkedColumn<qint32> m_expiration;   // día juliano o NoDate
+    ChunkedColumn<quint64> m_flags[FlagCount];
+    int m_counts[FlagCount] = {0, 0, 0};
+    qint64 m_today;
+
+    // Índices
+    RowIndex<PictureId> m_rowById; // los ids no son densos: crecen con las recargas
+    RowIndex<QString> m_rowByUrl;
+    RowIndex<QString> m_rowByName;
+
+    // Descripciones internadas (la 0 es la cadena vacía); m_stringIds cubre m_strings
+    ChunkedColumn<QString> m_strings;
+    RowIndex<QString> m_stringIds;
+};
+
+// Referencia a una fila de PictureStore con la misma interfaz de lectura que Picture.
+// No copia nada; toPicture() materializa la fila cuando hace falta un valor.
+class PictureRef
+{
+public:
+    PictureRef(const PictureStore* store, int row) : m_store(store), m_row(row) {}
+
+    int row() const { return m_row; }
+    PictureId id() const { return m_store->id(m_row); }
+    const QString& nombre() const { return m_store->nombre(m_row); }
+    const QString& url() const { return m_store->url(m_row); }
+    const QString& descripcion() const { return m_store->descripcion(m_row); }
+    const QString& filePath() const { return m_store->filePath(m_row); }
+    bool favorito() const { return m_store->test(PictureStore::Favorite, m_row); }
+    bool descargada() const { return m_store->test(PictureStore::Downloaded, m_row); }
+    bool isExpired() const { return m_store->test(PictureStore::Expired, m_row); }
+    QDate expirationDate() const { return m_store->expirationDate(m_row); }
+    Picture toPicture() const { return m_store->at(m_row); }
+
+private:
+    const PictureStore* m_store;
+    int m_row;
+};
+
+// Vista de las filas con un flag dado (p. ej. descargadas = Downloaded a true) sobre una
+// versión inmutable del almacén. size() es O(1) (contadores del almacén) y recorrerla no
+// reserva memoria: el iterador avanza por el bitset 64 filas cada vez, en orden de fila.
+// La vista mantiene viva su versión, así que es estable aunque se publiquen otras; los
+// PictureRef que produce son válidos mientras exista la vista.
+class PictureView
+{
+public:
+    class const_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = PictureRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = PictureRef;
+
+        const_iterator() = default;
+        const_iterator(const PictureStore* store, PictureStore::Flag flag, bool value)
+            : m_store(store), m_flag(flag), m_value(value)
+        {
+            advance();
+        }
+
+        PictureRef operator*() const { return PictureRef(m_store, m_row); }
+        const_iterator& operator++() { advance(); return *this; }
+        const_iterator operator++(int) { const_iterator it = *this; advance(); return it; }
+        bool operator==(const const_iterator& other) const { return m_row == other.m_row; }
+        bool operator!=(const const_iterator& other) const { return m_row != other.m_row; }
+
+    private:
+        void advance()
+        {
+            while (!m_bits) {
+                if (++m_word >= m_store->wordCount()) {
+                    m_row = -1;
+                    return;
+                }
+                m_bits = m_store->word(m_flag, m_value, m_word);
+            }
+            m_row = m_word * 64 + int(qCountTrailingZeroBits(m_bits));
+            m_bits &= m_bits - 1;
+        }
+
+        const PictureStore* m_store = nullptr;
+        PictureStore::Flag m_flag = PictureStore::Favorite;
+        bool m_value = true;
+        int m_word = -1;
+        quint64 m_bits = 0;
+        int m_row = -1; // -1 = end()
+    };
+
+    PictureView(std::shared_ptr<const PictureStore> store, PictureStore::Flag flag, bool value)
+        : m_store(std::move(store)), m_flag(flag), m_value(value) {}
+
+    int size() const
+    {
+        return m_value ? m_store->count(m_flag) : m_store->size() - m_store->count(m_flag);
+    }
+    int count() const { return size(); }
+    bool isEmpty() const { return size() == 0; }
+
+    const_iterator begin() const { return const_iterator(m_store.get(), m_flag, m_value); }
+    const_iterator end() const { return const_iterator(); }
+    PictureRef first() const { return *begin(); }
+
+private:
+    std::shared_ptr<const PictureStore> m_store;
+    PictureStore::Flag m_flag;
+    bool m_value;
+};
+
+#endif // PICTURESTORE_H
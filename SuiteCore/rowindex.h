@@ -0,0 +1,144 @@
+#ifndef ROWINDEX_H
+#define ROWINDEX_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QReadLocker>
+#include <QReadWriteLock>
+#include <QWriteLocker>
+#include <memory>
+
+// Índice clave -> fila de PictureStore compartido entre versiones del almacén. Cada
+// versión cubre sus primeras size() filas e ignora las entradas de filas posteriores,
+// así que la versión más reciente de una tabla puede seguir añadiendo entradas en ella
+// sin afectar a las copias anteriores: añadir un lote cuesta lo que el lote, no rehacer
+// el índice. Solo una versión puede ampliar la tabla desde un tamaño dado (la primera
+// que lo reclama con extend()); cualquier otra, y cualquier cambio de una entrada que
+// ya ven otras versiones, trabaja sobre una copia propia (O(N), fuera de las cargas).
+template <typename Key>
+class RowIndex
+{
+public:
+    RowIndex() : d(std::make_shared<Data>()) {}
+
+    // Las copias no pueden modificar en su sitio las filas que ya comparten
+    RowIndex(const RowIndex& other) : d(other.d), m_size(other.m_size), m_ownedFrom(other.m_size)
+    {
+        other.release();
+    }
+
+    RowIndex& operator=(const RowIndex& other)
+    {
+        if (this != &other) {
+            d = other.d;
+            m_size = other.m_size;
+            m_ownedFrom = m_size;
+            other.release();
+        }
+        return *this;
+    }
+
+    int size() const { return m_size; }
+
+    // Fila de 'key'; -1 si no está o pertenece a una fila que esta versión no cubre
+    int value(const Key& key) const
+    {
+        QReadLocker locker(&d->lock);
+        const auto it = d->rows.constFind(key);
+        return it != d->rows.constEnd() && it.value() < m_size ? it.value() : -1;
+    }
+    bool contains(const Key& key) const { return value(key) >= 0; }
+
+    // Pasa a cubrir 'size' filas (se han añadido filas al final)
+    void extend(int size)
+    {
+        if (size <= m_size) return;
+        if (d->size.testAndSetOrdered(m_size, size)) {
+            m_size = size;
+            return;
+        }
+        detach();
+        m_size = size;
+        d->size.storeRelease(size);
+    }
+
+    void insert(const Key& key, int row)
+    {
+        const int current = value(key);
+        if (current == row) return;
+        if (!owns(row) || (current >= 0 && !owns(current))) detach();
+        QWriteLocker locker(&d->lock);
+        d->rows.insert(key, row);
+    }
+
+    void remove(const Key& key)
+    {
+        const int current = value(key);
+        if (current < 0) return;
+        if (!owns(current)) detach();
+        QWriteLocker locker(&d->lock);
+        d->rows.remove(key);
+    }
+
+    void reserve(int count)
+    {
+        if (d->size.loadAcquire() != m_size) return; // otra versión amplía esta tabla
+        QWriteLocker locker(&d->lock);
+        d->rows.reserve(count);
+    }
+
+    void clear()
+    {
+        d = std::make_shared<Data>();
+        m_size = 0;
+        m_ownedFrom = 0;
+    }
+
+    // true si 'other' es otra versión de la misma tabla
+    bool sharesTable(const RowIndex& other) const { return d == other.d; }
+
+    // Toma la cobertura de 'grown', una versión posterior de la misma tabla
+    void adopt(const RowIndex& grown)
+    {
+        d = grown.d;
+        m_size = grown.m_size;
+        m_ownedFrom = m_size;
+        grown.release();
+    }
+
+private:
+    struct Data {
+        QReadWriteLock lock;
+        QHash<Key, int> rows;
+        QAtomicInt size; // filas que cubre la versión más reciente
+    };
+
+    // Las filas desde m_ownedFrom solo las ve esta versión (nadie ha copiado después)
+    bool owns(int row) const { return row >= m_ownedFrom && d->size.loadAcquire() == m_size; }
+
+    void release() const
+    {
+        if (m_ownedFrom != m_size) m_ownedFrom = m_size;
+    }
+
+    void detach()
+    {
+        auto copy = std::make_shared<Data>();
+        {
+            QReadLocker locker(&d->lock);
+            copy->rows.reserve(d->rows.size());
+            for (auto it = d->rows.constBegin(); it != d->rows.constEnd(); ++it) {
+                if (it.value() < m_size) copy->rows.insert(it.key(), it.value());
+            }
+        }
+        copy->size.storeRelease(m_size);
+        d = std::move(copy);
+        m_ownedFrom = 0;
+    }
+
+    std::shared_ptr<Data> d;
+    int m_size = 0;
+    mutable int m_ownedFrom = 0;
+};
+
+#endif // ROWINDEX_H
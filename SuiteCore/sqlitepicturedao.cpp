@@ -0,0 +1,440 @@
+/**
+ * @file sqlitepicturedao.cpp
+ * @brief Persistencia de Picture en una base de datos SQLite local.
+ *
+ * A diferencia de PictureDAO (que vuelca y relee arrays JSON completos), este DAO
+ * guarda cada imagen como una fila y mantiene índices sobre url, nombre, favorito,
+ * descargada y expirationDate, de modo que preguntas como "¿cuáles están descargadas?"
+ * o "¿cuáles caducan esta semana?" no necesitan recorrer todo el catálogo.
+ *
+ * Notas:
+ * - La fecha de caducidad se guarda como día juliano (INTEGER, NULL si no hay fecha).
+ * - La primera vez se migra el contenido de download.json / downloaded.json; el
+ *   PRAGMA user_version marca la migración como realizada. Los cambios posteriores del
+ *   catálogo llegan con syncCatalog(), que PictureManager llama al cargar y al recargar.
+ * - QSqlDatabase no puede compartirse entre hilos: cada hilo abre su propia conexión,
+ *   con un nombre único, y la cierra desde ese mismo hilo al emitirse QThread::finished
+ *   (los hilos del pool terminan al quedar inactivos). Las que siguen abiertas se
+ *   cierran al destruir el DAO.
+ */
+
+#include "sqlitepicturedao.h"
+#include "PictureDAO.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutexLocker>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+
+namespace {
+
+const int SchemaVersion = 1;
+
+const char* const SelectColumns =
+    "SELECT nombre, url, descripcion, filePath, favorito, descargada, expirationDate FROM pictures";
+
+QVariant dayValue(const QDate& date)
+{
+    return date.isValid() ? QVariant(date.toJulianDay()) : QVariant(QVariant::LongLong);
+}
+
+bool exec(QSqlQuery& query, const QString& sql)
+{
+    if (query.exec(sql)) return true;
+    qWarning() << "Error SQL:" << sql << query.lastError().text();
+    return false;
+}
+
+} // namespace
+
+/**
+ * @brief Constructor.
+ * @param dbPath Ruta del fichero SQLite (se crea si no existe).
+ */
+SqlitePictureDAO::SqlitePictureDAO(const QString& dbPath)
+    : m_path(dbPath),
+    m_connectionPrefix(QString("pictures-%1-%2-")
+                           .arg(qHash(QFileInfo(dbPath).absoluteFilePath()))
+                           .arg(reinterpret_cast<quintptr>(this))),
+    m_connections(std::make_shared<Connections>())
+{
+}
+
+/**
+ * @brief Destructor: cierra las conexiones que sigan abiertas.
+ */
+SqlitePictureDAO::~SqlitePictureDAO()
+{
+    QMutexLocker locker(&m_connections->mutex);
+    for (const QMetaObject::Connection& cleanup : qAsConst(m_connections->cleanups))
+        QObject::disconnect(cleanup);
+    for (const QString& name : qAsConst(m_connections->names))
+        QSqlDatabase::removeDatabase(name);
+    m_connections->cleanups.clear();
+    m_connections->names.clear();
+}
+
+/**
+ * @brief Devuelve la conexión del hilo actual, abriéndola si hace falta.
+ *
+ * La primera vez que un hilo la pide se le asigna un nombre nuevo (nunca se reutiliza,
+ * aunque el sistema recicle los identificadores de hilo) y se programa su cierre al
+ * terminar el hilo.
+ */
+QSqlDatabase SqlitePictureDAO::database() const
+{
+    QThread* thread = QThread::currentThread();
+    QString name;
+    {
+        QMutexLocker locker(&m_connections->mutex);
+        name = m_connections->names.value(thread);
+        if (name.isEmpty()) {
+            name = m_connectionPrefix + QString::number(++m_connections->serial);
+            m_connections->names.insert(thread, name);
+
+            // Conexión directa: se ejecuta en el hilo que termina, el dueño de la conexión
+            const std::weak_ptr<Connections> weak = m_connections;
+            auto cleanup = [weak, thread, name]() {
+                const std::shared_ptr<Connections> connections = weak.lock();
+                if (!connections) return;
+                QMutexLocker locker(&connections->mutex);
+                if (connections->names.value(thread) != name) return;
+                QObject::disconnect(connections->cleanups.take(thread));
+                connections->names.remove(thread);
+                QSqlDatabase::removeDatabase(name);
+            };
+            m_connections->cleanups.insert(thread, QObject::connect(thread, &QThread::finished, cleanup));
+        }
+    }
+
+    if (QSqlDatabase::contains(name))
+        return QSqlDatabase::database(name);
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", name);
+    db.setDatabaseName(m_path);
+    if (!db.open()) {
+        qWarning() << "No se pudo abrir la base de datos:" << m_path << db.lastError().text();
+        return db;
+    }
+
+    QSqlQuery pragma(db);
+    pragma.exec("PRAGMA journal_mode=WAL");
+    pragma.exec("PRAGMA synchronous=NORMAL");
+    return db;
+}
+
+/**
+ * @brief Abre la base de datos y crea el esquema e índices si no existen.
+ * @return true si la base de datos está lista para usarse.
+ */
+bool SqlitePictureDAO::open()
+{
+    QSqlDatabase db = database();
+    if (!db.isOpen()) return false;
+
+    QSqlQuery query(db);
+    return exec(query, "CREATE TABLE IF NOT EXISTS pictures ("
+                       " id INTEGER PRIMARY KEY,"
+                       " nombre TEXT NOT NULL,"
+                       " url TEXT NOT NULL UNIQUE,"
+                       " descripcion TEXT,"
+                       " filePath TEXT,"
+                       " favorito INTEGER NOT NULL DEFAULT 0,"
+                       " descargada INTEGER NOT NULL DEFAULT 0,"
+                       " expirationDate INTEGER)")
+           && exec(query, "CREATE INDEX IF NOT EXISTS idx_pictures_nombre ON pictures(nombre)")
+           && exec(query, "CREATE INDEX IF NOT EXISTS idx_pictures_favorito ON pictures(favorito)")
+           && exec(query, "CREATE INDEX IF NOT EXISTS idx_pictures_descargada ON pictures(descargada)")
+           && exec(query, "CREATE INDEX IF NOT EXISTS idx_pictures_expiration ON pictures(expirationDate)");
+}
+
+/**
+ * @brief Indica si ya se realizó la migración desde JSON (PRAGMA user_version).
+ */
+bool SqlitePictureDAO::isMigrated() const
+{
+    QSqlQuery query(database());
+    if (!query.exec("PRAGMA user_version") || !query.next()) return false;
+    return query.value(0).toInt() >= SchemaVersion;
+}
+
+/**
+ * @brief Migra una única vez el contenido de los JSON existentes.
+ *
+ * Se carga el catálogo, se fusiona el estado de downloaded.json por URL (resuelta
+ * respecto a basePath) y todo se inserta en una sola transacción. Si la base de datos
+ * ya estaba migrada no se hace nada.
+ *
+ * @param catalogPath Ruta de download.json.
+ * @param downloadedPath Ruta de downloaded.json.
+ * @param basePath Ruta base para convertir URLs relativas en absolutas.
+ * @return true si la base de datos queda migrada.
+ */
+bool SqlitePictureDAO::migrateFromJson(const QString& catalogPath, const QString& downloadedPath,
+                                       const QString& basePath)
+{
+    if (isMigrated()) return true;
+
+    const QDir baseDir(basePath);
+    auto resolve = [&baseDir](const QString& url) {
+        return QFileInfo(url).isAbsolute() ? url : baseDir.filePath(url);
+    };
+
+    QList<Picture> pictures = PictureDAO::loadCatalog(catalogPath);
+    QHash<QString, int> rowByUrl;
+    rowByUrl.reserve(pictures.size());
+    for (int i = 0; i < pictures.size(); ++i) {
+        pictures[i].setUrl(resolve(pictures[i].url()));
+        rowByUrl.insert(pictures[i].url(), i);
+    }
+
+    for (const Picture& pic : PictureDAO::loadDownloaded(downloadedPath)) {
+        const int row = rowByUrl.value(resolve(pic.url()), -1);
+        if (row < 0) continue;
+        pictures[row].setDescargada(true);
+        pictures[row].setFavorito(pic.favorito());
+        pictures[row].setFilePath(pic.filePath());
+        if (pic.expirationDate().isValid())
+            pictures[row].setExpirationDate(pic.expirationDate());
+    }
+
+    if (!savePictures(pictures)) return false;
+
+    QSqlQuery query(database());
+    return exec(query, QString("PRAGMA user_version = %1").arg(SchemaVersion));
+}
+
+/**
+ * @brief Alinea la tabla con el catálogo, en una única transacción.
+ *
+ * La migración solo se hace una vez; después, lo que cambie en download.json llega
+ * por aquí: se insertan las URLs nuevas (con el estado que traigan), se actualizan
+ * nombre y descripción de las existentes y se borran las que ya no están. El estado
+ * de las filas existentes (favorito, descarga, caducidad) no se toca.
+ *
+ * @param catalog Catálogo completo, con las URLs ya resueltas.
+ * @return true si la transacción se confirmó.
+ */
+bool SqlitePictureDAO::syncCatalog(const QList<Picture>& catalog)
+{
+    QSqlDatabase db = database();
+    if (!db.transaction()) return false;
+
+    QVariantList nombres, urls, descripciones, paths, favoritos, descargadas, fechas;
+    for (const Picture& pic : catalog) {
+        nombres << pic.nombre();
+        urls << pic.url();
+        descripciones << pic.descripcion();
+        paths << pic.filePath();
+        favoritos << (pic.favorito() ? 1 : 0);
+        descargadas << (pic.descargada() ? 1 : 0);
+        fechas << dayValue(pic.expirationDate());
+    }
+
+    // Las URLs del catálogo, en una tabla temporal de esta conexión, para borrar el resto
+    QSqlQuery query(db);
+    bool ok = exec(query, "CREATE TEMP TABLE IF NOT EXISTS catalog_urls (url TEXT PRIMARY KEY)")
+              && exec(query, "DELETE FROM catalog_urls");
+    if (ok) {
+        query.prepare("INSERT OR IGNORE INTO catalog_urls (url) VALUES (?)");
+        query.addBindValue(urls);
+        ok = query.execBatch();
+    }
+    if (ok) {
+        query.prepare("INSERT INTO pictures (nombre, url, descripcion, filePath, favorito, descargada, expirationDate)"
+                      " VALUES (?, ?, ?, ?, ?, ?, ?)"
+                      " ON CONFLICT(url) DO UPDATE SET nombre = excluded.nombre,"
+                      " descripcion = excluded.descripcion");
+        query.addBindValue(nombres);
+        query.addBindValue(urls);
+        query.addBindValue(descripciones);
+        query.addBindValue(paths);
+        query.addBindValue(favoritos);
+        query.addBindValue(descargadas);
+        query.addBindValue(fechas);
+        ok = query.execBatch();
+    }
+    ok = ok && exec(query, "DELETE FROM pictures WHERE url NOT IN (SELECT url FROM catalog_urls)");
+
+    if (!ok) {
+        qWarning() << "Error sincronizando el catalogo:" << query.lastError().text();
+        db.rollback();
+        return false;
+    }
+    return db.commit();
+}
+
+/**
+ * @brief Inserta o actualiza una lista de Picture en una única transacción (execBatch).
+ * @param pictures Imágenes a guardar; la URL identifica la fila.
+ * @return true si la transacción se confirmó.
+ */
+bool SqlitePictureDAO::savePictures(const QList<Picture>& pictures)
+{
+    QSqlDatabase db = database();
+    if (!db.transaction()) return false;
+
+    QVariantList nombres, urls, descripciones, paths, favoritos, descargadas, fechas;
+    for (const Picture& pic : pictures) {
+        nombres << pic.nombre();
+        urls << pic.url();
+        descripciones << pic.descripcion();
+        paths << pic.filePath();
+        favoritos << (pic.favorito() ? 1 : 0);
+        descargadas << (pic.descargada() ? 1 : 0);
+        fechas << dayValue(pic.expirationDate());
+    }
+
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO pictures (nombre, url, descripcion, filePath, favorito, descargada, expirationDate)"
+                  " VALUES (?, ?, ?, ?, ?, ?, ?)"
+                  " ON CONFLICT(url) DO UPDATE SET nombre = excluded.nombre,"
+                  " descripcion = excluded.descripcion, filePath = excluded.filePath,"
+                  " favorito = excluded.favorito, descargada = excluded.descargada,"
+                  " expirationDate = excluded.expirationDate");
+    query.addBindValue(nombres);
+    query.addBindValue(urls);
+    query.addBindValue(descripciones);
+    query.addBindValue(paths);
+    query.addBindValue(favoritos);
+    query.addBindValue(descargadas);
+    query.addBindValue(fechas);
+
+    if (!query.execBatch()) {
+        qWarning() << "Error guardando imagenes:" << query.lastError().text();
+        db.rollback();
+        return false;
+    }
+    return db.commit();
+}
+
+/**
+ * @brief Aplica un lote de cambios de estado (mismos registros que el diario).
+ *
+ * Las consultas se preparan una vez y se ejecutan en orden dentro de una única
+ * transacción, de modo que un lote se aplica entero o no se aplica.
+ *
+ * @param records Cambios en orden cronológico.
+ * @return true si la transacción se confirmó.
+ */
+bool SqlitePictureDAO::applyChanges(const QList<StateJournal::Record>& records)
+{
+    if (records.isEmpty()) return true;
+
+    QSqlDatabase db = database();
+    if (!db.transaction()) return false;
+
+    QSqlQuery downloaded(db), removed(db), favorite(db);
+    downloaded.prepare("UPDATE pictures SET descargada = 1, filePath = ?, expirationDate = ? WHERE url = ?");
+    removed.prepare("UPDATE pictures SET descargada = 0, favorito = 0 WHERE url = ?");
+    favorite.prepare("UPDATE pictures SET favorito = ? WHERE url = ?");
+
+    bool ok = true;
+    for (const StateJournal::Record& rec : records) {
+        QSqlQuery* query = nullptr;
+        switch (rec.type) {
+        case StateJournal::Downloaded:
+            query = &downloaded;
+            query->addBindValue(rec.filePath);
+            query->addBindValue(dayValue(rec.expirationDate));
+            break;
+        case StateJournal::Removed:
+            query = &removed;
+            break;
+        case StateJournal::Favorite:
+            query = &favorite;
+            query->addBindValue(rec.favorito ? 1 : 0);
+            break;
+        }
+        query->addBindValue(rec.url);
+        if (!query->exec()) {
+            qWarning() << "Error aplicando cambio:" << rec.url << query->lastError().text();
+            ok = false;
+            break;
+        }
+    }
+
+    if (!ok) {
+        db.rollback();
+        return false;
+    }
+    return db.commit();
+}
+
+QList<Picture> SqlitePictureDAO::loadAll() const
+{
+    return select(QString());
+}
+
+QList<Picture> SqlitePictureDAO::downloaded() const
+{
+    return select("descargada = 1");
+}
+
+QList<Picture> SqlitePictureDAO::favorites() const
+{
+    return select("favorito = 1");
+}
+
+/**
+ * @brief Imágenes con fecha de caducidad anterior a 'date' (usa idx_pictures_expiration).
+ */
+QList<Picture> SqlitePictureDAO::expiringBefore(const QDate& date) const
+{
+    return select("expirationDate IS NOT NULL AND expirationDate < ?",
+                  QVariantList() << date.toJulianDay());
+}
+
+QList<Picture> SqlitePictureDAO::findByName(const QString& name) const
+{
+    return select("nombre = ?", QVariantList() << name);
+}
+
+int SqlitePictureDAO::count() const
+{
+    QSqlQuery query(database());
+    if (!query.exec("SELECT COUNT(*) FROM pictures") || !query.next()) return 0;
+    return query.value(0).toInt();
+}
+
+/**
+ * @brief Ejecuta un SELECT con el filtro indicado, en orden de inserción.
+ */
+QList<Picture> SqlitePictureDAO::select(const QString& where, const QVariantList& values) const
+{
+    QList<Picture> list;
+    QSqlQuery query(database());
+    query.setForwardOnly(true);
+
+    QString sql = SelectColumns;
+    if (!where.isEmpty()) sql += " WHERE " + where;
+    sql += " ORDER BY id";
+
+    query.prepare(sql);
+    for (const QVariant& value : values)
+        query.addBindValue(value);
+
+    if (!query.exec()) {
+        qWarning() << "Error SQL:" << sql << query.lastError().text();
+        return list;
+    }
+
+    while (query.next())
+        list.append(fromQuery(query));
+    return list;
+}
+
+Picture SqlitePictureDAO::fromQuery(const QSqlQuery& query)
+{
+    Picture pic(query.value(0).toString(), query.value(1).toString(), query.value(2).toString());
+    pic.setFilePath(query.value(3).toString());
+    pic.setFavorito(query.value(4).toInt() != 0);
+    pic.setDescargada(query.value(5).toInt() != 0);
+    if (!query.value(6).isNull())
+        pic.setExpirationDate(QDate::fromJulianDay(query.value(6).toLongLong()));
+    return pic;
+}
@@ -0,0 +1,72 @@
+#ifndef SQLITEPICTUREDAO_H
+#define SQLITEPICTUREDAO_H
+
+#include "Picture.h"
+#include "statejournal.h"
+#include "SuiteCore_global.h"
+#include <QDate>
+#include <QHash>
+#include <QList>
+#include <QMetaObject>
+#include <QMutex>
+#include <QString>
+#include <QVariantList>
+#include <memory>
+
+class QSqlDatabase;
+class QSqlQuery;
+class QThread;
+
+// Almacenamiento en SQLite (QtSql) con índices para las consultas habituales.
+// Cada hilo usa su propia conexión, por lo que puede usarse desde el hilo de escritura;
+// la conexión de un hilo se cierra cuando el hilo termina.
+class SUITECORE_EXPORT SqlitePictureDAO
+{
+public:
+    explicit SqlitePictureDAO(const QString& dbPath);
+    ~SqlitePictureDAO();
+
+    bool open();
+    QString path() const { return m_path; }
+    bool isMigrated() const;
+
+    // Migración única desde download.json / downloaded.json
+    bool migrateFromJson(const QString& catalogPath, const QString& downloadedPath,
+                         const QString& basePath);
+
+    // Alinea las filas con el catálogo actual sin tocar el estado de las existentes
+    bool syncCatalog(const QList<Picture>& catalog);
+
+    QList<Picture> loadAll() const;
+
+    // Escrituras transaccionales y por lotes
+    bool savePictures(const QList<Picture>& pictures);
+    bool applyChanges(const QList<StateJournal::Record>& records);
+
+    // Consultas con índice
+    QList<Picture> downloaded() const;
+    QList<Picture> favorites() const;
+    QList<Picture> expiringBefore(const QDate& date) const;
+    QList<Picture> findByName(const QString& name) const;
+    int count() const;
+
+private:
+    QSqlDatabase database() const;
+    QList<Picture> select(const QString& where, const QVariantList& values = QVariantList()) const;
+    static Picture fromQuery(const QSqlQuery& query);
+
+    // Conexiones abiertas por este DAO, una por hilo; compartidas con los avisos de
+    // QThread::finished, que pueden llegar después de destruir el DAO
+    struct Connections {
+        QMutex mutex;
+        QHash<QThread*, QString> names;
+        QHash<QThread*, QMetaObject::Connection> cleanups;
+        int serial = 0;
+    };
+
+    QString m_path;
+    QString m_connectionPrefix;
+    std::shared_ptr<Connections> m_connections;
+};
+
+#endif // SQLITEPICTUREDAO_H
@@ -0,0 +1,281 @@
+/**
+ * @file statejournal.cpp
+ * @brief Diario append-only de cambios de estado de las imágenes.
+ *
+ * En lugar de reescribir downloaded.json completo en cada cambio (favorito, descarga,
+ * borrado), PictureManager añade un registro pequeño al final de downloaded.journal.
+ * Al arrancar, loadDownloaded() aplica downloaded.json y después reproduce el diario.
+ *
+ * Formato de cada registro:
+ *   [quint32 longitud][quint32 CRC32 del contenido][contenido (QDataStream)]
+ *
+ * El contenido termina con el instante en que se añadió el registro (ms desde epoch).
+ * La antigüedad del diario para la compactación se toma del primer registro, así que
+ * sobrevive a los reinicios aunque después se haya seguido añadiendo al final.
+ *
+ * Si la aplicación se cierra a mitad de una escritura, el último registro queda
+ * incompleto o con CRC incorrecto: replay() lo detecta, lo descarta y trunca el
+ * fichero en el último registro válido.
+ */
+
+#include "statejournal.h"
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtEndian>
+#include <array>
+
+namespace {
+
+const int HeaderSize = 2 * sizeof(quint32);
+const quint32 MaxRecordSize = 64 * 1024;
+
+/**
+ * @brief CRC32 (polinomio IEEE 802.3) para validar cada registro.
+ */
+quint32 crc32(const QByteArray& data)
+{
+    static const auto table = [] {
+        std::array<quint32, 256> t{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (const char ch : data)
+        crc = table[(crc ^ static_cast<quint8>(ch)) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+} // namespace
+
+/**
+ * @brief Constructor.
+ * @param path Ruta del fichero de diario (puede asignarse después con setPath()).
+ */
+StateJournal::StateJournal(const QString& path)
+{
+    if (!path.isEmpty()) setPath(path);
+}
+
+void StateJournal::setPath(const QString& path)
+{
+    QMutexLocker locker(&m_mutex);
+    m_path = path;
+    QFileInfo info(path);
+    m_size = info.exists() ? info.size() : 0;
+    m_firstRecordTime = QDateTime();
+    if (m_size > 0) {
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly))
+            m_firstRecordTime = firstRecordTime(file.read(HeaderSize + MaxRecordSize));
+    }
+}
+
+QString StateJournal::path() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_path;
+}
+
+qint64 StateJournal::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_size;
+}
+
+/**
+ * @brief Indica si el diario supera el tamaño o la antigüedad máximos.
+ */
+bool StateJournal::needsCompaction() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_size >= CompactionSize) return true;
+    return m_firstRecordTime.isValid()
+           && m_firstRecordTime.secsTo(QDateTime::currentDateTime()) >= CompactionAgeSecs;
+}
+
+/**
+ * @brief Añade un registro al final del diario.
+ * @param record Cambio de estado a registrar.
+ * @return true si el registro se escribió completo.
+ */
+bool StateJournal::append(const Record& record)
+{
+    return append(QList<Record>() << record);
+}
+
+/**
+ * @brief Añade varios registros al final del diario con una única escritura.
+ *
+ * Las cabeceras y contenidos se concatenan antes de escribir, lo que reduce las
+ * llamadas al sistema y la ventana en la que un cierre inesperado deja un registro
+ * a medias (que replay() descartaría).
+ *
+ * @param records Cambios de estado a registrar, en orden.
+ * @return true si todos los registros se escribieron completos.
+ */
+bool StateJournal::append(const QList<Record>& records)
+{
+    if (records.isEmpty()) return true;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QByteArray bytes;
+    for (const Record& record : records) {
+        const QByteArray payload = encode(record, now);
+        char header[HeaderSize];
+        qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), header);
+        qToLittleEndian<quint32>(crc32(payload), header + sizeof(quint32));
+        bytes.append(header, HeaderSize);
+        bytes.append(payload);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    QFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "No se pudo escribir el diario:" << m_path;
+        return false;
+    }
+
+    const bool ok = file.write(bytes) == bytes.size();
+    file.close();
+    if (!ok) return false;
+
+    if (m_size == 0) m_firstRecordTime = QDateTime::fromMSecsSinceEpoch(now);
+    m_size += bytes.size();
+    return true;
+}
+
+/**
+ * @brief Lee todos los registros válidos del diario en orden.
+ *
+ * Al encontrar un registro truncado o con CRC incorrecto se detiene, y el fichero se
+ * recorta para que los siguientes append() continúen tras el último registro válido.
+ *
+ * @return Lista de registros válidos (vacía si no existe el diario).
+ */
+QList<StateJournal::Record> StateJournal::replay()
+{
+    QMutexLocker locker(&m_mutex);
+    QList<Record> records;
+
+    QFile file(m_path);
+    if (!file.exists() || !file.open(QIODevice::ReadWrite)) return records;
+
+    const QByteArray data = file.readAll();
+    int pos = 0;
+    while (pos + HeaderSize <= data.size()) {
+        const quint32 length = qFromLittleEndian<quint32>(data.constData() + pos);
+        const quint32 checksum = qFromLittleEndian<quint32>(data.constData() + pos + sizeof(quint32));
+        if (length > MaxRecordSize || pos + HeaderSize + static_cast<int>(length) > data.size())
+            break;
+
+        const QByteArray payload = data.mid(pos + HeaderSize, static_cast<int>(length));
+        Record record;
+        if (crc32(payload) != checksum || !decode(payload, record))
+            break;
+
+        records.append(record);
+        pos += HeaderSize + static_cast<int>(length);
+    }
+
+    if (pos < data.size()) {
+        qWarning() << "Diario con cola corrupta, se descartan" << (data.size() - pos) << "bytes:" << m_path;
+        file.resize(pos);
+    }
+
+    m_size = pos;
+    if (m_size == 0) m_firstRecordTime = QDateTime();
+    return records;
+}
+
+/**
+ * @brief Elimina los primeros 'offset' bytes del diario (ya compactados).
+ *
+ * Los registros añadidos después de capturar 'offset' se conservan: se reescribe
+ * solo la cola de forma atómica con QSaveFile.
+ *
+ * @param offset Tamaño del diario en el momento en que se tomó la copia compactada.
+ * @return true si el diario se actualizó correctamente.
+ */
+bool StateJournal::discardPrefix(qint64 offset)
+{
+    QMutexLocker locker(&m_mutex);
+    if (offset <= 0) return true;
+
+    QByteArray tail;
+    {
+        QFile file(m_path);
+        if (file.open(QIODevice::ReadOnly) && file.seek(offset))
+            tail = file.readAll();
+    }
+
+    QSaveFile out(m_path);
+    if (!out.open(QIODevice::WriteOnly)) return false;
+    out.write(tail);
+    if (!out.commit()) return false;
+
+    m_size = tail.size();
+    m_firstRecordTime = m_size > 0 ? firstRecordTime(tail) : QDateTime();
+    return true;
+}
+
+/**
+ * @brief Instante en que se añadió el primer registro de @p data (inicio del diario).
+ *
+ * Los diarios escritos antes de que los registros llevaran marca de tiempo se dan por
+ * antiguos, de modo que la primera escritura los compacta.
+ */
+QDateTime StateJournal::firstRecordTime(const QByteArray& data)
+{
+    if (data.size() < HeaderSize) return QDateTime();
+    const quint32 length = qFromLittleEndian<quint32>(data.constData());
+    const quint32 checksum = qFromLittleEndian<quint32>(data.constData() + sizeof(quint32));
+    if (length > MaxRecordSize || HeaderSize + static_cast<int>(length) > data.size())
+        return QDateTime();
+
+    const QByteArray payload = data.mid(HeaderSize, static_cast<int>(length));
+    Record record;
+    qint64 writtenMs = 0;
+    if (crc32(payload) != checksum || !decode(payload, record, &writtenMs))
+        return QDateTime();
+    return QDateTime::fromMSecsSinceEpoch(writtenMs);
+}
+
+QByteArray StateJournal::encode(const Record& record, qint64 writtenMs)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << static_cast<quint8>(record.type)
+        << record.url
+        << record.favorito
+        << record.filePath
+        << record.expirationDate
+        << writtenMs;
+    return payload;
+}
+
+bool StateJournal::decode(const QByteArray& payload, Record& record, qint64* writtenMs)
+{
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint8 type = 0;
+    qint64 written = 0;
+    in >> type >> record.url >> record.favorito >> record.filePath >> record.expirationDate;
+    if (!in.atEnd()) in >> written; // ausente en diarios anteriores
+    if (in.status() != QDataStream::Ok) return false;
+    if (type < Downloaded || type > Favorite) return false;
+
+    record.type = static_cast<RecordType>(type);
+    if (writtenMs) *writtenMs = written;
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef STATEJOURNAL_H
+#define STATEJOURNAL_H
+
+#include "SuiteCore_global.h"
+#include <QDate>
+#include <QDateTime>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+// Diario de cambios de estado (solo se añade al final). Cada registro lleva su
+// longitud y un CRC32, de modo que una cola escrita a medias se detecta y se descarta.
+class SUITECORE_EXPORT StateJournal
+{
+public:
+    enum RecordType : quint8 {
+        Downloaded = 1,
+        Removed = 2,
+        Favorite = 3
+    };
+
+    struct Record {
+        RecordType type = Favorite;
+        QString url;
+        bool favorito = false;
+        QString filePath;
+        QDate expirationDate;
+    };
+
+    // Umbrales a partir de los cuales conviene compactar en downloaded.json
+    static constexpr qint64 CompactionSize = 256 * 1024;
+    static constexpr int CompactionAgeSecs = 10 * 60;
+
+    explicit StateJournal(const QString& path = QString());
+
+    void setPath(const QString& path);
+    QString path() const;
+
+    bool append(const Record& record);
+    bool append(const QList<Record>& records);
+    QList<Record> replay();
+
+    qint64 size() const;
+    bool needsCompaction() const;
+
+    // Elimina los registros hasta 'offset' (ya volcados a downloaded.json)
+    bool discardPrefix(qint64 offset);
+
+private:
+    static QByteArray encode(const Record& record, qint64 writtenMs);
+    static bool decode(const QByteArray& payload, Record& record, qint64* writtenMs = nullptr);
+    static QDateTime firstRecordTime(const QByteArray& data);
+
+    mutable QMutex m_mutex;
+    QString m_path;
+    qint64 m_size = 0;
+    QDateTime m_firstRecordTime;
+};
+
+#endif // STATEJOURNAL_H
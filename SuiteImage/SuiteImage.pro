@@ -0,0 +1,26 @@
+QT += gui concurrent
+
+TEMPLATE = lib
+DEFINES += SUITEIMAGE_LIBRARY
+
+CONFIG += c++17
+
+# Módulo opcional de decodificación de imágenes (QtGui). SuiteCore no depende de él:
+# los servicios sin interfaz enlazan solo SuiteCore, que usa únicamente QtCore.
+
+SOURCES += \
+    imagestore.cpp
+
+HEADERS += \
+    SuiteImage_global.h \
+    imagestore.h
+
+# Solo se usan cabeceras de SuiteCore (PictureId): no hace falta enlazarla
+INCLUDEPATH += $$PWD/../SuiteCore
+DEPENDPATH += $$PWD/../SuiteCore
+
+# Default rules for deployment.
+unix {
+    target.path = /usr/lib
+}
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,12 @@
+#ifndef SUITEIMAGE_GLOBAL_H
+#define SUITEIMAGE_GLOBAL_H
+
+#include <QtCore/qglobal.h>
+
+#if defined(SUITEIMAGE_LIBRARY)
+#define SUITEIMAGE_EXPORT Q_DECL_EXPORT
+#else
+#define SUITEIMAGE_EXPORT Q_DECL_IMPORT
+#endif
+
+#endif // SUITEIMAGE_GLOBAL_H
@@ -0,0 +1,168 @@
+/**
+ * @file imagestore.cpp
+ * @brief Caché de píxeles de las imágenes, separada de Picture.
+ *
+ * Picture se copia entre hilos (lambdas de QtConcurrent, señales en cola, lotes de la
+ * carga asíncrona) y no debe llevar QPixmap: es un recurso del hilo de la interfaz y
+ * además cada copia de la lista arrastraría su manejador. ImageStore guarda los
+ * píxeles aparte, por PictureId:
+ * - como QImage, que se puede cargar y leer desde cualquier hilo,
+ * - en una QCache cuyo coste es el tamaño en KiB, de modo que al superar el
+ *   presupuesto se descartan las menos usadas,
+ * - cargadas bajo demanda (image() bloqueante o request() en el pool),
+ * - convertidas a QPixmap solo en pixmap(), que exige el hilo de la interfaz.
+ */
+
+#include "imagestore.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+#include <limits>
+
+namespace {
+
+int costOf(const QImage& image)
+{
+    return qMax(1, int(image.sizeInBytes() / 1024));
+}
+
+} // namespace
+
+/**
+ * @brief Constructor.
+ * @param budgetBytes Memoria máxima para los píxeles en caché.
+ * @param parent Objeto padre.
+ */
+ImageStore::ImageStore(qint64 budgetBytes, QObject* parent)
+    : QObject(parent)
+{
+    setBudget(budgetBytes);
+}
+
+/**
+ * @brief Destructor: espera a las cargas de request() que sigan en curso.
+ */
+ImageStore::~ImageStore()
+{
+    m_pool.waitForDone();
+}
+
+/**
+ * @brief Cambia el presupuesto; si se reduce, se descartan las imágenes menos usadas.
+ */
+void ImageStore::setBudget(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.setMaxCost(int(qBound<qint64>(1, bytes / 1024, std::numeric_limits<int>::max())));
+}
+
+qint64 ImageStore::budget() const
+{
+    QMutexLocker locker(&m_mutex);
+    return qint64(m_cache.maxCost()) * 1024;
+}
+
+qint64 ImageStore::cost() const
+{
+    QMutexLocker locker(&m_mutex);
+    return qint64(m_cache.totalCost()) * 1024;
+}
+
+/**
+ * @brief Píxeles de una imagen; si no están en caché se leen de 'path' en este hilo.
+ * @return Imagen nula si el fichero no se puede leer.
+ */
+QImage ImageStore::image(PictureId id, const QString& path)
+{
+    const QImage hit = cached(id);
+    if (!hit.isNull()) return hit;
+
+    const QImage loaded = load(path);
+    if (!loaded.isNull()) insert(id, loaded);
+    return loaded;
+}
+
+/**
+ * @brief Píxeles en caché (copia implícitamente compartida), o imagen nula.
+ */
+QImage ImageStore::cached(PictureId id) const
+{
+    QMutexLocker locker(&m_mutex);
+    const QImage* image = m_cache.object(id);
+    return image ? *image : QImage();
+}
+
+/**
+ * @brief Carga una imagen en el pool de hilos y emite imageReady(id) al terminar.
+ *
+ * No hace nada si ya está en caché (emite imageReady() directamente) o si ya hay
+ * una carga en curso para ese id.
+ */
+void ImageStore::request(PictureId id, const QString& path)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_cache.contains(id)) {
+            locker.unlock();
+            emit imageReady(id);
+            return;
+        }
+        if (m_pending.contains(id)) return;
+        m_pending.insert(id);
+    }
+
+    QtConcurrent::run(&m_pool, [this, id, path]() {
+        const QImage loaded = load(path);
+        {
+            QMutexLocker locker(&m_mutex);
+            m_pending.remove(id);
+        }
+        if (loaded.isNull()) return;
+        insert(id, loaded);
+        emit imageReady(id);
+    });
+}
+
+void ImageStore::remove(PictureId id)
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.remove(id);
+}
+
+void ImageStore::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+}
+
+/**
+ * @brief Convierte la imagen a QPixmap para pintarla. Solo en el hilo de la interfaz.
+ * @return Pixmap nulo si la imagen no se puede cargar.
+ */
+QPixmap ImageStore::pixmap(PictureId id, const QString& path)
+{
+    Q_ASSERT_X(QThread::currentThread() == QCoreApplication::instance()->thread(),
+               "ImageStore::pixmap", "QPixmap solo puede crearse en el hilo de la interfaz");
+    const QImage source = image(id, path);
+    return source.isNull() ? QPixmap() : QPixmap::fromImage(source);
+}
+
+QImage ImageStore::load(const QString& path)
+{
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    const QImage image = reader.read();
+    if (image.isNull())
+        qWarning() << "No se pudo cargar la imagen" << path << ":" << reader.errorString();
+    return image;
+}
+
+void ImageStore::insert(PictureId id, const QImage& image)
+{
+    QMutexLocker locker(&m_mutex);
+    // Si la imagen sola supera el presupuesto, QCache no la guarda (se devuelve igualmente)
+    m_cache.insert(id, new QImage(image), costOf(image));
+}
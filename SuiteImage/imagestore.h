@@ -0,0 +1,56 @@
+#ifndef IMAGESTORE_H
+#define IMAGESTORE_H
+
+#include "Picture.h"
+#include "SuiteImage_global.h"
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QPixmap>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+
+// Píxeles de las imágenes, separados de Picture (que solo lleva metadatos) y
+// indexados por PictureId. Guarda QImage (utilizables desde cualquier hilo) en una
+// caché con presupuesto de memoria; se cargan del disco bajo demanda y solo se
+// convierten a QPixmap en el hilo de la interfaz.
+class SUITEIMAGE_EXPORT ImageStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr qint64 DefaultBudget = 64 * 1024 * 1024;
+
+    explicit ImageStore(qint64 budgetBytes = DefaultBudget, QObject* parent = nullptr);
+    ~ImageStore() override;
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+    qint64 cost() const; // bytes ocupados (aprox., en KiB completos)
+
+    // Seguras desde cualquier hilo
+    QImage image(PictureId id, const QString& path); // carga si no está en caché (bloquea)
+    QImage cached(PictureId id) const;               // nunca hace E/S
+    void request(PictureId id, const QString& path); // carga en el pool y emite imageReady()
+    void remove(PictureId id);
+    void clear();
+
+    // Solo en el hilo de la interfaz
+    QPixmap pixmap(PictureId id, const QString& path);
+
+signals:
+    void imageReady(PictureId id);
+
+private:
+    static QImage load(const QString& path);
+    void insert(PictureId id, const QImage& image);
+
+    mutable QMutex m_mutex;
+    QCache<PictureId, QImage> m_cache; // coste en KiB
+    QSet<PictureId> m_pending;         // cargas en curso de request()
+    QThreadPool m_pool;                // propio: el destructor espera a sus cargas
+};
+
+#endif // IMAGESTORE_H
@@ -45,6 +45,13 @@ else:unix: LIBS += -L$$OUT_PWD/../SuiteCore/ -lSuiteCore
 INCLUDEPATH += $$PWD/../SuiteCore
 DEPENDPATH += $$PWD/../SuiteCore
 
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../SuiteImage/release/ -lSuiteImage
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../SuiteImage/debug/ -lSuiteImage
+else:unix: LIBS += -L$$OUT_PWD/../SuiteImage/ -lSuiteImage
+
+INCLUDEPATH += $$PWD/../SuiteImage
+DEPENDPATH += $$PWD/../SuiteImage
+
 TRANSLATIONS += \
         translations/app_es.ts
 
@@ -6,7 +6,9 @@
  * - un modelo (QStandardItemModel) con un proxy (QSortFilterProxyModel) para búsqueda/filtrado,
  * - un delegado personalizado (ImageCardDelegate) para dibujar cada tarjeta,
  * - autocompletado para la búsqueda,
- * - controles para alternar vista, filtrar favoritos, mostrar info y borrar imágenes descargadas.
+ * - controles para alternar vista, filtrar favoritos, mostrar info y borrar imágenes descargadas,
+ * - selección múltiple con menú contextual (borrar, marcar/desmarcar favoritos) que usa las
+ *   operaciones masivas de PictureManager: un cambio y una sola notificación por acción.
  *
  * Las responsabilidades principales son: mantener la lista visual actualizada (refreshList),
  * conectar señales/slots con PictureManager y propagar eventos (openPicture, pictureDeleted, ...).
@@ -20,12 +22,11 @@
 #include <QMessageBox>
 #include <QTimer>
 #include <QLineEdit>
+#include <QMenu>
 #include <QPushButton>
 #include <QStandardItemModel>
 #include <QSortFilterProxyModel>
-#include <QDate>
 #include <QDebug>
-#include <QtConcurrent>
 
 /**
  * @brief Constructor.
@@ -63,6 +64,8 @@ DownloadedWidget::DownloadedWidget(QWidget *parent)
     ui->DownloadedPictureList->setModel(m_downloadedProxy);
     ui->DownloadedPictureList->setItemDelegate(m_delegate);
     ui->DownloadedPictureList->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    ui->DownloadedPictureList->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    ui->DownloadedPictureList->setContextMenuPolicy(Qt::CustomContextMenu);
     disableDragDrop(ui->DownloadedPictureList);
 
     // Autocompletar para la búsqueda
@@ -111,38 +114,25 @@ void DownloadedWidget::setupConnections() {
     });
 
     // Favoritos: el delegado emite favoriteToggled con el QModelIndex visual.
-    // Aquí mapeamos/actuamos sobre el PictureManager por nombre (simplificación existente).
+    // Cada item guarda el PictureId de su imagen (ItemIdRole).
     connect(m_delegate, &ImageCardDelegate::favoriteToggled, this, [this](const QModelIndex &idx){
         QModelIndex sourceIdx = m_downloadedProxy->mapToSource(idx);
         if (!sourceIdx.isValid() || !m_pictureManager) return;
-        QString url = sourceIdx.data(ItemUrlRole).toString();
-        if (url.isEmpty()) return;
-
-        // Buscar en PictureManager por URL y alternar favorito
-        for (int i = 0; i < m_pictureManager->allPictures().size(); ++i) {
-            const Picture &p = m_pictureManager->allPictures().at(i);
-            if (p.url() == url) {
-                m_pictureManager->toggleFavorite(i); // si tienes toggleFavorite por índice en allPictures
-                // Si no existe toggleFavorite por índice, puedes añadir toggleFavoriteByName(url) o una función toggleFavoriteByUrl(url)
-                break;
-            }
-        }
-        refreshList();
+        const PictureId id = PictureId(sourceIdx.data(ItemIdRole).toUInt());
+        if (id == InvalidPictureId) return;
+
+        // La lista se actualiza al llegar favoritesChanged
+        m_pictureManager->toggleFavorite(id);
     });
 
     // Info: mostrar cuadro con información básica
     connect(m_delegate, &ImageCardDelegate::infoRequested, this, [this](const QModelIndex &idx){
         QModelIndex sourceIdx = m_downloadedProxy->mapToSource(idx);
         if (sourceIdx.isValid() && m_pictureManager) {
-            QString url = sourceIdx.data(ItemUrlRole).toString();
-            if (url.isEmpty()) return;
-            // Buscar Picture en PictureManager::downloaded() por URL
-            for (const auto &pic : m_pictureManager->downloaded()) {
-                if (pic.url() == url) {
-                    QMessageBox::information(this, tr("Info"), tr("Name: %1\nURL: %2").arg(pic.nombre(), pic.url()));
-                    break;
-                }
-            }
+            const PictureId id = PictureId(sourceIdx.data(ItemIdRole).toUInt());
+            const Picture pic = m_pictureManager->picture(id);
+            if (pic.descargada())
+                QMessageBox::information(this, tr("Info"), tr("Name: %1\nURL: %2").arg(pic.nombre(), pic.url()));
         }
     });
 
@@ -150,20 +140,17 @@ void DownloadedWidget::setupConnections() {
     connect(m_delegate, &ImageCardDelegate::doubleClicked, this, [this](const QModelIndex &idx){
         QModelIndex sourceIdx = m_downloadedProxy->mapToSource(idx);
         if (sourceIdx.isValid() && m_pictureManager) {
-            QString url = sourceIdx.data(ItemUrlRole).toString();
-            if (url.isEmpty()) return;
             // Localizar la Picture correspondiente
-            for (const auto &pic : m_pictureManager->downloaded()) {
-                if (pic.url() == url) {
-                    bool expired = pic.expirationDate().isValid() && pic.expirationDate() < QDate::currentDate();
-                    if (expired) {
-                        QMessageBox::warning(this, tr("Expired"), tr("This image is expired and cannot be opened"));
-                        return;
-                    }
-                    emit openPicture(pic);
-                    break;
-                }
+            const PictureId id = PictureId(sourceIdx.data(ItemIdRole).toUInt());
+            const Picture pic = m_pictureManager->picture(id);
+            if (!pic.descargada()) return;
+
+            // Bit precalculado por el planificador de caducidad: sin comparar fechas
+            if (m_pictureManager->isExpired(id)) {
+                QMessageBox::warning(this, tr("Expired"), tr("This image is expired and cannot be opened"));
+                return;
             }
+            emit openPicture(pic);
         }
     });
 
@@ -171,25 +158,35 @@ void DownloadedWidget::setupConnections() {
     connect(m_delegate, &ImageCardDelegate::deleteRequested, this, [this](const QModelIndex &idx){
         QModelIndex sourceIdx = m_downloadedProxy->mapToSource(idx);
         if (sourceIdx.isValid() && m_pictureManager) {
-            QString url = sourceIdx.data(ItemUrlRole).toString();
-
-            if (url.isEmpty()) return;
-            // Buscar en m_pictureManager::downloaded() por URL y solicitar eliminación
-            for (const auto &pic : m_pictureManager->downloaded()) {
-                if (pic.url() == url) {
-                    // 1. Generar duración aleatoria (5 a 10 segundos para desinstalar)
-                    int randomSecs = QRandomGenerator::global()->bounded(5, 11);
-
-                    // 2. Lanzar en hilo separado con AMBOS argumentos
-                    QtConcurrent::run([this, pic, randomSecs]() {
-                        m_pictureManager->removeDownloaded(pic, randomSecs);
-                    });
-                    break;
-                }
-            }
+            const PictureId id = PictureId(sourceIdx.data(ItemIdRole).toUInt());
+            if (!m_pictureManager->picture(id).descargada()) return;
+
+            // Duración aleatoria (5 a 10 segundos para desinstalar); no bloquea
+            const int randomSecs = QRandomGenerator::global()->bounded(5, 11);
+            m_pictureManager->removeDownloaded(id, randomSecs);
         }
     });
 
+    // Menú contextual sobre la selección: cada acción es una sola operación masiva
+    connect(ui->DownloadedPictureList, &QWidget::customContextMenuRequested, this, [this](const QPoint &pos) {
+        const QVector<PictureId> ids = selectedIds();
+        if (ids.isEmpty() || !m_pictureManager) return;
+
+        QMenu menu(this);
+        menu.addAction(tr("Add to favourites"), this, [this, ids]() {
+            m_pictureManager->setFavoriteMany(ids, true);
+        });
+        menu.addAction(tr("Remove from favourites"), this, [this, ids]() {
+            m_pictureManager->setFavoriteMany(ids, false);
+        });
+        QAction* remove = menu.addAction(tr("Delete selected (%1)").arg(ids.size()), this, [this, ids]() {
+            const int randomSecs = QRandomGenerator::global()->bounded(5, 11);
+            m_pictureManager->removeMany(ids, randomSecs);
+        });
+        remove->setEnabled(!m_delegate->isMassDownloadInProgress());
+        menu.exec(ui->DownloadedPictureList->viewport()->mapToGlobal(pos));
+    });
+
     // Mostrar progreso de descarga/eliminación
     connect(m_pictureManager, &PictureManager::downloadProgress,
             this, &DownloadedWidget::onDownloadProgress);
@@ -217,44 +214,199 @@ void DownloadedWidget::setupConnections() {
 /**
  * @brief Refresca la lista visual a partir de PictureManager::downloaded().
  *
- * Aplica filtros: búsqueda por texto y flag de "solo favoritos". Además marca
- * visualmente si una imagen está caducada usando la cadena "(Caducada)".
+ * Aplica filtros: búsqueda por texto y flag de "solo favoritos" (en ese caso se recorre
+ * la vista favorites(), normalmente mucho más pequeña). Cada fila se construye con
+ * createItem().
  */
 void DownloadedWidget::refreshList() {
     m_downloadedModel->clear();
+    m_itemsById.clear();
     if (!m_pictureManager) return;
 
     QString search = ui->searchLineEdit->text().toLower();
     bool onlyFavs = ui->btnFilterFavorites->isChecked();
-    QDate today = QDate::currentDate();
 
-    for (const auto &pic : m_pictureManager->downloaded()) {
+    const PictureView source = onlyFavs ? m_pictureManager->favorites()
+                                        : m_pictureManager->downloaded();
+    QList<QStandardItem*> items;
+    for (const PictureRef pic : source) {
+        if (!pic.descargada()) continue;
+        if (!search.isEmpty() && !pic.nombre().toLower().contains(search)) continue;
+
+        items.append(createItem(pic.toPicture(), pic.isExpired()));
+    }
+    if (!items.isEmpty()) m_downloadedModel->invisibleRootItem()->appendRows(items);
+
+    updateCompleterList();
+}
+
+/**
+ * @brief Crea el item visual de una imagen descargada y lo registra en m_itemsById.
+ *
+ * Marca visualmente si la imagen está caducada usando la cadena "(Caducada)".
+ *
+ * @param pic Imagen descargada.
+ * @param expired Bit Expired de la imagen (PictureManager lo mantiene al cambiar de día).
+ * @return Item listo para añadir al modelo.
+ */
+QStandardItem* DownloadedWidget::createItem(const Picture &pic, bool expired) {
+    QStandardItem* item = new QStandardItem(pic.nombre());
+    item->setData(QIcon(pic.url()), Qt::DecorationRole);
+
+    // Identificador único (el texto mostrado puede llevar sufijos y repetirse)
+    item->setData(pic.id(), ItemIdRole);
+
+    item->setData(pic.favorito(), ImageCardDelegate::FavoriteRole);
+    item->setData(true, ImageCardDelegate::DownloadedRole);
+    item->setData(-1, ImageCardDelegate::ProgressRole);
+    item->setData(false, ImageCardDelegate::ExpiredRole);
+    if (expired) markExpired(item);
+
+    m_itemsById.insert(pic.id(), item);
+    return item;
+}
+
+/**
+ * @brief Marca un item como caducado (sufijo "(Caducada)" y ExpiredRole).
+ */
+void DownloadedWidget::markExpired(QStandardItem* item) {
+    if (item->data(ImageCardDelegate::ExpiredRole).toBool()) return;
+    item->setText(item->text() + " (Caducada)");
+    item->setData(true, ImageCardDelegate::ExpiredRole);
+}
+
+/**
+ * @brief Quita la fila de una imagen, si se está mostrando.
+ * @param id Imagen a quitar.
+ */
+void DownloadedWidget::removeItem(PictureId id) {
+    if (QStandardItem* item = m_itemsById.take(id))
+        m_downloadedModel->removeRow(item->row());
+}
+
+/**
+ * @brief Carga asíncrona: añade las imágenes descargadas de un lote.
+ *
+ * Respeta los filtros activos (favoritos y búsqueda) igual que refreshList(). El
+ * autocompletado se actualiza una sola vez, al terminar la carga.
+ *
+ * @param batch Lote entregado por PictureManager::picturesLoaded().
+ */
+void DownloadedWidget::onPicturesLoaded(const QList<Picture> &batch) {
+    const QString search = ui->searchLineEdit->text().toLower();
+    const bool onlyFavs = ui->btnFilterFavorites->isChecked();
+    // El lote ya está publicado: su bit Expired se lee de la versión actual
+    const std::shared_ptr<const PictureStore> store = m_pictureManager->snapshot();
+
+    QList<QStandardItem*> items;
+    for (const Picture &pic : batch) {
+        if (!pic.descargada()) continue;
         if (onlyFavs && !pic.favorito()) continue;
         if (!search.isEmpty() && !pic.nombre().toLower().contains(search)) continue;
+        const int row = store->rowOf(pic.id());
+        items.append(createItem(pic, row >= 0 && store->test(PictureStore::Expired, row)));
+    }
+    if (!items.isEmpty()) m_downloadedModel->invisibleRootItem()->appendRows(items);
+}
 
-        QString displayName = pic.nombre();
-        bool expired = false;
+/**
+ * @brief Recarga en caliente: sustituye las filas de las imágenes modificadas.
+ *
+ * Solo toca las filas afectadas; si con el nuevo nombre la imagen deja de cumplir
+ * el filtro de búsqueda, se retira de la lista.
+ *
+ * @param ids Imágenes cuyo nombre o descripción ha cambiado en el catálogo.
+ */
+void DownloadedWidget::onPicturesChanged(const QVector<PictureId> &ids) {
+    if (!m_pictureManager) return;
+
+    const QString search = ui->searchLineEdit->text().toLower();
 
-        if (pic.expirationDate().isValid() && pic.expirationDate() < today) {
-            displayName += " (Caducada)";
-            expired = true;
+    for (PictureId id : ids) {
+        QStandardItem* item = m_itemsById.value(id);
+        if (!item) continue;
+
+        const Picture pic = m_pictureManager->picture(id);
+        if (!search.isEmpty() && !pic.nombre().toLower().contains(search)) {
+            removeItem(id);
+            continue;
         }
+        m_downloadedModel->setItem(item->row(), createItem(pic, m_pictureManager->isExpired(id)));
+    }
+
+    updateCompleterList();
+}
 
-        QStandardItem* item = new QStandardItem(displayName);
-        item->setData(QIcon(pic.url()), Qt::DecorationRole);
+/**
+ * @brief Recarga en caliente: quita las filas de las imágenes eliminadas del catálogo.
+ * @param ids Imágenes eliminadas.
+ */
+void DownloadedWidget::onPicturesRemoved(const QVector<PictureId> &ids) {
+    for (PictureId id : ids)
+        removeItem(id);
 
-        // Guardamos datos "puros" para referencia segura
-        item->setData(pic.url(), ItemUrlRole);     // identificador único
-        item->setData(pic.nombre(), ItemNameRole); // nombre puro (sin sufijo)
+    updateCompleterList();
+}
 
-        item->setData(pic.favorito(), ImageCardDelegate::FavoriteRole);
-        item->setData(true, ImageCardDelegate::DownloadedRole);
-        item->setData(-1, ImageCardDelegate::ProgressRole);
-        item->setData(expired, ImageCardDelegate::ExpiredRole);
-        m_downloadedModel->appendRow(item);
+/**
+ * @brief Caducidad: marca las filas de las imágenes que acaban de caducar.
+ *
+ * Llega una vez por cambio de día con todos los ids afectados; el resto de filas no
+ * se toca y el delegado solo lee ExpiredRole al pintar.
+ *
+ * @param ids Imágenes caducadas.
+ */
+void DownloadedWidget::onPicturesExpired(const QVector<PictureId> &ids) {
+    for (PictureId id : ids) {
+        if (QStandardItem* item = m_itemsById.value(id))
+            markExpired(item);
     }
+}
 
-    updateCompleterList();
+/**
+ * @brief Ids (del modelo fuente) de los elementos seleccionados en la vista filtrada.
+ */
+QVector<PictureId> DownloadedWidget::selectedIds() const {
+    QVector<PictureId> ids;
+    const QModelIndexList selected = ui->DownloadedPictureList->selectionModel()->selectedIndexes();
+    ids.reserve(selected.size());
+    for (const QModelIndex &idx : selected)
+        ids << PictureId(m_downloadedProxy->mapToSource(idx).data(ItemIdRole).toUInt());
+    return ids;
+}
+
+/**
+ * @brief Favoritos cambiados (uno o un lote): actualiza solo esas filas.
+ *
+ * Con el filtro de favoritos activo la lista cambia de composición y se reconstruye
+ * una vez para todo el lote.
+ *
+ * @param ids Imágenes cuyo favorito ha cambiado.
+ */
+void DownloadedWidget::onFavoritesChanged(const QVector<PictureId> &ids) {
+    if (!m_pictureManager) return;
+    if (ui->btnFilterFavorites->isChecked()) {
+        refreshList();
+        return;
+    }
+
+    const std::shared_ptr<const PictureStore> store = m_pictureManager->snapshot();
+    for (PictureId id : ids) {
+        QStandardItem* item = m_itemsById.value(id);
+        const int row = store->rowOf(id);
+        if (item && row >= 0)
+            item->setData(store->test(PictureStore::Favorite, row), ImageCardDelegate::FavoriteRole);
+    }
+}
+
+/**
+ * @brief Borrado masivo terminado: una sola reconstrucción y una sola notificación.
+ * @param ids Imágenes que han dejado de estar descargadas.
+ */
+void DownloadedWidget::onDownloadsRemoved(const QVector<PictureId> &ids) {
+    Q_UNUSED(ids);
+    refreshList();
+    emit pictureDeleted();
 }
 
 /**
@@ -265,8 +417,10 @@ void DownloadedWidget::refreshList() {
 void DownloadedWidget::updateCompleterList() {
     if (!m_pictureManager) return;
 
+    const PictureView downloaded = m_pictureManager->downloaded();
     QStringList names;
-    for (const auto &pic : m_pictureManager->downloaded())
+    names.reserve(downloaded.size());
+    for (const PictureRef pic : downloaded)
         names << pic.nombre();
 
     names.removeDuplicates();
@@ -284,6 +438,20 @@ void DownloadedWidget::setPictureManager(PictureManager *manager) {
     if (m_pictureManager) {
         disconnect(m_pictureManager, &PictureManager::downloadProgress,
                    this, &DownloadedWidget::onDownloadProgress);
+        disconnect(m_pictureManager, &PictureManager::picturesLoaded,
+                   this, &DownloadedWidget::onPicturesLoaded);
+        disconnect(m_pictureManager, &PictureManager::loadFinished,
+                   this, &DownloadedWidget::updateCompleterList);
+        disconnect(m_pictureManager, &PictureManager::picturesChanged,
+                   this, &DownloadedWidget::onPicturesChanged);
+        disconnect(m_pictureManager, &PictureManager::picturesRemoved,
+                   this, &DownloadedWidget::onPicturesRemoved);
+        disconnect(m_pictureManager, &PictureManager::picturesExpired,
+                   this, &DownloadedWidget::onPicturesExpired);
+        disconnect(m_pictureManager, &PictureManager::favoritesChanged,
+                   this, &DownloadedWidget::onFavoritesChanged);
+        disconnect(m_pictureManager, &PictureManager::downloadsRemoved,
+                   this, &DownloadedWidget::onDownloadsRemoved);
     }
 
     m_pictureManager = manager;
@@ -292,6 +460,21 @@ void DownloadedWidget::setPictureManager(PictureManager *manager) {
     if (m_pictureManager) {
         connect(m_pictureManager, &PictureManager::downloadProgress,
                 this, &DownloadedWidget::onDownloadProgress);
+        connect(m_pictureManager, &PictureManager::picturesLoaded,
+                this, &DownloadedWidget::onPicturesLoaded);
+        connect(m_pictureManager, &PictureManager::loadFinished,
+                this, &DownloadedWidget::updateCompleterList);
+        // Las imágenes añadidas por una recarga nunca están descargadas: no afectan a esta lista
+        connect(m_pictureManager, &PictureManager::picturesChanged,
+                this, &DownloadedWidget::onPicturesChanged);
+        connect(m_pictureManager, &PictureManager::picturesRemoved,
+                this, &DownloadedWidget::onPicturesRemoved);
+        connect(m_pictureManager, &PictureManager::picturesExpired,
+                this, &DownloadedWidget::onPicturesExpired);
+        connect(m_pictureManager, &PictureManager::favoritesChanged,
+                this, &DownloadedWidget::onFavoritesChanged);
+        connect(m_pictureManager, &PictureManager::downloadsRemoved,
+                this, &DownloadedWidget::onDownloadsRemoved);
     }
 
     refreshList();
@@ -317,13 +500,13 @@ void DownloadedWidget::disableDragDrop(QAbstractItemView* view) {
  *
  * - Si progress == -1 => significa "operación finalizada", refresca la lista tras un pequeño delay
  *   y emite pictureDeleted.
- * - En otro caso, busca el item cuyo texto contiene pictureName y actualiza su ProgressRole,
- *   forzando un repaint del viewport.
+ * - En otro caso, actualiza el ProgressRole del item de la imagen (búsqueda O(1) en
+ *   m_itemsById).
  *
  * @param progress Valor de progreso (0-100, o -1 para finalizado).
- * @param pictureName Nombre (o fragmento) de la imagen asociada al progreso.
+ * @param id Imagen asociada al progreso.
  */
-void DownloadedWidget::onDownloadProgress(int progress, const QString& pictureName) {
+void DownloadedWidget::onDownloadProgress(int progress, PictureId id) {
     if (progress == -1) {
         QTimer::singleShot(150, this, [this]() {
             refreshList();
@@ -332,16 +515,8 @@ void DownloadedWidget::onDownloadProgress(int progress, const QString& pictureNa
         return;
     }
 
-    for (int i = 0; i < m_downloadedModel->rowCount(); ++i) {
-        QStandardItem* item = m_downloadedModel->item(i);
-        if (!item) continue;
-        QString pureName = item->data(ItemNameRole).toString();
-        if (pureName == pictureName) {
-            item->setData(progress, ImageCardDelegate::ProgressRole);
-            ui->DownloadedPictureList->viewport()->update();
-            break;
-        }
-    }
+    if (QStandardItem* item = m_itemsById.value(id))
+        item->setData(progress, ImageCardDelegate::ProgressRole);
 }
 /**
  * @brief Destructor.
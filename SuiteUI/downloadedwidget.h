@@ -12,9 +12,8 @@
 class QCompleter;
 class QStringListModel;
 
-// Roles internos para identificar de forma única el Picture guardado en cada item
-static const int ItemUrlRole = Qt::UserRole + 100;   // guarda picture.url()
-static const int ItemNameRole = Qt::UserRole + 101;  // guarda picture.nombre() sin sufijos
+// Rol interno para identificar de forma única el Picture guardado en cada item
+static const int ItemIdRole = Qt::UserRole + 100;    // guarda picture.id()
 
 namespace Ui {
 class DownloadedWidget;
@@ -53,7 +52,17 @@ private:
     void updateCompleterList();
     void setupConnections();
     void updateViews();
-    void onDownloadProgress(int progress, const QString& pictureName);
+    void onDownloadProgress(int progress, PictureId id);
+    void onPicturesLoaded(const QList<Picture>& batch);
+    void onPicturesChanged(const QVector<PictureId>& ids);
+    void onPicturesRemoved(const QVector<PictureId>& ids);
+    void onPicturesExpired(const QVector<PictureId>& ids);
+    void onFavoritesChanged(const QVector<PictureId>& ids);
+    void onDownloadsRemoved(const QVector<PictureId>& ids);
+    QVector<PictureId> selectedIds() const;
+    QStandardItem* createItem(const Picture& pic, bool expired);
+    void markExpired(QStandardItem* item);
+    void removeItem(PictureId id);
     bool m_massDownloadInProgress = false;
 
 
@@ -65,6 +74,7 @@ private:
     QStandardItemModel* m_toDownloadModel;
     QSortFilterProxyModel* m_downloadedProxy;
     QSortFilterProxyModel* m_toDownloadProxy;
+    QHash<PictureId, QStandardItem*> m_itemsById; // id -> item de m_downloadedModel
 
     ImageCardDelegate* m_delegate;
 
@@ -6,6 +6,8 @@
  * - una QListView con delegado personalizado (ImageCardDelegate) que muestra las imágenes
  *   que aún no están descargadas,
  * - botones para iniciar descarga individual (doble clic) y descarga masiva ("Download All"),
+ * - selección múltiple: el menú contextual descarga los elementos seleccionados con
+ *   PictureManager::downloadMany() (una operación y una señal para todos),
  * - sincronización con PictureManager para recibir progreso y completado de descargas.
  *
  * Comentarios en estilo Doxygen en español para facilitar la lectura y generar documentación.
@@ -18,10 +20,9 @@
 #include <QMetaObject>
 #include <QStandardItemModel>
 #include <QListView>
+#include <QMenu>
 #include <QPushButton>
 #include <QDebug>
-#include <QRandomGenerator>
-#include <QtConcurrent>
 
 /**
  * @brief Constructor.
@@ -50,6 +51,42 @@ DownloadWidget::DownloadWidget(QWidget *parent)
     // Evitar drag & drop para que los usuarios no reordenen la vista manualmente
     DownloadedWidget::disableDragDrop(ui->DownloadPictureList);
 
+    // Selección múltiple (Ctrl/Shift) y menú contextual para actuar sobre ella
+    ui->DownloadPictureList->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    ui->DownloadPictureList->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(ui->DownloadPictureList, &QWidget::customContextMenuRequested, this, [this](const QPoint &pos) {
+        const QVector<PictureId> ids = selectedIds();
+        const QVector<PictureId> all = selectedIds(true);
+        if (!m_pictureManager) return;
+
+        QMenu menu(this);
+        if (!ids.isEmpty()) {
+            menu.addAction(tr("Download selected (%1)").arg(ids.size()), this, [this, ids]() {
+                m_pictureManager->downloadMany(ids);
+            });
+        }
+        if (!all.isEmpty()) {
+            menu.addAction(tr("Pause selected"), this, [this, all]() {
+                for (PictureId id : all) m_pictureManager->pauseDownload(id);
+            });
+            menu.addAction(tr("Resume selected"), this, [this, all]() {
+                for (PictureId id : all) m_pictureManager->resumeDownload(id);
+            });
+            menu.addAction(tr("Cancel selected"), this, [this, all]() {
+                for (PictureId id : all) m_pictureManager->cancelDownload(id);
+            });
+        }
+
+        // Cola completa
+        menu.addSeparator();
+        if (m_pictureManager->isDownloadQueuePaused())
+            menu.addAction(tr("Resume all downloads"), m_pictureManager, &PictureManager::resumeAllDownloads);
+        else
+            menu.addAction(tr("Pause all downloads"), m_pictureManager, &PictureManager::pauseAllDownloads);
+        menu.addAction(tr("Cancel all downloads"), m_pictureManager, &PictureManager::cancelAllDownloads);
+        menu.exec(ui->DownloadPictureList->viewport()->mapToGlobal(pos));
+    });
+
 
 
 
@@ -59,24 +96,34 @@ DownloadWidget::DownloadWidget(QWidget *parent)
     // Doble clic sobre un item: inicia la descarga de ese item si no estamos en descarga masiva
     connect(m_delegate, &ImageCardDelegate::doubleClicked, this, [this](const QModelIndex &idx){
     if (m_pictureManager) {
-        QString name = idx.data(Qt::DisplayRole).toString();
         int progress = idx.data(ImageCardDelegate::ProgressRole).toInt();
+        const PictureId id = PictureId(idx.data(ItemIdRole).toUInt());
 
+        // Doble clic sobre una descarga en pausa: se reanuda
+        if (idx.data(ImageCardDelegate::PausedRole).toBool()) {
+            m_pictureManager->resumeDownload(id);
+            return;
+        }
         if (progress >= 0) return;
 
-        int randomSeconds = QRandomGenerator::global()->bounded(10, 61);
-        QtConcurrent::run([this, idx, randomSeconds]() {
-            m_pictureManager->downloadPicture(idx.row(), randomSeconds);
-        });
+        // Sobre un elemento de una selección múltiple se descarga toda la selección.
+        // Ninguna de las dos llamadas bloquea: DownloadEngine transfiere en segundo plano.
+        // Una sola imagen va por el carril interactivo: adelanta a la descarga masiva
+        // (también si ya esperaba en su cola).
+        const QVector<PictureId> ids = selectedIds();
+        if (ids.size() > 1 && ui->DownloadPictureList->selectionModel()->isSelected(idx))
+            m_pictureManager->downloadMany(ids);
+        else
+            m_pictureManager->downloadPicture(id);
     }
 });
 
     // Info: mostrar URL en un mensaje informativo
     connect(m_delegate, &ImageCardDelegate::infoRequested, this, [this](const QModelIndex &idx){
         if (!m_pictureManager) return;
-        auto list = m_pictureManager->toDownload();
-        if (idx.row() >= 0 && idx.row() < list.size()) {
-            QMessageBox::information(this, tr("Info"), tr("URL: %1").arg(list.at(idx.row()).url()));
+        const Picture pic = m_pictureManager->picture(PictureId(idx.data(ItemIdRole).toUInt()));
+        if (!pic.url().isEmpty()) {
+            QMessageBox::information(this, tr("Info"), tr("URL: %1").arg(pic.url()));
         }
     });
 }
@@ -117,90 +164,220 @@ void DownloadWidget::applyExternalFilter(const QString &text) {
 void DownloadWidget::refreshList()
 {
     m_model->clear();
+    m_itemsById.clear();
     if (!m_pictureManager) return;
 
-    for (const auto &pic : m_pictureManager->toDownload()) {
-
-        QStandardItem *item = new QStandardItem(pic.nombre());
-        item->setData(QIcon(pic.url()), Qt::DecorationRole);
-        item->setData(false, ImageCardDelegate::DownloadedRole);
+    const PictureView pending = m_pictureManager->toDownload();
+    QList<QStandardItem*> items;
+    items.reserve(pending.size());
+    for (const PictureRef pic : pending) {
+        items.append(createItem(pic.toPicture()));
+    }
+    if (!items.isEmpty()) m_model->invisibleRootItem()->appendRows(items);
+}
 
-        //  restaurar progreso si existe
-        int progress = m_progressCache.value(pic.nombre(), -1);
-        item->setData(progress, ImageCardDelegate::ProgressRole);
+/**
+ * @brief Crea el item visual de una imagen y lo registra en m_itemsById.
+ *
+ * @param pic Imagen pendiente de descargar.
+ * @return Item listo para añadir al modelo.
+ */
+QStandardItem* DownloadWidget::createItem(const Picture &pic)
+{
+    QStandardItem *item = new QStandardItem(pic.nombre());
+    item->setData(QIcon(pic.url()), Qt::DecorationRole);
+    item->setData(pic.id(), ItemIdRole);
+    item->setData(false, ImageCardDelegate::DownloadedRole);
+
+    //  restaurar progreso si existe
+    int progress = m_progressCache.value(pic.id(), -1);
+    item->setData(progress, ImageCardDelegate::ProgressRole);
+    item->setData(m_paused.contains(pic.id()), ImageCardDelegate::PausedRole);
+
+    m_itemsById.insert(pic.id(), item);
+    return item;
+}
 
-        m_model->appendRow(item);
+/**
+ * @brief Ids de los elementos seleccionados.
+ * @param includeActive Si es false se omiten los que ya tienen una descarga en curso.
+ */
+QVector<PictureId> DownloadWidget::selectedIds(bool includeActive) const
+{
+    QVector<PictureId> ids;
+    const QModelIndexList selected = ui->DownloadPictureList->selectionModel()->selectedIndexes();
+    ids.reserve(selected.size());
+    for (const QModelIndex &idx : selected) {
+        if (!includeActive && idx.data(ImageCardDelegate::ProgressRole).toInt() >= 0) continue;
+        ids << PictureId(idx.data(ItemIdRole).toUInt());
     }
+    return ids;
 }
 
 /**
- * @brief Slot invocado al pulsar "Download All".
+ * @brief Carga asíncrona: añade al final las imágenes pendientes de un lote.
  *
- * Inicia una descarga en cadena sobre el primer elemento disponible. La lógica
- * encadena llamadas a downloadPicture(0) cada vez que llega la señal pictureDownloaded.
+ * Las filas del lote se insertan de una vez (una sola notificación rowsInserted).
  *
- * Nota: se usa invokeMethod en la cola de eventos para proteger la llamada y evitar
- * problemas si se invoca desde contextos distintos.
+ * @param batch Lote entregado por PictureManager::picturesLoaded().
  */
-void DownloadWidget::onDownloadAllClicked() {
-    if (!m_pictureManager || m_pictureManager->toDownload().isEmpty() || m_isDownloadingAll)
-        return;
+void DownloadWidget::onPicturesLoaded(const QList<Picture> &batch)
+{
+    QList<QStandardItem*> items;
+    items.reserve(batch.size());
+    for (const Picture &pic : batch) {
+        if (!pic.descargada()) items.append(createItem(pic));
+    }
+    if (!items.isEmpty()) m_model->invisibleRootItem()->appendRows(items);
+}
 
-    m_isDownloadingAll = true;
-    ui->DownloadAllButton->setEnabled(false);
+/**
+ * @brief Recarga en caliente: añade al final las imágenes nuevas del catálogo.
+ * @param ids Imágenes añadidas por PictureManager::reloadCatalog().
+ */
+void DownloadWidget::onPicturesAdded(const QVector<PictureId> &ids)
+{
+    if (!m_pictureManager) return;
 
-    emit massDownloadStarted();  // <--- Esto bloquea el botón de borrar
+    for (PictureId id : ids) {
+        const Picture pic = m_pictureManager->picture(id);
+        if (pic.url().isEmpty() || pic.descargada() || m_itemsById.contains(id)) continue;
+        m_model->appendRow(createItem(pic));
+    }
+}
 
-    auto listToDownload = m_pictureManager->toDownload();
+/**
+ * @brief Recarga en caliente: actualiza el texto de las imágenes modificadas.
+ * @param ids Imágenes cuyo nombre o descripción ha cambiado.
+ */
+void DownloadWidget::onPicturesChanged(const QVector<PictureId> &ids)
+{
+    if (!m_pictureManager) return;
 
-    for (const Picture &p : listToDownload) {
-        m_pictureManager->downloadPicture(p, QRandomGenerator::global()->bounded(10, 61));
+    for (PictureId id : ids) {
+        QStandardItem *item = m_itemsById.value(id);
+        if (!item) continue;
+        item->setText(m_pictureManager->picture(id).nombre());
     }
 }
 
+/**
+ * @brief Recarga en caliente: quita las filas de las imágenes eliminadas del catálogo.
+ * @param ids Imágenes eliminadas.
+ */
+void DownloadWidget::onPicturesRemoved(const QVector<PictureId> &ids)
+{
+    for (PictureId id : ids) {
+        QStandardItem *item = m_itemsById.take(id);
+        if (item) m_model->removeRow(item->row());
+        finishMassDownload(id, true); // ya no hay nada que esperar de ella
+    }
+}
 
-void DownloadWidget::downloadNextInMass() {
+/**
+ * @brief Slot invocado al pulsar "Download All".
+ *
+ * Pide todas las imágenes pendientes con una sola llamada a downloadMany(). Entran
+ * por orden en la cola masiva del planificador, con un límite de transferencias
+ * simultáneas; la operación termina (finishMassDownload()) cuando cada imagen se ha
+ * descargado, ha fallado o se ha cancelado. Mientras dura, el botón la cancela.
+ */
+void DownloadWidget::onDownloadAllClicked() {
     if (!m_pictureManager) return;
 
-    auto list = m_pictureManager->toDownload();
-    if (list.isEmpty()) {
-        m_isDownloadingAll = false;
-        ui->DownloadAllButton->setEnabled(true);
-        QMessageBox::information(this, tr("Completado"), tr("Todas las imágenes se han descargado."));
+    // Durante la descarga masiva el mismo botón la cancela (solo lo que ella pidió)
+    if (m_isDownloadingAll) {
+        m_massCancelled = true;
+        m_pictureManager->cancelBulkDownloads(m_massPending.values().toVector());
         return;
     }
+    if (m_pictureManager->toDownload().isEmpty()) return;
 
-    // Tomamos la primera imagen directamente
-    Picture pic = list.first();
+    m_isDownloadingAll = true;
+    m_massCancelled = false;
+    m_pictureManager->resetDownloadStats();
+    ui->DownloadAllButton->setText(tr("Cancel All"));
 
-    int randomSeconds = QRandomGenerator::global()->bounded(10, 61);
+    emit massDownloadStarted();  // <--- Esto bloquea el botón de borrar
+
+    const PictureView pending = m_pictureManager->toDownload();
+    QVector<PictureId> ids;
+    ids.reserve(pending.size());
+    m_massPending.clear();
+    m_massFailed = 0;
+    for (const PictureRef p : pending) {
+        ids << p.id();
+        m_massPending.insert(p.id());
+    }
+    m_pictureManager->downloadMany(ids);
+}
+
+/**
+ * @brief Descuenta una imagen de "Download All"; al quedar ninguna, termina y avisa.
+ *
+ * Las descargas fallidas también cuentan: la operación masiva termina aunque alguna
+ * transferencia no haya ido bien.
+ */
+void DownloadWidget::finishMassDownload(PictureId id, bool ok) {
+    if (!m_isDownloadingAll || !m_massPending.remove(id)) return;
+    if (!ok) ++m_massFailed;
+    if (!m_massPending.isEmpty()) return;
+
+    m_isDownloadingAll = false;
+    ui->DownloadAllButton->setText(QString()); // vuelve a ser solo el icono
+    emit massDownloadFinished();  // <--- Esto desbloquea el botón de borrar
+    if (m_massCancelled || !m_pictureManager)
+        return;
 
-    // Descargamos usando el objeto completo, no índice
-    m_pictureManager->downloadPicture(pic, randomSeconds);
+    // Rendimiento medido por el motor durante esta descarga masiva
+    const DownloadStats::Summary stats = m_pictureManager->downloadStats();
+    const QString measured = tr("%1 imágenes en %2 s: %3 img/s, %4 MB/s (p50 %5 ms, p99 %6 ms)")
+                                 .arg(stats.completed)
+                                 .arg(stats.elapsedMs / 1000.0, 0, 'f', 1)
+                                 .arg(stats.itemsPerSecond, 0, 'f', 1)
+                                 .arg(stats.megabytesPerSecond, 0, 'f', 2)
+                                 .arg(stats.p50Ms)
+                                 .arg(stats.p99Ms);
+    qInfo() << "Descarga masiva:" << measured;
+
+    if (m_massFailed == 0)
+        QMessageBox::information(this, tr("Completado"),
+                                 tr("Todas las imágenes se han descargado.") + "\n" + measured);
+    else
+        QMessageBox::warning(this, tr("Completado"),
+                             tr("%n imagen(es) no se pudieron descargar.", "", m_massFailed) + "\n" + measured);
 }
 
 
 
 /**
  * @brief Slot que se llama cuando PictureManager emite pictureDownloaded.
+ * @param id Imagen descargada.
+ */
+void DownloadWidget::onPictureDownloaded(PictureId id) {
+    onPicturesDownloaded(QVector<PictureId>{id});
+}
+
+/**
+ * @brief Descargas terminadas (una o un lote de downloadMany()).
  *
- * - Refresca la lista,
- * - Si estamos descargando masivamente, lanza la siguiente descarga o finaliza y notifica al usuario.
+ * - Quita de la lista las filas de las imágenes descargadas,
+ * - Reenvía una sola señal picturesDownloaded para todo el lote,
+ * - Si estamos descargando masivamente y ya no queda nada, finaliza y notifica al usuario.
  *
- * @param picture Picture descargada (no utilizada directamente aquí).
+ * @param ids Imágenes descargadas.
  */
-void DownloadWidget::onPictureDownloaded(const Picture &picture) {
-    Q_UNUSED(picture);
-    refreshList();
-
-    if (m_isDownloadingAll && m_pictureManager && m_pictureManager->toDownload().isEmpty()) {
-        m_isDownloadingAll = false;
-        ui->DownloadAllButton->setEnabled(true);
-        emit massDownloadFinished();  // <--- Esto desbloquea el botón de borrar
-        QMessageBox::information(this, tr("Completado"), tr("Todas las imágenes se han descargado."));
+void DownloadWidget::onPicturesDownloaded(const QVector<PictureId> &ids) {
+    for (PictureId id : ids) {
+        m_progressCache.remove(id);
+        if (QStandardItem *item = m_itemsById.take(id))
+            m_model->removeRow(item->row());
     }
 
-    emit pictureDownloaded(picture);
+    emit picturesDownloaded(ids);
+
+    for (PictureId id : ids)
+        finishMassDownload(id, true);
 }
 
 
@@ -209,30 +386,74 @@ void DownloadWidget::onPictureDownloaded(const Picture &picture) {
 /**
  * @brief Slot para recibir progreso de descarga de PictureManager.
  *
- * Actualiza el rol ProgressRole del item cuyo texto coincide con el nombre recibido.
+ * Actualiza el rol ProgressRole del item de la imagen (búsqueda O(1) en m_itemsById).
  *
  * @param progress Valor de progreso (0-100).
- * @param name Nombre de la imagen asociada al progreso.
+ * @param id Imagen asociada al progreso.
  */
-void DownloadWidget::onDownloadProgress(int progress, const QString &name)
+void DownloadWidget::onDownloadProgress(int progress, PictureId id)
 {
-    m_progressCache[name] = progress;
+    m_progressCache[id] = progress;
 
-    for (int i = 0; i < m_model->rowCount(); ++i) {
-        QStandardItem *it = m_model->item(i);
-        if (it && it->text() == name) {
-            it->setData(progress, ImageCardDelegate::ProgressRole);
-            break;
-        }
+    if (QStandardItem *it = m_itemsById.value(id))
+        it->setData(progress, ImageCardDelegate::ProgressRole);
+}
+
+/**
+ * @brief Descarga fallida o cancelada: la imagen vuelve a su estado sin progreso.
+ *
+ * @param id Imagen afectada.
+ * @param error Descripción del error (ya registrada por el motor).
+ */
+void DownloadWidget::onDownloadFailed(PictureId id, const QString &error)
+{
+    Q_UNUSED(error);
+    m_progressCache.remove(id);
+    m_paused.remove(id);
+    if (QStandardItem *it = m_itemsById.value(id)) {
+        it->setData(-1, ImageCardDelegate::ProgressRole);
+        it->setData(false, ImageCardDelegate::PausedRole);
     }
 
-    ui->DownloadPictureList->viewport()->update();
+    finishMassDownload(id, false);
+}
+
+/**
+ * @brief Descarga retenida o reanudada (pausa individual).
+ *
+ * Una retenida muestra la barra en gris; si aún no había empezado se le da progreso 0
+ * para que se vea la barra.
+ */
+void DownloadWidget::onDownloadPaused(PictureId id, bool paused)
+{
+    if (paused) {
+        m_paused.insert(id);
+        if (!m_progressCache.contains(id)) m_progressCache.insert(id, 0);
+    } else {
+        m_paused.remove(id);
+    }
+
+    if (QStandardItem *it = m_itemsById.value(id)) {
+        it->setData(paused, ImageCardDelegate::PausedRole);
+        it->setData(m_progressCache.value(id, -1), ImageCardDelegate::ProgressRole);
+    }
+}
+
+/**
+ * @brief Muestra en el botón de descarga masiva el estado de la cola.
+ */
+void DownloadWidget::onDownloadQueueChanged(int queued, int inFlight)
+{
+    ui->DownloadAllButton->setToolTip(tr("%1 queued, %2 downloading").arg(queued).arg(inFlight));
 }
 
 /**
  * @brief Asocia un PictureManager al widget y conecta sus señales.
  *
- * - Conecta pictureDownloaded y downloadProgress a los slots locales.
+ * - Conecta pictureDownloaded, picturesDownloaded, downloadProgress, downloadFailed y
+ *   las señales de la cola (downloadPaused, downloadQueueChanged) a los slots locales.
+ * - Conecta las señales de carga asíncrona (picturesLoaded) y de recarga en caliente
+ *   (picturesAdded/Changed/Removed).
  * - Llama a refreshList() para poblar la vista.
  *
  * @param manager Puntero al PictureManager; puede ser nullptr para desconectar.
@@ -241,14 +462,30 @@ void DownloadWidget::setPictureManager(PictureManager *manager) {
     if (m_pictureManager) {
         // Desconectar del anterior para evitar conexiones duplicadas
         disconnect(m_pictureManager, &PictureManager::pictureDownloaded, this, &DownloadWidget::onPictureDownloaded);
+        disconnect(m_pictureManager, &PictureManager::picturesDownloaded, this, &DownloadWidget::onPicturesDownloaded);
         disconnect(m_pictureManager, &PictureManager::downloadProgress, this, &DownloadWidget::onDownloadProgress);
+        disconnect(m_pictureManager, &PictureManager::downloadFailed, this, &DownloadWidget::onDownloadFailed);
+        disconnect(m_pictureManager, &PictureManager::downloadPaused, this, &DownloadWidget::onDownloadPaused);
+        disconnect(m_pictureManager, &PictureManager::downloadQueueChanged, this, &DownloadWidget::onDownloadQueueChanged);
+        disconnect(m_pictureManager, &PictureManager::picturesLoaded, this, &DownloadWidget::onPicturesLoaded);
+        disconnect(m_pictureManager, &PictureManager::picturesAdded, this, &DownloadWidget::onPicturesAdded);
+        disconnect(m_pictureManager, &PictureManager::picturesChanged, this, &DownloadWidget::onPicturesChanged);
+        disconnect(m_pictureManager, &PictureManager::picturesRemoved, this, &DownloadWidget::onPicturesRemoved);
     }
 
     m_pictureManager = manager;
 
     if (m_pictureManager) {
         connect(m_pictureManager, &PictureManager::pictureDownloaded, this, &DownloadWidget::onPictureDownloaded);
+        connect(m_pictureManager, &PictureManager::picturesDownloaded, this, &DownloadWidget::onPicturesDownloaded);
         connect(m_pictureManager, &PictureManager::downloadProgress, this, &DownloadWidget::onDownloadProgress);
+        connect(m_pictureManager, &PictureManager::downloadFailed, this, &DownloadWidget::onDownloadFailed);
+        connect(m_pictureManager, &PictureManager::downloadPaused, this, &DownloadWidget::onDownloadPaused);
+        connect(m_pictureManager, &PictureManager::downloadQueueChanged, this, &DownloadWidget::onDownloadQueueChanged);
+        connect(m_pictureManager, &PictureManager::picturesLoaded, this, &DownloadWidget::onPicturesLoaded);
+        connect(m_pictureManager, &PictureManager::picturesAdded, this, &DownloadWidget::onPicturesAdded);
+        connect(m_pictureManager, &PictureManager::picturesChanged, this, &DownloadWidget::onPicturesChanged);
+        connect(m_pictureManager, &PictureManager::picturesRemoved, this, &DownloadWidget::onPicturesRemoved);
     }
 
     refreshList();
@@ -2,6 +2,7 @@
 #define DOWNLOADWIDGET_H
 
 #include <QWidget>
+#include <QSet>
 #include <QStandardItemModel>
 #include "PictureManager.h"
 #include "ImageCardDelegate.h"
@@ -24,15 +25,22 @@ public:
 
 signals:
 
-    void pictureDownloaded(const Picture &picture);
+    void picturesDownloaded(const QVector<PictureId>& ids);
     void massDownloadStarted();
     void massDownloadFinished();
 
 private slots:
     void onDownloadAllClicked();
-    void onPictureDownloaded(const Picture& picture);
-    void onDownloadProgress(int progress, const QString& pictureName);
-    void downloadNextInMass();
+    void onPictureDownloaded(PictureId id);
+    void onPicturesDownloaded(const QVector<PictureId>& ids);
+    void onDownloadProgress(int progress, PictureId id);
+    void onDownloadFailed(PictureId id, const QString& error);
+    void onDownloadPaused(PictureId id, bool paused);
+    void onDownloadQueueChanged(int queued, int inFlight);
+    void onPicturesLoaded(const QList<Picture>& batch);
+    void onPicturesAdded(const QVector<PictureId>& ids);
+    void onPicturesChanged(const QVector<PictureId>& ids);
+    void onPicturesRemoved(const QVector<PictureId>& ids);
     void setMassDownloadInProgress(bool inProgress) {
         if (m_deleteButton) {
             m_deleteButton->setEnabled(!inProgress);
@@ -41,14 +49,22 @@ private slots:
 
 
 private:
+    QStandardItem* createItem(const Picture& pic);
+    QVector<PictureId> selectedIds(bool includeActive = false) const;
+    void finishMassDownload(PictureId id, bool ok);
+
     Ui::DownloadWidget *ui;
     PictureManager* m_pictureManager = nullptr;
     QStandardItemModel* m_model;
     ImageCardDelegate* m_delegate;
     bool m_isDownloadingAll = false;
     QString m_externalFilter; // Guarda el filtro que viene de fuera
-    QHash<QString, int> m_progressCache;
-    int m_pendingDownloads = 0;
+    QHash<PictureId, int> m_progressCache;
+    QHash<PictureId, QStandardItem*> m_itemsById; // id -> item del modelo
+    QSet<PictureId> m_massPending; // descargas de "Download All" sin terminar
+    int m_massFailed = 0;
+    bool m_massCancelled = false;
+    QSet<PictureId> m_paused; // descargas retenidas (sobreviven a refreshList())
     QPushButton* m_deleteButton;
 
 };
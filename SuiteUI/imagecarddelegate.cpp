@@ -137,7 +137,9 @@ void ImageCardDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opt
         painter->setBrush(QColor(230, 230, 230));
         painter->drawRoundedRect(progressRect, 5, 5);
 
-        painter->setBrush(QColor(255, 165, 0));
+        // Descarga en pausa: barra gris y rótulo en lugar del porcentaje
+        const bool paused = index.data(PausedRole).toBool();
+        painter->setBrush(paused ? QColor(170, 170, 170) : QColor(255, 165, 0));
         painter->drawRoundedRect(progressRect.left(), progressRect.top(),
                                  (progressRect.width() * progress) / 100,
                                  progressRect.height(), 5, 5);
@@ -145,7 +147,8 @@ void ImageCardDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opt
         painter->setOpacity(1.0);
         painter->setPen(Qt::black);
         painter->setFont(QFont("Arial", 8, QFont::Bold));
-        painter->drawText(progressRect, Qt::AlignCenter, QString("%1%").arg(progress));
+        painter->drawText(progressRect, Qt::AlignCenter,
+                          paused ? tr("Paused") : QString("%1%").arg(progress));
     }
 
     // Lambda para dibujar botones
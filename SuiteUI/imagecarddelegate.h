@@ -11,7 +11,8 @@ public:
         FavoriteRole = Qt::UserRole + 1,
         DownloadedRole = Qt::UserRole + 2,
         ProgressRole = Qt::UserRole + 5,
-        ExpiredRole = Qt::UserRole + 6
+        ExpiredRole = Qt::UserRole + 6,
+        PausedRole = Qt::UserRole + 7
     };
 
     explicit ImageCardDelegate(QObject *parent = nullptr) : QStyledItemDelegate(parent), m_mode(Grid) {}
@@ -1,5 +1,6 @@
 #include "ImageViewer.h"
 #include "ui_ImageViewer.h"
+#include "imagestore.h"
 #include <QPixmap>
 #include <QDebug>
 
@@ -12,9 +13,10 @@
  * - etiquetas con nombre y descripción,
  * - un botón "back" que cierra el visor.
  *
- * Las imágenes se cargan desde una ruta/URL local usando QPixmap. Se guarda la
- * QPixmap cargada en m_currentPixmap para poder reescalarla en resizeEvent sin
- * volver a leer del disco.
+ * Los píxeles se piden al ImageStore de la ventana principal (caché por id, se reutiliza
+ * entre aperturas) y se convierten a QPixmap aquí, en el hilo de la interfaz. Se guarda
+ * la QPixmap en m_currentPixmap para poder reescalarla en resizeEvent sin volver a
+ * leer del disco.
  *
  * Nota: actualmente el escalado en el label usa Qt::IgnoreAspectRatio tal como
  * se hizo en la versión original. Si prefieres mantener la proporción de la
@@ -43,11 +45,20 @@ ImageViewer::ImageViewer(QWidget *parent) :
     connect(ui->backButton, &QPushButton::clicked, this, &ImageViewer::close);
 }
 
+/**
+ * @brief Caché de píxeles de la que se leen las imágenes (sin ella se lee del disco).
+ * @param images ImageStore de la ventana principal (módulo SuiteImage).
+ */
+void ImageViewer::setImageStore(ImageStore* images)
+{
+    m_images = images;
+}
+
 /**
  * @brief Muestra una Picture en el visor.
  *
  * - Actualiza las etiquetas de nombre y descripción.
- * - Intenta cargar la imagen desde picture.url() y, si tiene éxito, la guarda en
+ * - Pide la imagen de picture.url() al ImageStore y, si tiene éxito, la guarda en
  *   m_currentPixmap para futuros reescalados.
  * - Si no se puede cargar la imagen, muestra un mensaje de error en el label.
  * - Finalmente muestra la ventana y la trae al frente.
@@ -61,7 +72,8 @@ void ImageViewer::showPicture(const Picture &picture)
     ui->descriptionlabel->setText(picture.descripcion());
 
     // 2. Intentar cargar la imagen desde la URL/Ruta
-    QPixmap pixmap(picture.url());
+    const QPixmap pixmap = m_images ? m_images->pixmap(picture.id(), picture.url())
+                                    : QPixmap(picture.url());
 
     if (pixmap.isNull()) {
         qDebug() << "Error: No se pudo cargar la imagen en:" << picture.url();
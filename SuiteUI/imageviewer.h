@@ -4,6 +4,8 @@
 #include <QWidget>
 #include "Picture.h"
 
+class ImageStore;
+
 namespace Ui {
 class ImageViewer;
 }
@@ -16,12 +18,15 @@ public:
     explicit ImageViewer(QWidget *parent = nullptr);
     ~ImageViewer();
 
+    void setImageStore(ImageStore* images);
+
 public slots:
     void showPicture(const Picture& picture);
     void resizeEvent(QResizeEvent* event);
 
 private:
     Ui::ImageViewer *ui;
+     ImageStore* m_images = nullptr;
      QPixmap m_currentPixmap;
 };
 
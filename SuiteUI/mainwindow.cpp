@@ -23,9 +23,8 @@
  *
  * - Inicializa la UI,
  * - crea la carpeta "images" si no existe en la ruta del proyecto,
- * - carga los JSON (catalog y downloaded),
  * - asigna el PictureManager a los widgets correspondientes y conecta señales entre ellos,
- * - realiza un refresco inicial de las listas.
+ * - lanza la carga asíncrona del catálogo y del estado (las vistas se llenan por lotes).
  *
  * @param parent Widget padre (por defecto nullptr).
  */
@@ -53,18 +52,23 @@ MainWindow::MainWindow(QWidget *parent)
     QString catalogPath = QDir(projectPath).filePath("download.json");
     QString downloadedPath = QDir(projectPath).filePath("downloaded.json");
 
-    // Inicializar PictureManager con la ruta base y cargar datos
+    // Inicializar PictureManager con la ruta base
     m_pictureManager.setBasePath(projectPath);
-    m_pictureManager.loadCatalog(catalogPath);
-    m_pictureManager.loadDownloaded(downloadedPath);
 
     // Asignar el manager a los widgets de la UI
     ui->downloadWidget->setPictureManager(&m_pictureManager);
     ui->downloadedWidget->setPictureManager(&m_pictureManager);
+    imageViewer->setImageStore(&m_images);
+
+    // Los ids se conservan por URL: tras una recarga solo sobran los píxeles de las eliminadas
+    connect(&m_pictureManager, &PictureManager::picturesRemoved, this, [this](const QVector<PictureId>& ids) {
+        for (PictureId id : ids)
+            m_images.remove(id);
+    });
 
     // Conexiones entre widgets:
     // - Cuando se descarga una picture, refrescar la lista de descargadas.
-    connect(ui->downloadWidget, &DownloadWidget::pictureDownloaded, ui->downloadedWidget, &DownloadedWidget::refreshList);
+    connect(ui->downloadWidget, &DownloadWidget::picturesDownloaded, ui->downloadedWidget, &DownloadedWidget::refreshList);
 
     // - Cuando se borra una picture desde descargadas, refrescar la lista de disponibles.
     connect(ui->downloadedWidget, &DownloadedWidget::pictureDeleted, ui->downloadWidget, &DownloadWidget::refreshList);
@@ -79,9 +83,16 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->downloadedWidget, &DownloadedWidget::searchTextChanged, ui->downloadWidget, &DownloadWidget::applyExternalFilter);
     connect(ui->downloadedWidget, &DownloadedWidget::viewModeToggled, ui->downloadWidget, &DownloadWidget::applyExternalViewMode);
 
-    // Refrescos iniciales para poblar las vistas.
-    ui->downloadWidget->refreshList();
-    ui->downloadedWidget->refreshList();
+    // Vigilar el catálogo una vez cargado: los cambios en disco se aplican como un diff.
+    // Si la carga fue bien, se reanudan las descargas que quedaron pendientes al cerrar.
+    connect(&m_pictureManager, &PictureManager::loadFinished, this, [this, catalogPath](bool ok) {
+        m_pictureManager.watchCatalog(catalogPath);
+        if (ok) m_pictureManager.resumeDownloads();
+    });
+
+    // Carga en segundo plano (instantánea binaria o JSON en paralelo): la ventana se
+    // muestra vacía y las vistas se pueblan por lotes con PictureManager::picturesLoaded.
+    m_pictureManager.loadAsync(catalogPath, downloadedPath);
 }
 
 /**
@@ -122,15 +133,15 @@ QString MainWindow::getProjectPath()
 /**
  * @brief Maneja el evento de cierre de la ventana.
  *
- * Antes de cerrar persiste el estado actual de las imágenes descargadas llamando
- * a PictureManager::saveDownloaded(...).
+ * Antes de cerrar pide a PictureManager que confirme en disco los cambios
+ * pendientes (flush), esperando como máximo unos segundos.
  *
  * @param event Evento de cierre (permitir/ignorar según lógica).
  */
 void MainWindow::closeEvent(QCloseEvent *event) {
-    QString projectPath = getProjectPath();
-    QString downloadedPath = QDir(projectPath).filePath("downloaded.json");
-    m_pictureManager.saveDownloaded(downloadedPath);
+    if (!m_pictureManager.flush(QDeadlineTimer(3000))) {
+        qWarning() << "No se pudo confirmar el estado antes de cerrar";
+    }
     event->accept();
 }
 
@@ -3,6 +3,7 @@
 
 #include <QMainWindow>
 #include "PictureManager.h"
+#include "imagestore.h"
 #include "imageviewer.h"
 
 
@@ -25,6 +26,7 @@ protected:
 private:
     Ui::MainWindow *ui;
     PictureManager m_pictureManager;
+    ImageStore m_images; // módulo SuiteImage: píxeles por id, fuera de SuiteCore
     ImageViewer* imageViewer;
     QString getProjectPath();
 };
@@ -0,0 +1,12 @@
+# Benchmarks de SuiteCore. Cada subproyecto es un ejecutable de consola que imprime una
+# tabla por stdout; no forman parte de la aplicación ni se instalan.
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    catalog \
+    contention \
+    download \
+    startup \
+    startupgui \
+    storage \
+    store
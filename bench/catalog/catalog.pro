@@ -0,0 +1,7 @@
+# Carga de catálogos grandes: tiempo y memoria de cada forma de leer el JSON
+include(../common/common.pri)
+
+TARGET = benchcatalog
+
+SOURCES += \
+    main.cpp
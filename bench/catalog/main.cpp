@@ -0,0 +1,240 @@
+/**
+ * @file main.cpp
+ * @brief Benchmark de carga de catálogos: tiempo y pico de memoria de cada método.
+ *
+ * Para cada tamaño (por defecto 10 000, 1 000 000 y 5 000 000 imágenes) genera un
+ * catálogo sintético con el formato de download.json y lo carga con cada método:
+ * - dom: QFile::readAll() + QJsonDocument, la carga anterior a CatalogReader;
+ * - stream: CatalogReader, objeto a objeto, como PictureManager::loadCatalog();
+ * - parser: CatalogParser::parseFile(), índice estructural SIMD y conversión en
+ *   paralelo, como PictureDAO::loadCatalog();
+ * - scan: solo el índice estructural (CatalogParser::objectSpans()) sobre el fichero
+ *   ya leído, para comparar su velocidad con la del análisis completo.
+ *
+ * Cada carga se ejecuta en un proceso hijo (este mismo ejecutable con --child) para
+ * que el pico de memoria (VmHWM, solo Linux) sea el de ese método y no arrastre el de
+ * los anteriores. Un método que no puede con el catálogo aparece como "error".
+ *
+ * Uso: benchcatalog [--sizes 10000,1000000,5000000] [--methods dom,stream,parser,scan]
+ */
+
+#include "benchutil.h"
+#include "catalogparser.h"
+#include "catalogreader.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+
+namespace {
+
+/**
+ * @brief Carga con el documento completo en memoria (bytes del fichero + árbol JSON).
+ */
+int loadDom(const QString& path, QElapsedTimer*, bool* ok)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *ok = false;
+        return 0;
+    }
+
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    *ok = doc.isArray();
+    const QJsonArray array = doc.array();
+    QList<Picture> pictures;
+    pictures.reserve(array.size());
+    for (const QJsonValue& value : array) {
+        const QJsonObject obj = value.toObject();
+        pictures.append(Picture(obj["nombre"].toString(), obj["url"].toString(),
+                                obj["descripcion"].toString()));
+    }
+    return pictures.size();
+}
+
+/**
+ * @brief Carga incremental con CatalogReader: solo hay un objeto del JSON a la vez.
+ */
+int loadStream(const QString& path, QElapsedTimer*, bool* ok)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *ok = false;
+        return 0;
+    }
+
+    CatalogReader reader(&file);
+    QList<Picture> pictures;
+    Picture picture;
+    while (reader.readNext(picture))
+        pictures.append(picture);
+    *ok = !reader.hasError();
+    return pictures.size();
+}
+
+/**
+ * @brief Carga con CatalogParser (índice estructural + conversión en varios hilos).
+ */
+int loadParser(const QString& path, QElapsedTimer*, bool* ok)
+{
+    return CatalogParser::parseFile(path, CatalogParser::CatalogFields, ok).size();
+}
+
+/**
+ * @brief Solo el índice estructural; el tiempo empieza con el fichero ya en memoria.
+ * @return Número de objetos localizados.
+ */
+int scanSpans(const QString& path, QElapsedTimer* timer, bool* ok)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *ok = false;
+        return 0;
+    }
+    const QByteArray data = file.readAll();
+
+    timer->restart();
+    return CatalogParser::objectSpans(data.constData(), data.size(), ok).size();
+}
+
+// Devuelve las imágenes (u objetos) leídos; puede reiniciar timer tras prepararse
+using Loader = int (*)(const QString&, QElapsedTimer*, bool*);
+
+struct Method {
+    const char* name;
+    Loader load;
+};
+
+const Method Methods[] = {
+    {"dom", loadDom},
+    {"stream", loadStream},
+    {"parser", loadParser},
+    {"scan", scanSpans},
+};
+
+Loader loaderFor(const QString& name)
+{
+    for (const Method& method : Methods)
+        if (name == QLatin1String(method.name)) return method.load;
+    return nullptr;
+}
+
+/**
+ * @brief Proceso hijo: carga el catálogo y escribe "<ms> <pico KiB> <imágenes>".
+ */
+int runChild(const QString& method, const QString& path)
+{
+    const Loader load = loaderFor(method);
+    if (!load) {
+        qWarning() << "Metodo desconocido:" << method;
+        return 2;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = false;
+    const int count = load(path, &timer, &ok);
+    const qint64 elapsed = timer.elapsed();
+
+    Bench::out() << elapsed << ' ' << Bench::peakMemoryKb() << ' ' << count << '\n';
+    return ok ? 0 : 1;
+}
+
+struct Result {
+    bool ok = false;
+    qint64 ms = 0;
+    qint64 peakKb = -1;
+    int count = 0;
+};
+
+/**
+ * @brief Mide un método en un proceso hijo.
+ */
+Result measure(const QString& method, const QString& path)
+{
+    QProcess child;
+    child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    child.start(QCoreApplication::applicationFilePath(), {"--child", method, path});
+    Result result;
+    if (!child.waitForFinished(-1) || child.exitStatus() != QProcess::NormalExit
+        || child.exitCode() != 0)
+        return result;
+
+    const QList<QByteArray> fields = child.readAllStandardOutput().trimmed().split(' ');
+    result.ms = fields.value(0).toLongLong();
+    result.peakKb = fields.value(1).toLongLong();
+    result.count = fields.value(2).toInt();
+    result.ok = fields.size() == 3;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("benchcatalog");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Carga de catalogos grandes: tiempo y memoria");
+    parser.addHelpOption();
+    const QCommandLineOption sizesOption("sizes", "Imagenes de cada catalogo.", "N,N...",
+                                         "10000,1000000,5000000");
+    const QCommandLineOption methodsOption("methods", "Metodos a medir.", "m,m...",
+                                           "dom,stream,parser,scan");
+    const QCommandLineOption childOption("child", "Uso interno: mide un metodo (<metodo> <catalogo>).");
+    parser.addOptions({sizesOption, methodsOption, childOption});
+    parser.process(app);
+
+    if (parser.isSet(childOption))
+        return runChild(parser.positionalArguments().value(0), parser.positionalArguments().value(1));
+
+    const QStringList methods = parser.value(methodsOption).split(',');
+    for (const QString& method : methods) {
+        if (!loaderFor(method)) {
+            qWarning() << "Metodo desconocido:" << method;
+            return 2;
+        }
+    }
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) return 1;
+
+    QTextStream& out = Bench::out();
+    out << "Indice estructural de CatalogParser: " << CatalogParser::simdLevel() << "\n\n";
+    out.setFieldAlignment(QTextStream::AlignLeft);
+    out << "imagenes  MiB      metodo   ms        MiB/s     pico MiB\n";
+
+    for (const QString& size : parser.value(sizesOption).split(',')) {
+        const int count = size.toInt();
+        const QString path = dir.filePath(QString("catalog_%1.json").arg(count));
+        if (!Bench::writeCatalog(path, count, [](int i) { return "images/" + Bench::fileName(i); }))
+            return 1;
+        const double mib = QFileInfo(path).size() / (1024.0 * 1024.0);
+
+        for (const QString& method : methods) {
+            const Result result = measure(method, path);
+            out << qSetFieldWidth(10) << count
+                << qSetFieldWidth(9) << QString::number(mib, 'f', 1) << method;
+            if (!result.ok || result.count != count) {
+                out << qSetFieldWidth(0) << "error\n";
+            } else {
+                out << qSetFieldWidth(10) << result.ms
+                    << QString::number(mib * 1000.0 / qMax<qint64>(1, result.ms), 'f', 1)
+                    << qSetFieldWidth(0)
+                    << (result.peakKb < 0 ? QString("-") : QString::number(result.peakKb / 1024.0, 'f', 1))
+                    << "\n";
+            }
+            out.flush();
+        }
+        QFile::remove(path);
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+/**
+ * @file benchutil.cpp
+ * @brief Datos sintéticos y salida de resultados para los benchmarks.
+ *
+ * Los datos son deterministas (semilla fija) para que dos ejecuciones midan lo mismo.
+ */
+
+#include "benchutil.h"
+#include <QDate>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <QStringList>
+#include <QVector>
+
+namespace {
+
+QString pictureName(int i)
+{
+    return QString("img_%1").arg(i, 6, 10, QChar('0'));
+}
+
+// Pocas descripciones distintas, repetidas como en un catálogo real
+QString description(int i)
+{
+    static const QStringList descriptions = {
+        "Paisaje", "Retrato", "Arquitectura", "Naturaleza", "Ciudad de noche",
+        "Fotografía de archivo sin descripción detallada", "Tranvía", "Montaña"
+    };
+    return descriptions.at(i % descriptions.size());
+}
+
+} // namespace
+
+namespace Bench {
+
+QTextStream& out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+QString fileName(int i)
+{
+    return QString("img_%1.jpg").arg(i, 6, 10, QChar('0'));
+}
+
+/**
+ * @brief Genera un catálogo sintético de 'count' imágenes.
+ * @param url Función que devuelve la URL de la imagen i.
+ */
+QList<Picture> syntheticPictures(int count, const std::function<QString(int)>& url)
+{
+    const QDate today = QDate::currentDate();
+    QList<Picture> pictures;
+    pictures.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        Picture picture(pictureName(i), url(i), description(i));
+        if (i % 10 == 0) picture.setExpirationDate(today.addDays(1 + i % 365));
+        pictures.append(picture);
+    }
+    return pictures;
+}
+
+/**
+ * @brief Crea los ficheros que sirve HttpStandIn en los benchmarks de descarga.
+ *
+ * Todos comparten el mismo contenido aleatorio: lo que se mide es el transporte, no
+ * el disco, y así generar miles de ficheros no domina el tiempo de preparación.
+ */
+bool writeFiles(const QString& dir, int count, qint64 size)
+{
+    if (!QDir().mkpath(dir)) {
+        qWarning() << "No se pudo crear el directorio:" << dir;
+        return false;
+    }
+
+    QVector<quint32> words(int((size + 3) / 4));
+    QRandomGenerator(42).fillRange(words.data(), words.size());
+    const QByteArray content(reinterpret_cast<const char*>(words.constData()), int(size));
+
+    for (int i = 0; i < count; ++i) {
+        QFile file(QDir(dir).filePath(fileName(i)));
+        if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size()) {
+            qWarning() << "No se pudo escribir:" << file.fileName();
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Escribe un catálogo sintético con el mismo formato que download.json.
+ *
+ * Se escribe objeto a objeto: el generador no debe ser lo que limite el tamaño de los
+ * catálogos que se miden. Los datos sintéticos no contienen caracteres que haya que
+ * escapar en JSON.
+ */
+bool writeCatalog(const QString& path, int count, const std::function<QString(int)>& url)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "No se pudo crear el catalogo:" << path;
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << "[\n";
+    const QDate today = QDate::currentDate();
+    for (int i = 0; i < count; ++i) {
+        stream << "    {\n"
+               << "        \"nombre\": \"" << pictureName(i) << "\",\n"
+               << "        \"url\": \"" << url(i) << "\",\n"
+               << "        \"descripcion\": \"" << description(i) << "\",\n"
+               << "        \"favorito\": false,\n"
+               << "        \"descargada\": false,\n"
+               << "        \"expirationDate\": \"" << today.addDays(1 + i % 365).toString(Qt::ISODate)
+               << "\"\n    }" << (i + 1 < count ? ",\n" : "\n");
+    }
+    stream << "]\n";
+    stream.flush();
+    return stream.status() == QTextStream::Ok && file.commit();
+}
+
+/**
+ * @brief Pico de memoria residente del proceso, en KiB.
+ *
+ * Se lee VmHWM de /proc/self/status, así que solo está disponible en Linux. Para
+ * comparar métodos, cada uno debe medirse en su propio proceso.
+ */
+qint64 peakMemoryKb()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly | QIODevice::Text)) return -1;
+
+    while (!status.atEnd()) {
+        const QByteArray line = status.readLine();
+        if (line.startsWith("VmHWM:"))
+            return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+    }
+    return -1;
+}
+
+} // namespace Bench
@@ -0,0 +1,35 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include "Picture.h"
+#include <QList>
+#include <QString>
+#include <QTextStream>
+#include <functional>
+
+// Utilidades compartidas por los benchmarks: datos sintéticos y salida de resultados.
+namespace Bench {
+
+// stdout, para las tablas de resultados (los diagnósticos van por qWarning a stderr)
+QTextStream& out();
+
+// Nombre del fichero sintético i ("img_000042.jpg")
+QString fileName(int i);
+
+// Imágenes de catálogo "img_<i>" con la URL que devuelva url(i); las descripciones se
+// repiten como en un catálogo real y una de cada diez caduca en el próximo año
+QList<Picture> syntheticPictures(int count, const std::function<QString(int)>& url);
+
+// Escribe count ficheros fileName(i) de 'size' bytes pseudoaleatorios en dir
+bool writeFiles(const QString& dir, int count, qint64 size);
+
+// Escribe un catálogo JSON como download.json sin construir el documento en memoria,
+// para poder generar catálogos de millones de imágenes
+bool writeCatalog(const QString& path, int count, const std::function<QString(int)>& url);
+
+// Pico de memoria residente del proceso en KiB (VmHWM); -1 si no se puede saber
+qint64 peakMemoryKb();
+
+} // namespace Bench
+
+#endif // BENCHUTIL_H
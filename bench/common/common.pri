@@ -0,0 +1,21 @@
+# Configuración común de los benchmarks: consola, solo QtCore/QtNetwork y SuiteCore
+QT -= gui
+QT += concurrent network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD $$PWD/../../SuiteCore
+DEPENDPATH += $$PWD $$PWD/../../SuiteCore
+
+SOURCES += \
+    $$PWD/benchutil.cpp \
+    $$PWD/httpstandin.cpp
+
+HEADERS += \
+    $$PWD/benchutil.h \
+    $$PWD/httpstandin.h
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../../SuiteCore/release/ -lSuiteCore
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../../SuiteCore/debug/ -lSuiteCore
+else:unix: LIBS += -L$$OUT_PWD/../../SuiteCore/ -lSuiteCore
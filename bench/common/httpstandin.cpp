@@ -0,0 +1,324 @@
+/**
+ * @file httpstandin.cpp
+ * @brief Servidor HTTP local para los benchmarks de descarga.
+ *
+ * HttpStandIn hace de origen de las imágenes en los benchmarks: sirve los ficheros de
+ * un directorio por 127.0.0.1 con las condiciones de red que se le pidan, de modo que
+ * las mediciones de DownloadEngine sean reproducibles y no dependan de Internet.
+ *
+ * Notas:
+ * - El servidor y sus conexiones viven en un QThread propio: la interfaz pública se
+ *   puede usar desde el hilo principal mientras PictureManager descarga.
+ * - Cada conexión responde sus peticiones en orden (HTTP/1.1 sin pipelining real):
+ *   la siguiente no se analiza hasta terminar de escribir la anterior.
+ * - La latencia se aplica antes de cada respuesta, no por conexión.
+ * - El ancho de banda se limita por conexión escribiendo una cuota cada
+ *   PaceIntervalMs, así que varias conexiones suman más caudal.
+ * - Al alcanzar maxConnections se deja de aceptar (pauseAccepting()); el resto espera
+ *   en la cola del sistema, como en un servidor real con un límite de trabajadores.
+ */
+
+#include "httpstandin.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QMutexLocker>
+#include <QPair>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace {
+
+using Fields = QList<QPair<QByteArray, QByteArray>>;
+
+/**
+ * @brief Construye la línea de estado y las cabeceras de una respuesta.
+ */
+QByteArray header(int code, const QByteArray& reason, qint64 length, bool close,
+                  const Fields& fields = Fields())
+{
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(code) + ' ' + reason + "\r\n";
+    head += "Content-Length: " + QByteArray::number(length) + "\r\n";
+    for (const auto& field : fields)
+        head += field.first + ": " + field.second + "\r\n";
+    head += close ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n";
+    return head;
+}
+
+} // namespace
+
+/**
+ * @brief Prepara el servidor para servir 'root'; no escucha hasta listen().
+ */
+HttpStandIn::HttpStandIn(const QString& root, const Options& options)
+    : m_root(QDir(root).absolutePath())
+    , m_options(options)
+    , m_context(new QObject)
+    , m_random(options.seed)
+{
+    m_thread.setObjectName("HttpStandIn");
+    m_context->moveToThread(&m_thread);
+    m_thread.start();
+}
+
+/**
+ * @brief Detiene el hilo y cierra el servidor y todas sus conexiones.
+ *
+ * m_context (y con él el servidor y los sockets, que son sus hijos) pertenece al hilo
+ * del servidor, así que se destruye en él con deleteLater() al terminar el hilo.
+ */
+HttpStandIn::~HttpStandIn()
+{
+    QObject::connect(&m_thread, &QThread::finished, m_context, &QObject::deleteLater);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+/**
+ * @brief Empieza a escuchar en un puerto libre de 127.0.0.1.
+ * @return false si no se pudo abrir el puerto.
+ */
+bool HttpStandIn::listen()
+{
+    bool ok = false;
+    QMetaObject::invokeMethod(m_context, [this, &ok]() {
+        m_server = new QTcpServer(m_context);
+        QObject::connect(m_server, &QTcpServer::newConnection, m_context, [this]() { accept(); });
+        ok = m_server->listen(QHostAddress::LocalHost);
+        if (!ok) qWarning() << "HttpStandIn: no se pudo escuchar:" << m_server->errorString();
+        m_port = m_server->serverPort();
+    }, Qt::BlockingQueuedConnection);
+    return ok;
+}
+
+/**
+ * @brief URL http://127.0.0.1:<puerto>/<relativePath> de un fichero servido.
+ */
+QUrl HttpStandIn::url(const QString& relativePath) const
+{
+    QUrl url;
+    url.setScheme("http");
+    url.setHost("127.0.0.1");
+    url.setPort(m_port);
+    url.setPath('/' + relativePath);
+    return url;
+}
+
+HttpStandIn::Counters HttpStandIn::counters() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_counters;
+}
+
+void HttpStandIn::resetCounters()
+{
+    QMutexLocker locker(&m_mutex);
+    m_counters = Counters();
+}
+
+/**
+ * @brief Acepta las conexiones pendientes hasta el límite de conexiones simultáneas.
+ */
+void HttpStandIn::accept()
+{
+    while (m_server->hasPendingConnections()) {
+        QTcpSocket* socket = m_server->nextPendingConnection();
+        m_connections.insert(socket, Connection());
+        {
+            QMutexLocker locker(&m_mutex);
+            ++m_counters.connections;
+            m_counters.peakConnections = qMax(m_counters.peakConnections, m_connections.size());
+        }
+
+        QObject::connect(socket, &QTcpSocket::readyRead, m_context, [this, socket]() {
+            m_connections[socket].input += socket->readAll();
+            serveNext(socket);
+        });
+        QObject::connect(socket, &QTcpSocket::bytesWritten, m_context, [this, socket]() {
+            send(socket);
+        });
+        QObject::connect(socket, &QTcpSocket::disconnected, m_context, [this, socket]() {
+            m_connections.remove(socket);
+            socket->deleteLater();
+            if (m_options.maxConnections > 0 && m_connections.size() < m_options.maxConnections)
+                m_server->resumeAccepting();
+        });
+
+        if (m_options.maxConnections > 0 && m_connections.size() >= m_options.maxConnections) {
+            m_server->pauseAccepting();
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Si la conexión está libre y tiene una petición completa, prepara su respuesta.
+ *
+ * La respuesta se escribe tras la latencia configurada; mientras tanto la conexión
+ * no atiende más peticiones.
+ */
+void HttpStandIn::serveNext(QTcpSocket* socket)
+{
+    Connection& connection = m_connections[socket];
+    if (connection.phase != Idle) return;
+
+    const int end = connection.input.indexOf("\r\n\r\n");
+    if (end < 0) return;
+
+    // Solo GET y HEAD: las peticiones no llevan cuerpo
+    const QByteArray head = connection.input.left(end);
+    connection.input.remove(0, end + 4);
+    connection.output = respond(head, &connection.close);
+
+    if (m_options.latencyMs > 0) {
+        connection.phase = Waiting;
+        QTimer::singleShot(m_options.latencyMs, socket, [this, socket]() {
+            auto it = m_connections.find(socket);
+            if (it == m_connections.end()) return;
+            it->phase = Sending;
+            send(socket);
+        });
+    } else {
+        connection.phase = Sending;
+        send(socket);
+    }
+}
+
+/**
+ * @brief Escribe la respuesta en curso (toda o la cuota del ancho de banda) y, cuando
+ * el socket la ha vaciado, pasa a la siguiente petición o cierra la conexión.
+ */
+void HttpStandIn::send(QTcpSocket* socket)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end() || it->phase != Sending) return;
+    Connection& connection = *it;
+
+    const int remaining = connection.output.size() - connection.written;
+    if (remaining > 0) {
+        if (m_options.bytesPerSecond <= 0) {
+            socket->write(connection.output.constData() + connection.written, remaining);
+            connection.written += remaining;
+        } else if (!connection.pacing) {
+            const qint64 quota = qMax<qint64>(1, m_options.bytesPerSecond * PaceIntervalMs / 1000);
+            const int chunk = int(qMin<qint64>(quota, remaining));
+            socket->write(connection.output.constData() + connection.written, chunk);
+            connection.written += chunk;
+            connection.pacing = true;
+            QTimer::singleShot(PaceIntervalMs, socket, [this, socket]() {
+                auto it = m_connections.find(socket);
+                if (it == m_connections.end()) return;
+                it->pacing = false;
+                send(socket);
+            });
+        }
+        return; // bytesWritten() o el siguiente tick vuelven a llamar
+    }
+
+    if (socket->bytesToWrite() > 0) return;
+
+    connection.phase = Idle;
+    connection.output.clear();
+    connection.written = 0;
+    if (connection.close) {
+        socket->disconnectFromHost();
+        return;
+    }
+    serveNext(socket);
+}
+
+/**
+ * @brief Genera la respuesta completa (cabeceras y cuerpo) a una petición.
+ *
+ * - 405 para métodos distintos de GET y HEAD; 404 si la ruta no es un fichero de
+ *   m_root; 503 con probabilidad errorRate.
+ * - Range "bytes=a-b" o "bytes=a-" responde 206 con Content-Range, salvo que If-Range
+ *   no coincida con el ETag, en cuyo caso se envía el fichero entero (200). Un inicio
+ *   fuera del fichero responde 416.
+ *
+ * @param head Línea de petición y cabeceras, sin la línea en blanco final.
+ * @param close Recibe si la conexión debe cerrarse tras la respuesta.
+ */
+QByteArray HttpStandIn::respond(const QByteArray& head, bool* close)
+{
+    const QList<QByteArray> lines = head.split('\n');
+    const QList<QByteArray> request = lines.value(0).trimmed().split(' ');
+    const QByteArray method = request.value(0);
+    const QByteArray target = request.value(1);
+
+    QHash<QByteArray, QByteArray> fields;
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray& line = lines.at(i);
+        const int colon = line.indexOf(':');
+        if (colon > 0) fields.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+    }
+    *close = request.value(2) != "HTTP/1.1" || fields.value("connection").toLower() == "close";
+
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_counters.requests;
+    }
+
+    if (method != "GET" && method != "HEAD")
+        return header(405, "Method Not Allowed", 0, *close, {{"Allow", "GET, HEAD"}});
+
+    if (m_options.errorRate > 0 && m_random.generateDouble() < m_options.errorRate) {
+        QMutexLocker locker(&m_mutex);
+        ++m_counters.errors;
+        return header(503, "Service Unavailable", 0, *close);
+    }
+
+    const QString path = QDir::cleanPath(QUrl::fromPercentEncoding(target.left(target.indexOf('?'))));
+    const QFileInfo info(m_root + path);
+    if (!path.startsWith('/') || path.startsWith("/..") || !info.isFile())
+        return header(404, "Not Found", 0, *close);
+
+    const qint64 size = info.size();
+    const QByteArray etag = '"' + QByteArray::number(size) + '-'
+                            + QByteArray::number(info.lastModified().toMSecsSinceEpoch()) + '"';
+    Fields extra{{"Content-Type", "application/octet-stream"},
+                 {"Accept-Ranges", "bytes"},
+                 {"ETag", etag}};
+
+    qint64 begin = 0;
+    qint64 end = size - 1;
+    int code = 200;
+    const QByteArray range = fields.value("range");
+    const QByteArray ifRange = fields.value("if-range");
+    if (range.startsWith("bytes=") && (ifRange.isEmpty() || ifRange == etag)) {
+        const QList<QByteArray> bounds = range.mid(6).split('-');
+        bool ok = false;
+        const qint64 first = bounds.value(0).trimmed().toLongLong(&ok);
+        if (!ok || first < 0 || first >= size) {
+            extra.append({"Content-Range", "bytes */" + QByteArray::number(size)});
+            return header(416, "Range Not Satisfiable", 0, *close, extra);
+        }
+        const QByteArray last = bounds.value(1).trimmed();
+        begin = first;
+        if (!last.isEmpty()) end = qMin(end, last.toLongLong());
+        code = 206;
+        extra.append({"Content-Range", "bytes " + QByteArray::number(begin) + '-'
+                                           + QByteArray::number(end) + '/'
+                                           + QByteArray::number(size)});
+    }
+
+    const qint64 length = qMax<qint64>(0, end - begin + 1);
+    QByteArray response = header(code, code == 206 ? "Partial Content" : "OK", length, *close, extra);
+    if (method == "GET" && length > 0) {
+        QFile file(info.filePath());
+        if (!file.open(QIODevice::ReadOnly) || !file.seek(begin))
+            return header(500, "Internal Server Error", 0, *close);
+        response += file.read(length);
+
+        QMutexLocker locker(&m_mutex);
+        m_counters.bytesSent += length;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (code == 206) ++m_counters.rangeRequests;
+    return response;
+}
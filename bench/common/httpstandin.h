@@ -0,0 +1,85 @@
+#ifndef HTTPSTANDIN_H
+#define HTTPSTANDIN_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QRandomGenerator>
+#include <QString>
+#include <QThread>
+#include <QUrl>
+
+class QTcpServer;
+class QTcpSocket;
+
+// Servidor HTTP/1.1 mínimo que sirve un directorio en 127.0.0.1 desde su propio hilo,
+// para medir DownloadEngine sin depender de la red. Admite GET y HEAD, conexiones
+// persistentes, Range (206/416) e If-Range con un ETag fuerte, y simula latencia por
+// petición, un ancho de banda por conexión, errores 503 y un máximo de conexiones.
+class HttpStandIn
+{
+public:
+    struct Options {
+        int latencyMs = 0;         // espera antes de cada respuesta
+        qint64 bytesPerSecond = 0; // por conexión; 0 = sin límite
+        double errorRate = 0;      // fracción de peticiones que reciben 503
+        int maxConnections = 0;    // conexiones aceptadas a la vez; 0 = sin límite
+        quint32 seed = 1;          // errores reproducibles entre ejecuciones
+    };
+
+    struct Counters {
+        int requests = 0;
+        int rangeRequests = 0;     // respondidas con 206
+        int errors = 0;            // 503 simulados
+        int connections = 0;       // aceptadas en total
+        int peakConnections = 0;
+        qint64 bytesSent = 0;      // solo cuerpos
+    };
+
+    explicit HttpStandIn(const QString& root, const Options& options = Options());
+    ~HttpStandIn();
+
+    HttpStandIn(const HttpStandIn&) = delete;
+    HttpStandIn& operator=(const HttpStandIn&) = delete;
+
+    bool listen(); // puerto libre en 127.0.0.1
+    quint16 port() const { return m_port; }
+    QUrl url(const QString& relativePath) const;
+
+    Counters counters() const;
+    void resetCounters();
+
+private:
+    enum Phase { Idle, Waiting, Sending };
+
+    struct Connection {
+        QByteArray input;
+        QByteArray output;   // respuesta en curso
+        int written = 0;     // bytes de output ya entregados al socket
+        Phase phase = Idle;
+        bool pacing = false; // hay un tick de ancho de banda programado
+        bool close = false;  // Connection: close tras la respuesta
+    };
+
+    static constexpr int PaceIntervalMs = 10;
+
+    // Todo lo que sigue se ejecuta en m_thread
+    void accept();
+    void serveNext(QTcpSocket* socket);
+    void send(QTcpSocket* socket);
+    QByteArray respond(const QByteArray& head, bool* close);
+
+    const QString m_root;
+    const Options m_options;
+    QThread m_thread;
+    QObject* m_context;          // vive en m_thread; padre del servidor
+    QTcpServer* m_server = nullptr;
+    QHash<QTcpSocket*, Connection> m_connections;
+    QRandomGenerator m_random;
+    quint16 m_port = 0;
+
+    mutable QMutex m_mutex;      // protege m_counters
+    Counters m_counters;
+};
+
+#endif // HTTPSTANDIN_H
@@ -0,0 +1,7 @@
+# Escalado de commit() y ConcurrentIdSet con el número de hilos
+include(../common/common.pri)
+
+TARGET = benchcontention
+
+SOURCES += \
+    main.cpp
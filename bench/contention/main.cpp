@@ -0,0 +1,183 @@
+/**
+ * @file main.cpp
+ * @brief Benchmark de contención: rendimiento de los cambios de estado según el
+ * número de hilos que los hacen a la vez.
+ *
+ * Mide, para 1, 2, 4... hasta --max-workers hilos y un total fijo de operaciones:
+ * - commit: PictureManager::setFavoriteMany() de una imagen por llamada, el camino de
+ *   las descargas que terminan a la vez (commit() con flat combining).
+ * - mutex global: la referencia sin combinar, un único QMutex bajo el que cada cambio
+ *   copia el catálogo, lo modifica y publica la nueva versión.
+ * - ConcurrentIdSet: insert() + remove() del conjunto de tareas en curso.
+ * - QSet + QMutex: lo mismo con un solo mutex para todo el conjunto.
+ *
+ * Cada fila da operaciones por segundo; una columna que no crece (o baja) con los
+ * hilos indica que las operaciones se están serializando.
+ *
+ * Uso: benchcontention [--images N] [--ops N] [--max-workers N]
+ */
+
+#include "benchutil.h"
+#include "concurrentidset.h"
+#include "picturedao.h"
+#include "picturemanager.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <memory>
+
+namespace {
+
+/**
+ * @brief Reparte las operaciones 0..ops-1 entre 'workers' hilos y mide el total.
+ * @param op Operación i; se llama desde los hilos del pool.
+ * @return Operaciones por segundo.
+ */
+template <typename Op>
+double throughput(int workers, int ops, const Op& op)
+{
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<QFuture<void>> futures;
+    for (int w = 0; w < workers; ++w) {
+        futures << QtConcurrent::run(&pool, [&op, w, workers, ops]() {
+            for (int i = w; i < ops; i += workers)
+                op(i);
+        });
+    }
+    for (QFuture<void>& future : futures)
+        future.waitForFinished();
+    return ops * 1e9 / qMax<qint64>(1, timer.nsecsElapsed());
+}
+
+// Referencia: un solo mutex para todos los escritores y una copia publicada por cambio
+class GlobalMutexStore
+{
+public:
+    explicit GlobalMutexStore(std::shared_ptr<const PictureStore> store) : m_current(std::move(store)) {}
+
+    void setFavorite(PictureId id, bool favorite)
+    {
+        QMutexLocker locker(&m_mutex);
+        const int row = m_current->rowOf(id);
+        if (row < 0 || m_current->test(PictureStore::Favorite, row) == favorite) return;
+        PictureStore next = *m_current;
+        next.setFlag(PictureStore::Favorite, row, favorite);
+        m_current = std::make_shared<const PictureStore>(std::move(next));
+    }
+
+private:
+    QMutex m_mutex;
+    std::shared_ptr<const PictureStore> m_current;
+};
+
+// Referencia: conjunto de ids protegido por un único mutex
+class LockedIdSet
+{
+public:
+    bool insert(PictureId id)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_ids.contains(id)) return false;
+        m_ids.insert(id);
+        return true;
+    }
+
+    void remove(PictureId id)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_ids.remove(id);
+    }
+
+private:
+    QMutex m_mutex;
+    QSet<PictureId> m_ids;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("benchcontention");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Escalado de los cambios de estado con el numero de hilos");
+    parser.addHelpOption();
+    const QCommandLineOption imagesOption("images", "Imagenes del catalogo.", "N", "100000");
+    const QCommandLineOption opsOption("ops", "Operaciones por medicion (como mucho --images).",
+                                       "N", "20000");
+    const QCommandLineOption workersOption("max-workers", "Maximo de hilos.", "N",
+                                           QString::number(2 * QThread::idealThreadCount()));
+    parser.addOptions({imagesOption, opsOption, workersOption});
+    parser.process(app);
+
+    const int images = parser.value(imagesOption).toInt();
+    const int ops = qMin(images, parser.value(opsOption).toInt());
+    const int maxWorkers = qMax(1, parser.value(workersOption).toInt());
+
+    QTemporaryDir dir;
+    const QString catalog = dir.filePath("download.json");
+    const QList<Picture> pictures = Bench::syntheticPictures(images, [](int i) {
+        return "images/" + Bench::fileName(i);
+    });
+    if (!dir.isValid() || !PictureDAO::savePictures(pictures, catalog)) return 1;
+
+    PictureManager manager;
+    manager.setBasePath(dir.path());
+    if (!manager.loadCatalog(catalog)) return 1;
+
+    QVector<PictureId> ids;
+    ids.reserve(images);
+    for (PictureRef picture : manager.toDownload())
+        ids.append(picture.id());
+
+    GlobalMutexStore reference(manager.snapshot());
+    ConcurrentIdSet striped;
+    LockedIdSet locked;
+
+    QTextStream& out = Bench::out();
+    out << "Contencion: catalogo de " << images << " imagenes, " << ops
+        << " operaciones por medicion, " << QThread::idealThreadCount() << " nucleos\n\n";
+    out.setFieldAlignment(QTextStream::AlignLeft);
+    out << "hilos  commit op/s   mutex global op/s  ConcurrentIdSet op/s  QSet+QMutex op/s\n";
+
+    // Cada medición alterna el valor de favorito para que todos los cambios sean reales
+    bool favorite = true;
+    for (int workers = 1; workers <= maxWorkers; workers *= 2) {
+        const double committed = throughput(workers, ops, [&](int i) {
+            manager.setFavoriteMany(QVector<PictureId>{ids.at(i)}, favorite);
+        });
+        const double serialized = throughput(workers, ops, [&](int i) {
+            reference.setFavorite(ids.at(i), favorite);
+        });
+        const double stripedRate = throughput(workers, ops, [&](int i) {
+            if (striped.insert(ids.at(i))) striped.remove(ids.at(i));
+        });
+        const double lockedRate = throughput(workers, ops, [&](int i) {
+            if (locked.insert(ids.at(i))) locked.remove(ids.at(i));
+        });
+        favorite = !favorite;
+
+        out << qSetFieldWidth(7) << workers
+            << qSetFieldWidth(14) << QString::number(committed, 'f', 0)
+            << qSetFieldWidth(19) << QString::number(serialized, 'f', 0)
+            << qSetFieldWidth(22) << QString::number(stripedRate, 'f', 0)
+            << qSetFieldWidth(0) << QString::number(lockedRate, 'f', 0) << "\n";
+        out.flush();
+    }
+    return 0;
+}
@@ -0,0 +1,7 @@
+# "Download All" de extremo a extremo contra el servidor local HttpStandIn
+include(../common/common.pri)
+
+TARGET = benchdownload
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,171 @@
+/**
+ * @file main.cpp
+ * @brief Benchmark de "Download All" de extremo a extremo.
+ *
+ * Genera N imágenes sintéticas, las sirve con HttpStandIn en 127.0.0.1 bajo las
+ * condiciones de red indicadas y las descarga todas con PictureManager::downloadMany(),
+ * el mismo camino que el botón "Download All". Cada ejecución usa un directorio base
+ * nuevo (sin .part ni descargas previas) e informa de imágenes/s, MB/s y p50/p99 de
+ * la latencia por imagen según DownloadStats, además de los contadores del servidor.
+ *
+ * --segmented compara la descarga en segmentos paralelos con Range (on) con la de un
+ * solo flujo por imagen (off). Solo se segmentan los ficheros que superan
+ * DownloadEngine::SegmentThreshold, y la ventaja aparece cuando el límite es por
+ * conexión, p. ej.: --images 20 --size 16384 --bandwidth 2048 --latency 50
+ *
+ * Uso:
+ *   benchdownload [--images N] [--size KiB] [--latency ms] [--bandwidth KiB/s]
+ *                 [--error-rate f] [--max-connections n] [--concurrency n]
+ *                 [--segmented on|off|both] [--runs n]
+ */
+
+#include "benchutil.h"
+#include "httpstandin.h"
+#include "picturedao.h"
+#include "picturemanager.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QEventLoop>
+#include <QTemporaryDir>
+
+namespace {
+
+/**
+ * @brief Descarga todo el catálogo de basePath con un PictureManager nuevo.
+ * @return Las estadísticas de DownloadEngine; completed + failed cubre todo el catálogo.
+ */
+DownloadStats::Summary downloadAll(const QString& basePath, int concurrency, bool segmented)
+{
+    PictureManager manager;
+    manager.setBasePath(basePath);
+    if (!manager.loadCatalog(QDir(basePath).filePath("download.json"))) {
+        qWarning() << "No se pudo cargar el catalogo de" << basePath;
+        return DownloadStats::Summary();
+    }
+    if (concurrency > 0) manager.setMaxConcurrentDownloads(concurrency);
+    manager.setSegmentedDownloads(segmented);
+
+    QVector<PictureId> ids;
+    for (PictureRef picture : manager.toDownload())
+        ids.append(picture.id());
+
+    int remaining = ids.size();
+    QEventLoop loop;
+    auto finished = [&](int count) {
+        remaining -= count;
+        if (remaining <= 0) loop.quit();
+    };
+    QObject::connect(&manager, &PictureManager::pictureDownloaded, &loop,
+                     [&](PictureId) { finished(1); });
+    QObject::connect(&manager, &PictureManager::picturesDownloaded, &loop,
+                     [&](const QVector<PictureId>& done) { finished(done.size()); });
+    QObject::connect(&manager, &PictureManager::downloadFailed, &loop,
+                     [&](PictureId, const QString&) { finished(1); });
+
+    manager.resetDownloadStats();
+    manager.downloadMany(ids);
+    if (remaining > 0) loop.exec();
+    return manager.downloadStats();
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("benchdownload");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Download All contra un servidor HTTP local");
+    parser.addHelpOption();
+    const QCommandLineOption imagesOption("images", "Imagenes del catalogo.", "N", "500");
+    const QCommandLineOption sizeOption("size", "Tamano de cada imagen en KiB.", "KiB", "256");
+    const QCommandLineOption latencyOption("latency", "Latencia por peticion.", "ms", "20");
+    const QCommandLineOption bandwidthOption("bandwidth", "Ancho de banda por conexion (0 = sin limite).",
+                                             "KiB/s", "0");
+    const QCommandLineOption errorOption("error-rate", "Fraccion de peticiones con 503.", "f", "0");
+    const QCommandLineOption connectionsOption("max-connections",
+                                               "Conexiones simultaneas del servidor (0 = sin limite).",
+                                               "n", "0");
+    const QCommandLineOption concurrencyOption("concurrency",
+                                               "Descargas masivas simultaneas (0 = la de DownloadEngine).",
+                                               "n", "0");
+    const QCommandLineOption segmentedOption("segmented",
+                                             "Descargas segmentadas: on, off o both (compara ambas).",
+                                             "modo", "both");
+    const QCommandLineOption runsOption("runs", "Repeticiones.", "n", "3");
+    parser.addOptions({imagesOption, sizeOption, latencyOption, bandwidthOption, errorOption,
+                       connectionsOption, concurrencyOption, segmentedOption, runsOption});
+    parser.process(app);
+
+    const int images = parser.value(imagesOption).toInt();
+    const qint64 size = parser.value(sizeOption).toLongLong() * 1024;
+    const int concurrency = parser.value(concurrencyOption).toInt();
+    const int runs = parser.value(runsOption).toInt();
+
+    const QString segmented = parser.value(segmentedOption);
+    QVector<bool> modes;
+    if (segmented == "on" || segmented == "both") modes << true;
+    if (segmented == "off" || segmented == "both") modes << false;
+    if (modes.isEmpty()) {
+        qWarning() << "Valor de --segmented no valido:" << segmented;
+        return 2;
+    }
+
+    HttpStandIn::Options options;
+    options.latencyMs = parser.value(latencyOption).toInt();
+    options.bytesPerSecond = parser.value(bandwidthOption).toLongLong() * 1024;
+    options.errorRate = parser.value(errorOption).toDouble();
+    options.maxConnections = parser.value(connectionsOption).toInt();
+
+    QTemporaryDir dir;
+    const QString origin = dir.filePath("origin");
+    if (!dir.isValid() || !Bench::writeFiles(origin, images, size)) return 1;
+
+    HttpStandIn server(origin, options);
+    if (!server.listen()) return 1;
+
+    QTextStream& out = Bench::out();
+    out << "Download All: " << images << " imagenes de " << size / 1024 << " KiB, latencia "
+        << options.latencyMs << " ms, ancho de banda "
+        << (options.bytesPerSecond ? QString::number(options.bytesPerSecond / 1024) + " KiB/s"
+                                   : QString("sin limite"))
+        << ", errores " << options.errorRate << ", conexiones "
+        << (options.maxConnections ? QString::number(options.maxConnections) : QString("sin limite"))
+        << "\n\n";
+    out.setFieldAlignment(QTextStream::AlignLeft);
+    out << "run  modo   ok     fallos  img/s    MB/s     p50 ms  p99 ms  peticiones  rangos  conexiones(pico)\n";
+
+    const QList<Picture> catalog = Bench::syntheticPictures(images, [&](int i) {
+        return server.url(Bench::fileName(i)).toString();
+    });
+
+    for (int run = 0; run < runs; ++run) {
+        for (bool mode : modes) {
+            const QString base = dir.filePath(QString("run%1-%2").arg(run).arg(mode ? "on" : "off"));
+            if (!QDir().mkpath(base + "/images")
+                || !PictureDAO::savePictures(catalog, QDir(base).filePath("download.json"))) {
+                qWarning() << "No se pudo preparar" << base;
+                return 1;
+            }
+
+            server.resetCounters();
+            const DownloadStats::Summary stats = downloadAll(base, concurrency, mode);
+            const HttpStandIn::Counters counters = server.counters();
+
+            out << qSetFieldWidth(5) << run
+                << qSetFieldWidth(7) << (mode ? "on" : "off") << stats.completed
+                << qSetFieldWidth(8) << stats.failed
+                << qSetFieldWidth(9) << QString::number(stats.itemsPerSecond, 'f', 1)
+                << QString::number(stats.megabytesPerSecond, 'f', 1)
+                << qSetFieldWidth(8) << stats.p50Ms << stats.p99Ms
+                << qSetFieldWidth(12) << counters.requests
+                << qSetFieldWidth(8) << counters.rangeRequests
+                << qSetFieldWidth(0) << counters.connections << " (" << counters.peakConnections << ")\n";
+            out.flush();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file main.cpp
+ * @brief Benchmark de arranque: tiempo hasta las primeras filas y pico de memoria de
+ * SuiteCore solo con QtCore frente a la misma carga con QtGui.
+ *
+ * Desde que SuiteCore no usa QtGui, un servicio o un cron puede cargar el catálogo con
+ * un QCoreApplication. Antes había que enlazar QtGui y crear un QGuiApplication (con
+ * su plugin de plataforma) aunque no se mostrara nada. Las dos variantes son dos
+ * ejecutables compilados desde este fichero:
+ * - core: benchstartup, solo QtCore (QT -= gui), como SuiteCore ahora;
+ * - gui: benchstartupgui, con QtGui enlazado y un QGuiApplication, como antes.
+ *
+ * Cada medición es un proceso hijo nuevo que carga el mismo catálogo sintético con
+ * PictureManager::loadAsync(), el camino de SuiteUI. Desde el padre se mide el tiempo
+ * de reloj desde que se lanza el proceso (incluida la carga de bibliotecas) hasta que
+ * el hijo recibe firstRowsLoaded() y hasta que termina la carga; el hijo informa de su
+ * pico de memoria (VmHWM, solo Linux). Antes de cada ejecución se borra la instantánea
+ * binaria, para que todas analicen el JSON.
+ *
+ * La variante gui usa el plugin de plataforma de --platform (por defecto offscreen,
+ * que no necesita pantalla).
+ *
+ * Uso: benchstartup [--images N] [--variants core,gui] [--runs n] [--platform nombre]
+ *                   [--gui-binary ruta]
+ */
+
+#include "benchutil.h"
+#include "catalogsnapshot.h"
+#include "picturemanager.h"
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QVector>
+
+#ifdef BENCH_WITH_GUI
+#include <QGuiApplication>
+using BenchApplication = QGuiApplication;
+#else
+#include <QCoreApplication>
+using BenchApplication = QCoreApplication;
+#endif
+
+namespace {
+
+/**
+ * @brief Proceso hijo: carga el catálogo de 'dir' de forma asíncrona.
+ *
+ * Escribe "first" al recibir las primeras filas y, al terminar, "<imágenes> <pico KiB>".
+ */
+int runChild(BenchApplication& app, const QString& dir)
+{
+    PictureManager manager;
+    manager.setBasePath(dir);
+
+    int rows = 0;
+    QObject::connect(&manager, &PictureManager::picturesLoaded, &app,
+                     [&rows](const QList<Picture>& batch) { rows += batch.size(); });
+    QObject::connect(&manager, &PictureManager::firstRowsLoaded, &app, [](qint64) {
+        Bench::out() << "first\n";
+        Bench::out().flush();
+    });
+    QObject::connect(&manager, &PictureManager::loadFinished, &app, [&](bool ok) {
+        Bench::out() << rows << ' ' << Bench::peakMemoryKb() << '\n';
+        Bench::out().flush();
+        app.exit(ok ? 0 : 1);
+    });
+
+    manager.loadAsync(QDir(dir).filePath("download.json"), manager.getDownloadedJsonPath());
+    return app.exec();
+}
+
+#ifndef BENCH_WITH_GUI
+struct Result {
+    bool ok = false;
+    qint64 firstMs = 0;
+    qint64 totalMs = 0;
+    qint64 peakKb = -1;
+    int count = 0;
+};
+
+/**
+ * @brief Lanza un proceso hijo y mide desde el padre hasta las primeras filas y el final.
+ */
+Result measure(const QString& program, const QString& dir, const QString& platform)
+{
+    QProcess child;
+    child.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("QT_QPA_PLATFORM", platform);
+    child.setProcessEnvironment(environment);
+
+    Result result;
+    QElapsedTimer timer;
+    timer.start();
+    child.start(program, {"--child", dir});
+    if (!child.waitForStarted(-1)) return result;
+
+    while (!child.canReadLine()) {
+        if (!child.waitForReadyRead(-1)) return result;
+    }
+    if (child.readLine().trimmed() != "first") return result;
+    result.firstMs = timer.elapsed();
+
+    if (!child.waitForFinished(-1) || child.exitStatus() != QProcess::NormalExit
+        || child.exitCode() != 0)
+        return result;
+    result.totalMs = timer.elapsed();
+
+    const QList<QByteArray> fields = child.readAllStandardOutput().trimmed().split(' ');
+    result.count = fields.value(0).toInt();
+    result.peakKb = fields.value(1).toLongLong();
+    result.ok = fields.size() == 2;
+    return result;
+}
+
+/**
+ * @brief Ruta de benchstartupgui: la indicada o junto a este ejecutable en el árbol de
+ * compilación (bench/startupgui).
+ */
+QString guiBinary(const QString& requested)
+{
+    if (!requested.isEmpty()) return requested;
+
+    const QString appDir = QCoreApplication::applicationDirPath();
+    const QStringList dirs = {
+        appDir,
+        appDir + "/../startupgui",
+        appDir + "/../../startupgui/" + QFileInfo(appDir).fileName(), // debug/ o release/
+    };
+    return QStandardPaths::findExecutable("benchstartupgui", dirs);
+}
+#endif
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    BenchApplication app(argc, argv);
+    QCoreApplication::setApplicationName("benchstartup");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Arranque hasta las primeras filas: QtCore frente a QtGui");
+    parser.addHelpOption();
+    const QCommandLineOption imagesOption("images", "Imagenes del catalogo.", "N", "200000");
+    const QCommandLineOption variantsOption("variants", "Variantes a medir.", "v,v...", "core,gui");
+    const QCommandLineOption runsOption("runs", "Repeticiones.", "n", "3");
+    const QCommandLineOption platformOption("platform", "Plugin de plataforma de la variante gui.",
+                                            "nombre", "offscreen");
+    const QCommandLineOption guiOption("gui-binary", "Ruta de benchstartupgui.", "ruta");
+    const QCommandLineOption childOption("child", "Uso interno: carga el catalogo de <directorio>.");
+    parser.addOptions({imagesOption, variantsOption, runsOption, platformOption, guiOption, childOption});
+    parser.process(app);
+
+    if (parser.isSet(childOption))
+        return runChild(app, parser.positionalArguments().value(0));
+
+#ifdef BENCH_WITH_GUI
+    qWarning() << "benchstartupgui solo se usa como proceso hijo de benchstartup";
+    return 2;
+#else
+    const int images = parser.value(imagesOption).toInt();
+    const int runs = qMax(1, parser.value(runsOption).toInt());
+    const QString platform = parser.value(platformOption);
+
+    struct Variant {
+        QString name;
+        QString program;
+    };
+    QVector<Variant> variants;
+    for (const QString& name : parser.value(variantsOption).split(',')) {
+        if (name == "core") {
+            variants.append({name, QCoreApplication::applicationFilePath()});
+        } else if (name == "gui") {
+            const QString program = guiBinary(parser.value(guiOption));
+            if (program.isEmpty()) {
+                qWarning() << "No se encuentra benchstartupgui; indique --gui-binary";
+                return 2;
+            }
+            variants.append({name, program});
+        } else {
+            qWarning() << "Variante desconocida:" << name;
+            return 2;
+        }
+    }
+
+    QTemporaryDir dir;
+    const QString catalog = dir.filePath("download.json");
+    if (images <= 0 || !dir.isValid()
+        || !Bench::writeCatalog(catalog, images, [](int i) { return "images/" + Bench::fileName(i); }))
+        return 1;
+
+    QTextStream& out = Bench::out();
+    out << "Arranque con un catalogo de " << images << " imagenes ("
+        << QString::number(QFileInfo(catalog).size() / (1024.0 * 1024.0), 'f', 1) << " MiB)\n\n";
+    out.setFieldAlignment(QTextStream::AlignLeft);
+    out << "run  variante  primeras filas ms  carga ms  pico MiB\n";
+
+    for (int run = 0; run < runs; ++run) {
+        for (const Variant& variant : qAsConst(variants)) {
+            QFile::remove(CatalogSnapshot::pathFor(catalog));
+            const Result result = measure(variant.program, dir.path(), platform);
+
+            out << qSetFieldWidth(5) << run << qSetFieldWidth(10) << variant.name;
+            if (!result.ok || result.count != images) {
+                out << qSetFieldWidth(0) << "error\n";
+            } else {
+                out << qSetFieldWidth(19) << result.firstMs
+                    << qSetFieldWidth(10) << result.totalMs
+                    << qSetFieldWidth(0)
+                    << (result.peakKb < 0 ? QString("-") : QString::number(result.peakKb / 1024.0, 'f', 1))
+                    << "\n";
+            }
+            out.flush();
+        }
+    }
+    return 0;
+#endif
+}
@@ -0,0 +1,7 @@
+# Arranque hasta las primeras filas y pico de memoria: solo QtCore frente a QtGui
+include(../common/common.pri)
+
+TARGET = benchstartup
+
+SOURCES += \
+    main.cpp
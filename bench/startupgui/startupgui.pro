@@ -0,0 +1,11 @@
+# Variante "gui" de benchstartup: el mismo main.cpp con QtGui enlazado y un
+# QGuiApplication, como necesitaba SuiteCore antes. benchstartup la lanza como hijo.
+include(../common/common.pri)
+
+QT += gui
+DEFINES += BENCH_WITH_GUI
+
+TARGET = benchstartupgui
+
+SOURCES += \
+    ../startup/main.cpp
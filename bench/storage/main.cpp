@@ -0,0 +1,213 @@
+/**
+ * @file main.cpp
+ * @brief Benchmark de persistencia: ficheros JSON (PictureDAO) frente a SQLite
+ * (SqlitePictureDAO).
+ *
+ * Para cada tamaño (por defecto 100 000 y 1 000 000 imágenes, con favoritas,
+ * descargadas y caducidades) mide con los dos almacenes:
+ * - escritura completa del estado;
+ * - carga completa;
+ * - cambio puntual persistido (un favorito): en JSON hay que reescribir el fichero
+ *   entero, en SQLite es un UPDATE por url (applyChanges()); se da la media de --updates;
+ * - consultas filtradas (favoritas, caducan en 30 días, por nombre): en JSON incluyen
+ *   la carga del fichero, que es lo que cuestan sin un índice.
+ *
+ * Después compara los formatos de fichero de PictureSerializer (JSON, CBOR y
+ * QDataStream): guardado y carga del estado completo con PictureDAO y tamaño en disco.
+ *
+ * Uso: benchstorage [--sizes 100000,1000000] [--updates N]
+ */
+
+#include "benchutil.h"
+#include "picturedao.h"
+#include "sqlitepicturedao.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDate>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+/**
+ * @brief Tiempo de f() en milisegundos.
+ */
+template <typename F>
+double timeMs(F&& f)
+{
+    QElapsedTimer timer;
+    timer.start();
+    f();
+    return timer.nsecsElapsed() / 1e6;
+}
+
+/**
+ * @brief Catálogo sintético con estado: 1 de cada 7 favorita y 1 de cada 3 descargada.
+ */
+QList<Picture> statePictures(int count)
+{
+    QList<Picture> pictures = Bench::syntheticPictures(count, [](int i) {
+        return "images/" + Bench::fileName(i);
+    });
+    for (int i = 0; i < pictures.size(); ++i) {
+        Picture& picture = pictures[i];
+        picture.setFavorito(i % 7 == 0);
+        if (i % 3 == 0) {
+            picture.setDescargada(true);
+            picture.setFilePath(picture.url());
+        }
+    }
+    return pictures;
+}
+
+void printRow(int count, const char* operation, double json, double sqlite)
+{
+    QTextStream& out = Bench::out();
+    out << qSetFieldWidth(10) << count
+        << qSetFieldWidth(26) << operation
+        << qSetFieldWidth(12) << QString::number(json, 'f', 2)
+        << qSetFieldWidth(0) << QString::number(sqlite, 'f', 2) << "\n";
+    out.flush();
+}
+
+/**
+ * @brief Guarda y carga 'pictures' en cada formato e imprime tiempos y tamaño.
+ * @return false si algún formato no conserva todas las imágenes.
+ */
+bool compareFormats(const QList<Picture>& pictures, const QString& dir)
+{
+    struct Format {
+        const char* name;
+        PictureSerializer::Format format;
+    };
+    static const Format formats[] = {
+        {"json", PictureSerializer::Json},
+        {"cbor", PictureSerializer::Cbor},
+        {"datastream", PictureSerializer::DataStream},
+    };
+
+    QTextStream& out = Bench::out();
+    for (const Format& format : formats) {
+        const QString path = QDir(dir).filePath(QString("state_%1.%2").arg(pictures.size()).arg(format.name));
+        bool saved = false;
+        const double save = timeMs([&]() {
+            saved = format.format == PictureSerializer::Json
+                        ? PictureDAO::savePictures(pictures, path)
+                        : PictureDAO::exportPictures(pictures, path, format.format);
+        });
+        int loaded = 0;
+        const double load = timeMs([&]() { loaded = PictureDAO::loadPictures(path).size(); });
+        if (!saved || loaded != pictures.size()) return false;
+
+        out << qSetFieldWidth(10) << pictures.size()
+            << qSetFieldWidth(12) << format.name
+            << QString::number(save, 'f', 2) << QString::number(load, 'f', 2)
+            << qSetFieldWidth(0) << QString::number(QFileInfo(path).size() / (1024.0 * 1024.0), 'f', 1)
+            << "\n";
+        out.flush();
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("benchstorage");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Persistencia del estado: JSON frente a SQLite");
+    parser.addHelpOption();
+    const QCommandLineOption sizesOption("sizes", "Imagenes de cada prueba.", "N,N...",
+                                         "100000,1000000");
+    const QCommandLineOption updatesOption("updates", "Cambios puntuales por prueba.", "N", "5");
+    parser.addOptions({sizesOption, updatesOption});
+    parser.process(app);
+
+    const int updates = qMax(1, parser.value(updatesOption).toInt());
+
+    QTemporaryDir dir;
+    if (!dir.isValid()) return 1;
+
+    QTextStream& out = Bench::out();
+    out.setFieldAlignment(QTextStream::AlignLeft);
+    out << "imagenes  operacion                 JSON ms     SQLite ms\n";
+
+    for (const QString& size : parser.value(sizesOption).split(',')) {
+        const int count = size.toInt();
+        QList<Picture> pictures = statePictures(count);
+        const QString jsonPath = dir.filePath(QString("state_%1.json").arg(count));
+        SqlitePictureDAO sqlite(dir.filePath(QString("state_%1.db").arg(count)));
+        if (count <= 0 || !sqlite.open()) return 1;
+
+        bool saved = true;
+        printRow(count, "escritura completa",
+                 timeMs([&]() { saved &= PictureDAO::savePictures(pictures, jsonPath); }),
+                 timeMs([&]() { saved &= sqlite.savePictures(pictures); }));
+        if (!saved) return 1;
+
+        int loaded = 0;
+        printRow(count, "carga",
+                 timeMs([&]() { loaded += PictureDAO::loadPictures(jsonPath).size(); }),
+                 timeMs([&]() { loaded += sqlite.loadAll().size(); }));
+        if (loaded != 2 * count) return 1;
+
+        // Cambios puntuales repartidos por el catálogo
+        double json = 0;
+        double sql = 0;
+        for (int u = 0; u < updates; ++u) {
+            Picture& picture = pictures[int(qint64(count) * u / updates)];
+            picture.setFavorito(!picture.favorito());
+
+            StateJournal::Record record;
+            record.type = StateJournal::Favorite;
+            record.url = picture.url();
+            record.favorito = picture.favorito();
+
+            json += timeMs([&]() { PictureDAO::savePictures(pictures, jsonPath); });
+            sql += timeMs([&]() { sqlite.applyChanges({record}); });
+        }
+        printRow(count, "cambio puntual (media)", json / updates, sql / updates);
+
+        printRow(count, "favoritas",
+                 timeMs([&]() {
+                     const QList<Picture> all = PictureDAO::loadPictures(jsonPath);
+                     QList<Picture> result;
+                     std::copy_if(all.begin(), all.end(), std::back_inserter(result),
+                                  [](const Picture& p) { return p.favorito(); });
+                 }),
+                 timeMs([&]() { sqlite.favorites(); }));
+
+        const QDate limit = QDate::currentDate().addDays(30);
+        printRow(count, "caducan en 30 dias",
+                 timeMs([&]() {
+                     const QList<Picture> all = PictureDAO::loadPictures(jsonPath);
+                     QList<Picture> result;
+                     std::copy_if(all.begin(), all.end(), std::back_inserter(result),
+                                  [&](const Picture& p) {
+                                      return p.expirationDate().isValid() && p.expirationDate() < limit;
+                                  });
+                 }),
+                 timeMs([&]() { sqlite.expiringBefore(limit); }));
+
+        const QString name = pictures.at(count / 2).nombre();
+        printRow(count, "por nombre",
+                 timeMs([&]() {
+                     const QList<Picture> all = PictureDAO::loadPictures(jsonPath);
+                     std::find_if(all.begin(), all.end(),
+                                  [&](const Picture& p) { return p.nombre() == name; });
+                 }),
+                 timeMs([&]() { sqlite.findByName(name); }));
+    }
+
+    out << "\nimagenes  formato     guardar ms  cargar ms   MiB\n";
+    for (const QString& size : parser.value(sizesOption).split(',')) {
+        if (!compareFormats(statePictures(size.toInt()), dir.path())) return 1;
+    }
+    return 0;
+}
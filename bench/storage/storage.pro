@@ -0,0 +1,7 @@
+# Persistencia del estado: ficheros JSON frente a SQLite
+include(../common/common.pri)
+
+TARGET = benchstorage
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,179 @@
+/**
+ * @file main.cpp
+ * @brief Benchmark de recorridos: PictureStore (columnas y bitsets) frente a
+ * QList<Picture> (una fila por imagen), el modelo anterior de PictureManager.
+ *
+ * Sobre el mismo catálogo sintético (por defecto 1 000 000 de imágenes) mide:
+ * - contar favoritas;
+ * - listar los ids de las no descargadas (lo que hace "Download All");
+ * - caducan antes de una fecha;
+ * - buscar un texto en la descripción;
+ * - copiar el catálogo y cambiar un favorito (lo que cuesta publicar una versión).
+ *
+ * Cada operación se repite --repeat veces y se da el mejor tiempo. La columna
+ * "resultado" debe coincidir entre los dos modelos.
+ *
+ * Uso: benchstore [--images N] [--repeat N]
+ */
+
+#include "benchutil.h"
+#include "picturestore.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDate>
+#include <QElapsedTimer>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace {
+
+struct Timing {
+    double bestMs = 0;
+    qint64 result = 0;
+};
+
+/**
+ * @brief Mejor tiempo de 'repeat' ejecuciones de f(), que devuelve su resultado.
+ */
+Timing best(int repeat, const std::function<qint64()>& f)
+{
+    Timing timing;
+    for (int r = 0; r < repeat; ++r) {
+        QElapsedTimer timer;
+        timer.start();
+        timing.result = f();
+        const double ms = timer.nsecsElapsed() / 1e6;
+        if (r == 0 || ms < timing.bestMs) timing.bestMs = ms;
+    }
+    return timing;
+}
+
+void printRow(const char* operation, const Timing& rows, const Timing& columns)
+{
+    QTextStream& out = Bench::out();
+    out << qSetFieldWidth(34) << operation
+        << qSetFieldWidth(14) << QString::number(rows.bestMs, 'f', 2)
+        << QString::number(columns.bestMs, 'f', 2)
+        << qSetFieldWidth(0) << rows.result;
+    if (rows.result != columns.result) out << " (columnas: " << columns.result << ")";
+    out << "\n";
+    out.flush();
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("benchstore");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Recorridos: PictureStore frente a QList<Picture>");
+    parser.addHelpOption();
+    const QCommandLineOption imagesOption("images", "Imagenes del catalogo.", "N", "1000000");
+    const QCommandLineOption repeatOption("repeat", "Repeticiones de cada operacion.", "N", "5");
+    parser.addOptions({imagesOption, repeatOption});
+    parser.process(app);
+
+    const int images = parser.value(imagesOption).toInt();
+    const int repeat = qMax(1, parser.value(repeatOption).toInt());
+    if (images <= 0) return 1;
+
+    QList<Picture> list = Bench::syntheticPictures(images, [](int i) {
+        return "images/" + Bench::fileName(i);
+    });
+    for (int i = 0; i < list.size(); ++i) {
+        list[i].setId(PictureId(i + 1));
+        list[i].setFavorito(i % 7 == 0);
+        list[i].setDescargada(i % 3 == 0);
+    }
+    PictureStore columns;
+    columns.append(list);
+    const auto store = std::make_shared<const PictureStore>(std::move(columns));
+
+    QTextStream& out = Bench::out();
+    out << "Catalogo de " << images << " imagenes, mejor de " << repeat << "\n\n";
+    out.setFieldAlignment(QTextStream::AlignLeft);
+    out << "operacion                         filas ms      columnas ms   resultado\n";
+
+    printRow("contar favoritas",
+             best(repeat, [&]() {
+                 qint64 n = 0;
+                 for (const Picture& p : list)
+                     n += p.favorito();
+                 return n;
+             }),
+             best(repeat, [&]() {
+                 qint64 n = 0;
+                 for (int w = 0; w < store->wordCount(); ++w)
+                     n += qPopulationCount(store->word(PictureStore::Favorite, true, w));
+                 return n;
+             }));
+
+    printRow("ids no descargadas",
+             best(repeat, [&]() {
+                 QVector<PictureId> ids;
+                 for (const Picture& p : list)
+                     if (!p.descargada()) ids.append(p.id());
+                 return qint64(ids.size());
+             }),
+             best(repeat, [&]() {
+                 QVector<PictureId> ids;
+                 ids.reserve(store->size() - store->count(PictureStore::Downloaded));
+                 for (PictureRef p : PictureView(store, PictureStore::Downloaded, false))
+                     ids.append(p.id());
+                 return qint64(ids.size());
+             }));
+
+    const QDate limit = QDate::currentDate().addDays(30);
+    printRow("caducan en 30 dias",
+             best(repeat, [&]() {
+                 qint64 n = 0;
+                 for (const Picture& p : list) {
+                     const QDate date = p.expirationDate();
+                     n += date.isValid() && date < limit;
+                 }
+                 return n;
+             }),
+             best(repeat, [&]() {
+                 const qint32 day = qint32(limit.toJulianDay());
+                 qint64 n = 0;
+                 for (int row = 0; row < store->size(); ++row) {
+                     const qint32 expiration = store->expirationDay(row);
+                     n += expiration != PictureStore::NoDate && expiration < day;
+                 }
+                 return n;
+             }));
+
+    const QString needle = "noche";
+    printRow("descripcion contiene \"noche\"",
+             best(repeat, [&]() {
+                 qint64 n = 0;
+                 for (const Picture& p : list)
+                     n += p.descripcion().contains(needle, Qt::CaseInsensitive);
+                 return n;
+             }),
+             best(repeat, [&]() {
+                 qint64 n = 0;
+                 for (int row = 0; row < store->size(); ++row)
+                     n += store->descripcion(row).contains(needle, Qt::CaseInsensitive);
+                 return n;
+             }));
+
+    int row = 0;
+    printRow("copiar y cambiar un favorito",
+             best(repeat, [&]() {
+                 QList<Picture> next = list;
+                 next[row].setFavorito(!next[row].favorito());
+                 row = (row + 7919) % images;
+                 return qint64(next.size());
+             }),
+             best(repeat, [&]() {
+                 PictureStore next = *store;
+                 next.setFlag(PictureStore::Favorite, row, !next.test(PictureStore::Favorite, row));
+                 row = (row + 7919) % images;
+                 return qint64(next.size());
+             }));
+    return 0;
+}
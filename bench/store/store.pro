@@ -0,0 +1,7 @@
+# Recorridos y filtros: PictureStore (columnas) frente a QList<Picture> (filas)
+include(../common/common.pri)
+
+TARGET = benchstore
+
+SOURCES += \
+    main.cpp